@@ -0,0 +1,287 @@
+#!/usr/bin/perl
+
+#
+# bench - simulator throughput benchmarks with golden stats
+#
+
+# SimpleScalar(TM) Tool Suite
+# Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+# All Rights Reserved. 
+#
+# THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+# YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+#
+# No portion of this work may be used by any commercial entity, or for any
+# commercial purpose, without the prior, written permission of SimpleScalar,
+# LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+# as described below.
+#
+# 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+# or implied. The user of the program accepts full responsibility for the
+# application of the program and the use of any results.
+#
+# 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+# downloaded, compiled, executed, copied, and modified solely for nonprofit,
+# educational, noncommercial research, and noncommercial scholarship
+# purposes provided that this notice in its entirety accompanies all copies.
+# Copies of the modified software can be delivered to persons who use it
+# solely for nonprofit, educational, noncommercial research, and
+# noncommercial scholarship purposes provided that this notice in its
+# entirety accompanies all copies.
+#
+# 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+# PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+#
+# 4. No nonprofit user may place any restrictions on the use of this software,
+# including as modified by the user, by any other authorized user.
+#
+# 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+# in compiled or executable form as set forth in Section 2, provided that
+# either: (A) it is accompanied by the corresponding machine-readable source
+# code, or (B) it is accompanied by a written offer, with no time limit, to
+# give anyone a machine-readable copy of the corresponding source code in
+# return for reimbursement of the cost of distribution. This written offer
+# must permit verbatim duplication by anyone, or (C) it is distributed by
+# someone who received only the executable form, and is accompanied by a
+# copy of the written offer of source code.
+#
+# 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+# currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+# 2395 Timbercrest Court, Ann Arbor, MI 48105.
+#
+# Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+#
+
+use Time::HiRes qw(time);
+
+#
+# config parms
+#
+
+# simulator configurations: name, simulator binary and options
+@configs = (
+  [ "sim-fast",		"sim-fast",		"" ],
+  [ "sim-cache",	"sim-cache",		"" ],
+  [ "sim-bpred",	"sim-bpred",		"" ],
+  [ "outorder-1t",	"sim-outorder-1t",	"" ],
+  [ "outorder-eager",	"sim-outorder",		"-max:threads 2" ],
+);
+
+# benchmark programs: name, arguments and standard input
+@programs = (
+  [ "anagram",		"bin/anagram inputs/words",	"inputs/input.txt" ],
+  [ "test-math",	"bin/test-math",		"" ],
+  [ "test-printf",	"bin/test-printf",		"" ],
+  [ "test-fmath",	"bin/test-fmath",		"" ],
+  [ "test-llong",	"bin/test-llong",		"" ],
+  [ "test-lswlr",	"bin/test-lswlr",		"" ],
+);
+
+# golden stats kept for each simulator
+%golden_stats = (
+  "sim-fast"	=> [ "sim_num_insn" ],
+  "sim-cache"	=> [ "sim_num_insn", "il1.miss_rate", "dl1.miss_rate",
+		     "ul2.miss_rate" ],
+  "sim-bpred"	=> [ "sim_num_insn", "bpred_bimod.bpred_dir_rate" ],
+  "sim-outorder-1t" => [ "sim_num_insn", "sim_commit_digest", "sim_cycle",
+			 "sim_IPC", "il1.miss_rate", "dl1.miss_rate",
+			 "ul2.miss_rate", "bpred_bimod.bpred_dir_rate" ],
+  "sim-outorder" => [ "sim_num_insn", "sim_commit_digest", "sim_cycle",
+		      "sim_IPC", "sim_num_forks", "fork_won", "il1.miss_rate",
+		      "dl1.miss_rate", "ul2.miss_rate",
+		      "bpred_bimod.bpred_dir_rate" ],
+);
+
+#
+# parse commands
+#
+$sim_dir = ".";
+$tests_dir = "tests-alpha";
+$results_file = "bench.results";
+$golden_file = "tests-alpha/outputs/bench.golden";
+$baseline_file = "bench.baseline";
+$threshold = 10;
+$update = 0;
+while (@ARGV)
+  {
+    $arg = shift(@ARGV);
+    if ($arg eq "-sim_dir" && @ARGV) { $sim_dir = shift(@ARGV); }
+    elsif ($arg eq "-tests" && @ARGV) { $tests_dir = shift(@ARGV); }
+    elsif ($arg eq "-o" && @ARGV) { $results_file = shift(@ARGV); }
+    elsif ($arg eq "-g" && @ARGV) { $golden_file = shift(@ARGV); }
+    elsif ($arg eq "-b" && @ARGV) { $baseline_file = shift(@ARGV); }
+    elsif ($arg eq "-t" && @ARGV) { $threshold = shift(@ARGV); }
+    elsif ($arg eq "-update") { $update = 1; }
+    else
+      {
+	print STDERR
+"Usage: bench {-sim_dir <dir>} {-tests <dir>} {-o <results>} {-g <golden>}\n".
+"             {-b <baseline>} {-t <percent>} {-update}\n".
+"\n".
+"         Runs every simulator configuration over the test programs, and\n".
+"         writes host KIPS and key stats to the results file (default:\n".
+"         bench.results).  Any change in a key stat against the golden stats\n".
+"         (default: tests-alpha/outputs/bench.golden) is flagged, as is a\n".
+"         drop in a configuration's host KIPS of more than <percent>\n".
+"         (default: 10) against a baseline results file (default:\n".
+"         bench.baseline, if it exists).  With -update, the golden stats are\n".
+"         rewritten from this run instead.  Exits non-zero if anything was\n".
+"         flagged.\n".
+"\n";
+	exit -1;
+      }
+  }
+
+#
+# run the benchmarks
+#
+$sim_path = ($sim_dir =~ m|^/|) ? $sim_dir : "../$sim_dir";
+$stats_file = "/tmp/bench.$$.csv";
+$flagged = 0;
+@results = ();
+%stats = ();
+foreach $config (@configs)
+  {
+    ($cname, $sim, $opts) = @$config;
+    $insts = 0; $secs = 0;
+    foreach $program (@programs)
+      {
+	($pname, $args, $input) = @$program;
+	# the simulated program gets an empty environment, its instruction
+	# count (and so every stat) depends on the environment's size
+	$cmd = "cd $tests_dir && env -i $sim_path/$sim -redir:prog /dev/null ".
+	  "-redir:sim /dev/null -stats:format csv -stats:out $stats_file ".
+	  "$opts $args".($input ne "" ? " < $input" : "");
+	unlink($stats_file);
+	$start = time;
+	system($cmd);
+	$elapsed = time - $start;
+
+	# pick up the stats
+	open(STATS, $stats_file)
+	  || die "bench: $cname $pname did not write stats ($cmd)\n";
+	%run = ();
+	while (<STATS>)
+	  {
+	    chomp;
+	    @f = split(/,/, $_, 4);
+	    $run{$f[1]} = $f[3] if ($f[0] eq "stat" && $f[2] eq "");
+	  }
+	close(STATS);
+
+	$n = $run{"sim_num_insn"};
+	push(@results, sprintf("run %s %s %s %.3f %.1f", $cname, $pname, $n,
+			       $elapsed, $n / $elapsed / 1000));
+	foreach $stat (@{$golden_stats{$sim}})
+	  {
+	    $stats{"$cname $pname $stat"} = $run{$stat};
+	  }
+	$insts += $n; $secs += $elapsed;
+	printf STDERR "bench: %-16s %-12s %12s insts %8.3fs %10.1f KIPS\n",
+	  $cname, $pname, $n, $elapsed, $n / $elapsed / 1000;
+      }
+    $kips{$cname} = $insts / $secs / 1000;
+    push(@results, sprintf("kips %s %.1f", $cname, $kips{$cname}));
+  }
+unlink($stats_file);
+
+#
+# write the results
+#
+open(RESULTS, ">$results_file")
+  || die "bench: cannot write results file: $results_file\n";
+print RESULTS "# bench results, ".localtime()."\n";
+print RESULTS "# run <config> <program> <insts> <host secs> <host KIPS>\n";
+print RESULTS "# kips <config> <host KIPS over all programs>\n";
+print RESULTS "# stat <config> <program> <stat> <value>\n";
+foreach $line (@results)
+  {
+    print RESULTS "$line\n";
+  }
+foreach $key (sort keys %stats)
+  {
+    print RESULTS "stat $key $stats{$key}\n";
+  }
+close(RESULTS);
+
+#
+# check the golden stats
+#
+if ($update)
+  {
+    open(GOLDEN, ">$golden_file")
+      || die "bench: cannot write golden stats file: $golden_file\n";
+    print GOLDEN "# <config> <program> <stat> <value>\n";
+    foreach $key (sort keys %stats)
+      {
+	print GOLDEN "$key $stats{$key}\n";
+      }
+    close(GOLDEN);
+    print STDERR "bench: golden stats updated in $golden_file\n";
+  }
+else
+  {
+    open(GOLDEN, $golden_file)
+      || die "bench: cannot open golden stats file: $golden_file\n";
+    %golden = ();
+    while (<GOLDEN>)
+      {
+	next if (/^#/);
+	chomp;
+	if (/^(\S+ \S+ \S+) (\S*)$/)
+	  {
+	    $golden{$1} = $2;
+	  }
+      }
+    close(GOLDEN);
+    foreach $key (sort keys %golden)
+      {
+	if (!defined($stats{$key}))
+	  {
+	    print STDERR "bench: STATS CHANGED: $key missing, ".
+	      "golden $golden{$key}\n";
+	    $flagged++;
+	  }
+	elsif ($stats{$key} ne $golden{$key})
+	  {
+	    print STDERR "bench: STATS CHANGED: $key $stats{$key}, ".
+	      "golden $golden{$key}\n";
+	    $flagged++;
+	  }
+      }
+    foreach $key (sort keys %stats)
+      {
+	if (!defined($golden{$key}))
+	  {
+	    print STDERR "bench: STATS CHANGED: $key $stats{$key}, no golden\n";
+	    $flagged++;
+	  }
+      }
+  }
+
+#
+# check throughput against the baseline
+#
+if (open(BASELINE, $baseline_file))
+  {
+    while (<BASELINE>)
+      {
+	if (/^kips (\S+) (\S+)$/ && defined($kips{$1}))
+	  {
+	    $change = ($kips{$1} - $2) / $2 * 100;
+	    printf STDERR "bench: %-16s %10.1f KIPS, baseline %10.1f (%+.1f%%)\n",
+	      $1, $kips{$1}, $2, $change;
+	    if ($change < -$threshold)
+	      {
+		print STDERR "bench: SLOWER: $1 throughput dropped more than ".
+		  "$threshold%\n";
+		$flagged++;
+	      }
+	  }
+      }
+    close(BASELINE);
+  }
+
+print STDERR "bench: results written to $results_file, ".
+  ($flagged ? "$flagged problem(s) flagged\n" : "no problems\n");
+exit($flagged ? 1 : 0);
@@ -62,6 +62,14 @@
 /* turn this on to enable the SimpleScalar 2.0 RAS bug */
 /* #define RAS_BUG_COMPATIBLE */
 
+/* non-zero while looking up or updating on behalf of a mis-speculated path */
+int bpred_wrong_path = FALSE;
+
+/* wrong-path flipped counter table size, and its hash on a counter address */
+#define BPRED_WP_SIZE		1024
+#define BPRED_WP_INDEX(P)						\
+  ((((unsigned long)(P)) ^ (((unsigned long)(P)) >> 10)) & (BPRED_WP_SIZE-1))
+
 /* create a branch predictor */
 struct bpred_t *			/* branch predictory instance */
 bpred_create(enum bpred_class class,	/* type of predictor to create */
@@ -461,6 +469,75 @@ bpred_reg_stats(struct bpred_t *pred,	/* branch predictor instance */
   stat_reg_formula(sdb, buf,
 		   "RAS prediction rate (i.e., RAS hits/used RAS)",
 		   buf1, "%9.4f");
+
+  if (!pred->wp_flipped)
+    return;
+
+  sprintf(buf, "%s.wp_lookups", name);
+  stat_reg_counter(sdb, buf, "lookups by wrong-path branches",
+		   &pred->wp_lookups, 0, NULL);
+  sprintf(buf, "%s.cp_lookups", name);
+  sprintf(buf1, "%s.lookups - %s.wp_lookups", name, name);
+  stat_reg_formula(sdb, buf, "lookups by correct-path branches",
+		   buf1, "%12.0f");
+  sprintf(buf, "%s.wp_updates", name);
+  stat_reg_counter(sdb, buf, "updates by wrong-path branches",
+		   &pred->wp_updates, 0, NULL);
+  sprintf(buf, "%s.wp_dir_flips", name);
+  stat_reg_counter(sdb, buf,
+		   "wrong-path updates that flipped a direction counter",
+		   &pred->wp_dir_flips, 0, NULL);
+  sprintf(buf, "%s.wp_flip_helped", name);
+  stat_reg_counter(sdb, buf,
+		   "correct-path hits on a counter a wrong path flipped",
+		   &pred->wp_flip_helped, 0, NULL);
+  sprintf(buf, "%s.wp_flip_hurt", name);
+  stat_reg_counter(sdb, buf,
+		   "correct-path misses on a counter a wrong path flipped",
+		   &pred->wp_flip_hurt, 0, NULL);
+}
+
+/* keep separate wrong-path stats for predictor PRED, and track the
+   direction counters wrong-path updates change */
+void
+bpred_track_origin(struct bpred_t *pred)	/* branch predictor instance */
+{
+  if (pred->wp_flipped)
+    return;
+
+  pred->wp_flipped = (char **)calloc(BPRED_WP_SIZE, sizeof(char *));
+  if (!pred->wp_flipped)
+    fatal("out of virtual memory");
+}
+
+/* follow direction counter PDIR, predicting OLD_DIR before this update,
+   across a wrong-path update that flips it and the next correct-path update
+   that finds it flipped, CORRECT is non-zero if that update's branch was
+   predicted right */
+static void
+bpred_origin_update(struct bpred_t *pred,	/* branch predictor instance */
+		    char *pdir,			/* direction counter */
+		    int old_dir,		/* its prior prediction */
+		    int correct)		/* branch predicted right? */
+{
+  char **ent = &pred->wp_flipped[BPRED_WP_INDEX(pdir)];
+
+  if (bpred_wrong_path)
+    {
+      if ((*pdir >= 2) != old_dir)
+	{
+	  pred->wp_dir_flips++;
+	  *ent = pdir;
+	}
+    }
+  else if (*ent == pdir)
+    {
+      if (correct)
+	pred->wp_flip_helped++;
+      else
+	pred->wp_flip_hurt++;
+      *ent = NULL;
+    }
 }
 
 void
@@ -572,6 +649,8 @@ bpred_lookup(struct bpred_t *pred,	/* branch predictor instance */
     return 0;
 
   pred->lookups++;
+  if (pred->wp_flipped && bpred_wrong_path)
+    pred->wp_lookups++;
 
   dir_update_ptr->dir.ras = FALSE;
   dir_update_ptr->pdir1 = NULL;
@@ -752,7 +831,7 @@ bpred_update(struct bpred_t *pred,	/* branch predictor instance */
 {
   struct bpred_btb_ent_t *pbtb = NULL;
   struct bpred_btb_ent_t *lruhead = NULL, *lruitem = NULL;
-  int index, i;
+  int index, i, old_dir = 0;
 
   /* don't change bpred state for non-branch instructions or if this
    * is a stateless predictor*/
@@ -761,6 +840,9 @@ bpred_update(struct bpred_t *pred,	/* branch predictor instance */
 
   /* Have a branch here */
 
+  if (pred->wp_flipped && bpred_wrong_path)
+    pred->wp_updates++;
+
   if (correct)
     pred->addr_hits++;
 
@@ -914,6 +996,7 @@ bpred_update(struct bpred_t *pred,	/* branch predictor instance */
   /* update state (but not for jumps) */
   if (dir_update_ptr->pdir1)
     {
+      old_dir = (*dir_update_ptr->pdir1 >= 2);
       if (taken)
 	{
 	  if (*dir_update_ptr->pdir1 < 3)
@@ -926,6 +1009,10 @@ bpred_update(struct bpred_t *pred,	/* branch predictor instance */
 	}
     }
 
+  if (pred->wp_flipped && dir_update_ptr->pdir1)
+    bpred_origin_update(pred, dir_update_ptr->pdir1, old_dir,
+			!!pred_taken == !!taken);
+
   /* combining predictor also updates second predictor and meta predictor */
   /* second direction predictor */
   if (dir_update_ptr->pdir2)
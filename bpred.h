@@ -171,6 +171,18 @@ struct bpred_t {
   counter_t retstack_pops;	/* number of times a value was popped */
   counter_t retstack_pushes;	/* number of times a value was pushed */
   counter_t ras_hits;		/* num correct return-address predictions */
+
+  /* per-origin stats, kept once bpred_track_origin() is called */
+  char **wp_flipped;		/* direction counters last flipped by a
+				   wrong-path update, hashed on address */
+  counter_t wp_lookups;		/* lookups by wrong-path branches */
+  counter_t wp_updates;		/* updates by wrong-path branches */
+  counter_t wp_dir_flips;	/* wrong-path updates that flipped a counter's
+				   predicted direction */
+  counter_t wp_flip_helped;	/* correct-path predictions right after a
+				   wrong-path flip of their counter */
+  counter_t wp_flip_hurt;	/* correct-path mispredictions after a
+				   wrong-path flip of their counter */
 };
 
 /* branch predictor update information */
@@ -208,6 +220,16 @@ bpred_dir_create (
   unsigned int shift_width,	/* history register width */
   unsigned int xor);	   	/* history xor address flag */
 
+/* non-zero while the simulator looks up or updates the predictor on behalf
+   of a mis-speculated (wrong) path, only predictors set up with
+   bpred_track_origin() look at it */
+extern int bpred_wrong_path;
+
+/* keep separate wrong-path stats for predictor PRED, and track the
+   direction counters wrong-path updates change */
+void
+bpred_track_origin(struct bpred_t *pred);	/* branch predictor instance */
+
 /* print branch predictor configuration */
 void
 bpred_config(struct bpred_t *pred,	/* branch predictor instance */
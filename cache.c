@@ -69,6 +69,36 @@
 #define CACHE_MK_BADDR(cp, tag, set)					\
   (((tag) << (cp)->tag_shift)|((set) << (cp)->set_shift))
 
+/* wrong-path victim table index of block address BADDR */
+#define CACHE_WP_INDEX(cp, baddr)					\
+  (((baddr) >> (cp)->set_shift) & ((cp)->wp_nvictims - 1))
+
+/* count a hit on block BLK by its origin, and the first correct-path use of
+   a block brought in by a wrong path */
+#define CACHE_ORIGIN_HIT(cp, blk)					\
+  do {									\
+    if ((cp)->wp_victims)						\
+      {									\
+	if (cache_wrong_path)						\
+	  (cp)->wp_hits++;						\
+	else if ((blk)->status & CACHE_BLK_WPFILL)			\
+	  {								\
+	    (cp)->wp_used++;						\
+	    (blk)->status &= ~CACHE_BLK_WPFILL;				\
+	  }								\
+      }									\
+  } while (0)
+
+/* non-zero while accessing on behalf of a mis-speculated path */
+int cache_wrong_path = FALSE;
+
+/* cache_access() self-profiling, see cache.h */
+int cache_prof_active = FALSE;
+double cache_prof_nsecs = 0.0;
+
+/* cache_access() nesting depth while profiling */
+static int cache_prof_depth = 0;
+
 /* index an array of cache blocks, non-trivial due to variable length blocks */
 #define CACHE_BINDEX(cp, blks, i)					\
   ((struct cache_blk_t *)(((char *)(blks)) +				\
@@ -339,6 +369,15 @@ cache_create(char *name,		/* name of the cache */
   cp->writebacks = 0;
   cp->invalidations = 0;
 
+  /* per-origin stats are off until cache_track_origin() */
+  cp->wp_victims = NULL;
+  cp->wp_nvictims = 0;
+  cp->wp_hits = 0;
+  cp->wp_misses = 0;
+  cp->wp_used = 0;
+  cp->wp_evicts = 0;
+  cp->wp_pollution = 0;
+
   /* blow away the last block accessed */
   cp->last_tagset = 0;
   cp->last_blk = NULL;
@@ -401,6 +440,22 @@ cache_create(char *name,		/* name of the cache */
   return cp;
 }
 
+/* keep separate correct-path and wrong-path stats for cache CP, and track
+   the blocks wrong-path accesses bring in and throw out */
+void
+cache_track_origin(struct cache_t *cp)	/* cache instance */
+{
+  /* caches may be shared between levels, track them once */
+  if (cp->wp_victims)
+    return;
+
+  /* one victim record per cache block */
+  cp->wp_nvictims = cp->nsets * cp->assoc;
+  cp->wp_victims = (md_addr_t *)calloc(cp->wp_nvictims, sizeof(md_addr_t));
+  if (!cp->wp_victims)
+    fatal("out of virtual memory");
+}
+
 /* parse policy */
 enum cache_policy			/* replacement policy enum */
 cache_char2policy(char c)		/* replacement policy as a char */
@@ -471,6 +526,47 @@ cache_reg_stats(struct cache_t *cp,	/* cache instance */
   sprintf(buf, "%s.inv_rate", name);
   sprintf(buf1, "%s.invalidations / %s.accesses", name, name);
   stat_reg_formula(sdb, buf, "invalidation rate (i.e., invs/ref)", buf1, NULL);
+
+  if (!cp->wp_victims)
+    return;
+
+  sprintf(buf, "%s.cp_hits", name);
+  sprintf(buf1, "%s.hits - %s.wp_hits", name, name);
+  stat_reg_formula(sdb, buf, "hits by correct-path accesses", buf1, "%12.0f");
+  sprintf(buf, "%s.cp_misses", name);
+  sprintf(buf1, "%s.misses - %s.wp_misses", name, name);
+  stat_reg_formula(sdb, buf, "misses by correct-path accesses", buf1, "%12.0f");
+  sprintf(buf, "%s.cp_miss_rate", name);
+  sprintf(buf1, "%s.cp_misses / (%s.cp_hits + %s.cp_misses)", name, name, name);
+  stat_reg_formula(sdb, buf, "correct-path miss rate", buf1, NULL);
+  sprintf(buf, "%s.wp_hits", name);
+  stat_reg_counter(sdb, buf, "hits by wrong-path accesses",
+		   &cp->wp_hits, 0, NULL);
+  sprintf(buf, "%s.wp_misses", name);
+  stat_reg_counter(sdb, buf, "misses (block fills) by wrong-path accesses",
+		   &cp->wp_misses, 0, NULL);
+  sprintf(buf, "%s.wp_miss_rate", name);
+  sprintf(buf1, "%s.wp_misses / (%s.wp_hits + %s.wp_misses)", name, name, name);
+  stat_reg_formula(sdb, buf, "wrong-path miss rate", buf1, NULL);
+  sprintf(buf, "%s.wp_used", name);
+  stat_reg_counter(sdb, buf,
+		   "wrong-path fills later used by the correct path",
+		   &cp->wp_used, 0, NULL);
+  sprintf(buf, "%s.wp_used_rate", name);
+  sprintf(buf1, "%s.wp_used / %s.wp_misses", name, name);
+  stat_reg_formula(sdb, buf, "fraction of wrong-path fills used (prefetch)",
+		   buf1, NULL);
+  sprintf(buf, "%s.wp_evicts", name);
+  stat_reg_counter(sdb, buf, "valid blocks replaced by wrong-path fills",
+		   &cp->wp_evicts, 0, NULL);
+  sprintf(buf, "%s.wp_pollution", name);
+  stat_reg_counter(sdb, buf,
+		   "correct-path misses on blocks wrong-path fills replaced",
+		   &cp->wp_pollution, 0, NULL);
+  sprintf(buf, "%s.wp_pollution_rate", name);
+  sprintf(buf1, "%s.wp_pollution / %s.cp_misses", name, name);
+  stat_reg_formula(sdb, buf, "fraction of correct-path misses from pollution",
+		   buf1, NULL);
 }
 
 /* print cache stats */
@@ -491,20 +587,16 @@ cache_stats(struct cache_t *cp,		/* cache instance */
 	  (double)cp->invalidations/sum);
 }
 
-/* access a cache, perform a CMD operation on cache CP at address ADDR,
-   places NBYTES of data at *P, returns latency of operation if initiated
-   at NOW, places pointer to block user data in *UDATA, *P is untouched if
-   cache blocks are not allocated (!CP->BALLOC), UDATA should be NULL if no
-   user data is attached to blocks */
-unsigned int				/* latency of access in cycles */
-cache_access(struct cache_t *cp,	/* cache to access */
-	     enum mem_cmd cmd,		/* access type, Read or Write */
-	     md_addr_t addr,		/* address of access */
-	     void *vp,			/* ptr to buffer for input/output */
-	     int nbytes,		/* number of bytes to access */
-	     tick_t now,		/* time of access */
-	     byte_t **udata,		/* for return of user data ptr */
-	     md_addr_t *repl_addr)	/* for address of replaced block */
+/* access a cache, see cache_access(), which times this while profiling */
+static unsigned int			/* latency of access in cycles */
+cache_do_access(struct cache_t *cp,	/* cache to access */
+		enum mem_cmd cmd,		/* access type, Read or Write */
+		md_addr_t addr,		/* address of access */
+		void *vp,			/* ptr to buffer for input/output */
+		int nbytes,		/* number of bytes to access */
+		tick_t now,		/* time of access */
+		byte_t **udata,		/* for return of user data ptr */
+		md_addr_t *repl_addr)	/* for address of replaced block */
 {
   byte_t *p = vp;
   md_addr_t tag = CACHE_TAG(cp, addr);
@@ -567,6 +659,22 @@ cache_access(struct cache_t *cp,	/* cache to access */
   /* **MISS** */
   cp->misses++;
 
+  if (cp->wp_victims)
+    {
+      /* did a wrong-path fill throw this block out? */
+      md_addr_t *victim =
+	&cp->wp_victims[CACHE_WP_INDEX(cp, CACHE_BADDR(cp, addr))];
+
+      if (cache_wrong_path)
+	cp->wp_misses++;
+      else if (*victim == CACHE_BADDR(cp, addr))
+	cp->wp_pollution++;
+
+      /* the block is back in the cache either way */
+      if (*victim == CACHE_BADDR(cp, addr))
+	*victim = 0;
+    }
+
   /* select the appropriate block to replace, and re-link this entry to
      the appropriate place in the way list */
   switch (cp->policy) {
@@ -600,6 +708,16 @@ cache_access(struct cache_t *cp,	/* cache to access */
 
       if (repl_addr)
 	*repl_addr = CACHE_MK_BADDR(cp, repl->tag, set);
+
+      /* remember correct-path blocks a wrong-path fill throws out */
+      if (cp->wp_victims && cache_wrong_path
+	  && !(repl->status & CACHE_BLK_WPFILL))
+	{
+	  md_addr_t baddr = CACHE_MK_BADDR(cp, repl->tag, set);
+
+	  cp->wp_evicts++;
+	  cp->wp_victims[CACHE_WP_INDEX(cp, baddr)] = baddr;
+	}
  
       /* don't replace the block until outstanding misses are satisfied */
       lat += BOUND_POS(repl->ready - now);
@@ -623,6 +741,8 @@ cache_access(struct cache_t *cp,	/* cache to access */
   /* update block tags */
   repl->tag = tag;
   repl->status = CACHE_BLK_VALID;	/* dirty bit set on update */
+  if (cp->wp_victims && cache_wrong_path)
+    repl->status |= CACHE_BLK_WPFILL;
 
   /* read data block */
   lat += cp->blk_access_fn(Read, CACHE_BADDR(cp, addr), cp->bsize,
@@ -657,6 +777,7 @@ cache_access(struct cache_t *cp,	/* cache to access */
   
   /* **HIT** */
   cp->hits++;
+  CACHE_ORIGIN_HIT(cp, blk);
 
   /* copy data out of cache block, if block exists */
   if (cp->balloc)
@@ -692,6 +813,7 @@ cache_access(struct cache_t *cp,	/* cache to access */
   
   /* **FAST HIT** */
   cp->hits++;
+  CACHE_ORIGIN_HIT(cp, blk);
 
   /* copy data out of cache block, if block exists */
   if (cp->balloc)
@@ -719,6 +841,35 @@ cache_access(struct cache_t *cp,	/* cache to access */
   return (int) MAX(cp->hit_latency, (blk->ready - now));
 }
 
+/* access a cache, perform a CMD operation on cache CP at address ADDR,
+   places NBYTES of data at *P, returns latency of operation if initiated
+   at NOW, places pointer to block user data in *UDATA, *P is untouched if
+   cache blocks are not allocated (!CP->BALLOC), UDATA should be NULL if no
+   user data is attached to blocks */
+unsigned int				/* latency of access in cycles */
+cache_access(struct cache_t *cp,	/* cache to access */
+	     enum mem_cmd cmd,		/* access type, Read or Write */
+	     md_addr_t addr,		/* address of access */
+	     void *vp,			/* ptr to buffer for input/output */
+	     int nbytes,		/* number of bytes to access */
+	     tick_t now,		/* time of access */
+	     byte_t **udata,		/* for return of user data ptr */
+	     md_addr_t *repl_addr)	/* for address of replaced block */
+{
+  unsigned int lat;
+  double t0;
+
+  if (!cache_prof_active || cache_prof_depth)
+    return cache_do_access(cp, cmd, addr, vp, nbytes, now, udata, repl_addr);
+
+  cache_prof_depth++;
+  t0 = host_nsecs();
+  lat = cache_do_access(cp, cmd, addr, vp, nbytes, now, udata, repl_addr);
+  cache_prof_nsecs += host_nsecs() - t0;
+  cache_prof_depth--;
+  return lat;
+}
+
 /* return non-zero if block containing address ADDR is contained in cache
    CP, this interface is used primarily for debugging and asserting cache
    invariants */
@@ -108,6 +108,9 @@ enum cache_policy {
 /* block status values */
 #define CACHE_BLK_VALID		0x00000001	/* block in valid, in use */
 #define CACHE_BLK_DIRTY		0x00000002	/* dirty block */
+#define CACHE_BLK_WPFILL	0x00000004	/* filled by a wrong-path access,
+						   not yet used by the
+						   correct path */
 
 /* cache block (or line) definition */
 struct cache_blk_t
@@ -199,6 +202,18 @@ struct cache_t
   counter_t writebacks;		/* total number of writebacks at misses */
   counter_t invalidations;	/* total number of external invalidations */
 
+  /* per-origin stats, kept once cache_track_origin() is called */
+  md_addr_t *wp_victims;	/* blocks replaced by wrong-path fills, direct
+				   mapped on the block address */
+  int wp_nvictims;		/* number of WP_VICTIMS entries */
+  counter_t wp_hits;		/* hits by wrong-path accesses */
+  counter_t wp_misses;		/* misses (fills) by wrong-path accesses */
+  counter_t wp_used;		/* wrong-path fills later hit by the correct
+				   path (prefetch benefit) */
+  counter_t wp_evicts;		/* valid blocks replaced by wrong-path fills */
+  counter_t wp_pollution;	/* correct-path misses on blocks replaced by
+				   wrong-path fills */
+
   /* last block to hit, used to optimize cache hit processing */
   md_addr_t last_tagset;	/* tag of last line accessed */
   struct cache_blk_t *last_blk;	/* cache block last accessed */
@@ -227,6 +242,22 @@ cache_create(char *name,		/* name of the cache */
 					   tick_t now),
 	     unsigned int hit_latency);/* latency in cycles for a hit */
 
+/* non-zero while the simulator accesses the caches on behalf of a
+   mis-speculated (wrong) path, only caches set up with cache_track_origin()
+   look at it */
+extern int cache_wrong_path;
+
+/* while non-zero, host time spent in cache_access() is added to
+   CACHE_PROF_NSECS, for simulator self-profiling, accesses made on behalf
+   of another cache access (e.g., L1 miss to L2) are not counted twice */
+extern int cache_prof_active;
+extern double cache_prof_nsecs;
+
+/* keep separate correct-path and wrong-path stats for cache CP, and track
+   the blocks wrong-path accesses bring in and throw out */
+void
+cache_track_origin(struct cache_t *cp);	/* cache instance */
+
 /* parse policy */
 enum cache_policy			/* replacement policy enum */
 cache_char2policy(char c);		/* replacement policy as a char */
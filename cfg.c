@@ -0,0 +1,792 @@
+/* cfg.c - static control flow graph routines */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "memory.h"
+#include "loader.h"
+#include "stats.h"
+#include "cfg.h"
+
+/* basic blocks, in address order */
+int cfg_nbbs = 0;
+struct cfg_bb_t *cfg_bbs = NULL;
+
+/* text segment covered by the CFG */
+static md_addr_t cfg_text_base = 0;
+static int cfg_ninsts = 0;
+
+/* basic block of each text instruction */
+static int *cfg_inst_bb = NULL;
+
+/* CFG statistics */
+static int cfg_nloops = 0;		/* natural loops */
+static int cfg_nhammocks = 0;		/* short hammocks */
+static int cfg_cached = FALSE;		/* read from the sidecar file? */
+
+/* sidecar cache file header, the CFG is valid for a binary whose text
+   segment has the same base, size and hash */
+#define CFG_MAGIC		"sscfg\n\0"
+#define CFG_VERSION		1
+
+struct cfg_file_hdr_t {
+  char magic[8];			/* CFG_MAGIC */
+  int version;				/* CFG_VERSION */
+  int bb_size;				/* sizeof(struct cfg_bb_t) */
+  qword_t hash;				/* FNV-1a hash of the text */
+  md_addr_t text_base;			/* text segment base */
+  int ninsts;				/* text segment size in insts */
+  int nbbs;				/* basic blocks that follow */
+  int nloops, nhammocks;		/* CFG statistics */
+};
+
+/* index of text address PC, or -1 if PC is not in the text segment */
+#define CFG_INST_INDEX(PC)						\
+  (((PC) >= cfg_text_base						\
+    && (PC) < cfg_text_base + cfg_ninsts * sizeof(md_inst_t)		\
+    && ((PC) - cfg_text_base) % sizeof(md_inst_t) == 0)		\
+   ? (int)(((PC) - cfg_text_base) / sizeof(md_inst_t)) : -1)
+
+/* compute the direct branch/jump target of INST at PC */
+static md_addr_t
+cfg_branch_target(md_inst_t inst, md_addr_t pc, enum md_opcode op)
+{
+#if defined(TARGET_ALPHA)
+  return pc + sizeof(md_inst_t) + (SEXT21(TARG) << MD_BR_SHIFT);
+#elif defined(TARGET_PISA)
+  if (MD_OP_FLAGS(op) & F_COND)
+    return pc + sizeof(md_inst_t) + (OFS << 2);
+  else
+    return (pc & 036000000000) | (TARG << 2);
+#else
+#error No ISA target defined...
+#endif
+}
+
+/* compute the immediate dominators of the NNODES graph nodes reachable from
+   ROOT over the edges OUT_ADJ (compressed, node N's edges are OUT_ADJ
+   [OUT_OFF[N]..OUT_OFF[N+1]-1]), IN_ADJ holds the reverse edges; IDOM[N] is
+   set to -1 for unreachable nodes, uses the iterative algorithm of Cooper,
+   Harvey and Kennedy */
+static void
+cfg_idoms(int nnodes, int root,
+	  int *out_off, int *out_adj,
+	  int *in_off, int *in_adj,
+	  int *idom)
+{
+  int *po, *order, *stack, *next;
+  int i, norder, sp, changed;
+
+  po = calloc(nnodes, sizeof(int));
+  order = calloc(nnodes, sizeof(int));
+  stack = calloc(nnodes, sizeof(int));
+  next = calloc(nnodes, sizeof(int));
+  if (!po || !order || !stack || !next)
+    fatal("out of virtual memory");
+
+  /* depth-first postorder from ROOT */
+  for (i=0; i < nnodes; i++)
+    {
+      po[i] = -1;
+      idom[i] = -1;
+    }
+  norder = 0;
+  sp = 0;
+  stack[sp++] = root;
+  next[root] = out_off[root];
+  po[root] = -2;			/* on the stack */
+  while (sp > 0)
+    {
+      int n = stack[sp-1];
+
+      if (next[n] < out_off[n+1])
+	{
+	  int s = out_adj[next[n]++];
+
+	  if (po[s] == -1)
+	    {
+	      po[s] = -2;
+	      next[s] = out_off[s];
+	      stack[sp++] = s;
+	    }
+	}
+      else
+	{
+	  po[n] = norder;
+	  order[norder++] = n;
+	  sp--;
+	}
+    }
+
+  /* iterate in reverse postorder until the dominators settle */
+  idom[root] = root;
+  do
+    {
+      changed = FALSE;
+      for (i=norder-2; i >= 0; i--)
+	{
+	  int n = order[i], new_idom = -1, e;
+
+	  for (e=in_off[n]; e < in_off[n+1]; e++)
+	    {
+	      int p = in_adj[e];
+
+	      if (idom[p] == -1)
+		continue;
+	      if (new_idom == -1)
+		new_idom = p;
+	      else
+		{
+		  int a = p, b = new_idom;
+
+		  while (a != b)
+		    {
+		      while (po[a] < po[b])
+			a = idom[a];
+		      while (po[b] < po[a])
+			b = idom[b];
+		    }
+		  new_idom = a;
+		}
+	    }
+	  if (idom[n] != new_idom)
+	    {
+	      idom[n] = new_idom;
+	      changed = TRUE;
+	    }
+	}
+    }
+  while (changed);
+
+  free(po);
+  free(order);
+  free(stack);
+  free(next);
+}
+
+/* build the CFG of the NINSTS instructions in TEXT */
+static void
+cfg_build(md_inst_t *text)
+{
+  char *leader;
+  int i, b, n, nedges, entry_bb;
+  int *succ_off, *succ_adj, *pred_off, *pred_adj, *fill;
+  int *idom, *pre, *post, *stack, *stamp;
+
+  /* find the leaders, i.e., the first instruction of each block */
+  leader = calloc(cfg_ninsts + 1, sizeof(char));
+  if (!leader)
+    fatal("out of virtual memory");
+  leader[0] = TRUE;
+  for (i=0; i < cfg_ninsts; i++)
+    {
+      md_inst_t inst = text[i];
+      enum md_opcode op;
+
+      MD_SET_OPCODE(op, inst);
+      if (!(MD_OP_FLAGS(op) & F_CTRL))
+	continue;
+      leader[i+1] = TRUE;
+      if (MD_OP_FLAGS(op) & F_DIRJMP)
+	{
+	  int t = CFG_INST_INDEX(cfg_branch_target(inst,
+					cfg_text_base + i*sizeof(md_inst_t), op));
+	  if (t != -1)
+	    leader[t] = TRUE;
+	}
+    }
+
+  /* carve the text into blocks */
+  cfg_nbbs = 0;
+  for (i=0; i < cfg_ninsts; i++)
+    if (leader[i])
+      cfg_nbbs++;
+  cfg_bbs = calloc(cfg_nbbs, sizeof(struct cfg_bb_t));
+  if (!cfg_bbs)
+    fatal("out of virtual memory");
+  for (i=0, b=-1; i < cfg_ninsts; i++)
+    {
+      if (leader[i])
+	{
+	  b++;
+	  cfg_bbs[b].start = cfg_text_base + i*sizeof(md_inst_t);
+	  cfg_bbs[b].ipdom = cfg_bbs[b].idom = -1;
+	  cfg_bbs[b].hammock = -1;
+	}
+      cfg_bbs[b].ninsts++;
+      cfg_inst_bb[i] = b;
+    }
+  free(leader);
+
+  /* connect the blocks */
+  for (b=0; b < cfg_nbbs; b++)
+    {
+      struct cfg_bb_t *bb = &cfg_bbs[b];
+      int last = CFG_INST_INDEX(bb->start) + bb->ninsts - 1;
+      md_addr_t last_pc = bb->start + (bb->ninsts - 1)*sizeof(md_inst_t);
+      md_inst_t inst = text[last];
+      enum md_opcode op;
+      int fall = last + 1 < cfg_ninsts ? cfg_inst_bb[last + 1] : -1;
+      int targ = -1;
+
+      MD_SET_OPCODE(op, inst);
+      if ((MD_OP_FLAGS(op) & (F_CTRL|F_DIRJMP)) == (F_CTRL|F_DIRJMP))
+	{
+	  int t = CFG_INST_INDEX(cfg_branch_target(inst, last_pc, op));
+
+	  if (t != -1)
+	    targ = cfg_inst_bb[t];
+	}
+
+      if (!(MD_OP_FLAGS(op) & F_CTRL) || (MD_OP_FLAGS(op) & F_CALL))
+	{
+	  /* falls through, calls are assumed to return */
+	  if (fall != -1)
+	    bb->succ[bb->nsucc++] = fall;
+	}
+      else if (MD_OP_FLAGS(op) & F_COND)
+	{
+	  if (targ != -1)
+	    bb->succ[bb->nsucc++] = targ;
+	  if (fall != -1 && fall != targ)
+	    bb->succ[bb->nsucc++] = fall;
+	}
+      else if (targ != -1)
+	{
+	  /* direct jump */
+	  bb->succ[bb->nsucc++] = targ;
+	}
+      /* else, return or indirect jump, leaves to the exit node */
+    }
+
+  /* compressed successor and predecessor lists, with a virtual entry node
+     (N) leading to every block without predecessors and to the program
+     entry, and a virtual exit node (N+1) reached by every block without
+     successors */
+  n = cfg_nbbs + 2;
+  entry_bb = CFG_INST_INDEX(ld_prog_entry);
+  entry_bb = (entry_bb != -1) ? cfg_inst_bb[entry_bb] : -1;
+  succ_off = calloc(n + 1, sizeof(int));
+  pred_off = calloc(n + 1, sizeof(int));
+  fill = calloc(n, sizeof(int));
+  if (!succ_off || !pred_off || !fill)
+    fatal("out of virtual memory");
+
+#define CFG_FOREACH_EDGE(STMT)						\
+  {									\
+    int from, to, k;							\
+    for (from=0; from < cfg_nbbs; from++)				\
+      {									\
+	for (k=0; k < cfg_bbs[from].nsucc; k++)				\
+	  { to = cfg_bbs[from].succ[k]; STMT; }				\
+	if (cfg_bbs[from].nsucc == 0)					\
+	  { to = cfg_nbbs + 1; STMT; }					\
+      }									\
+    from = cfg_nbbs;							\
+    for (to=0; to < cfg_nbbs; to++)					\
+      if (fill[to] == 0 || to == entry_bb)				\
+	{ STMT; }							\
+  }
+
+  /* count the predecessors of each block first */
+  for (b=0; b < cfg_nbbs; b++)
+    {
+      int k;
+
+      for (k=0; k < cfg_bbs[b].nsucc; k++)
+	fill[cfg_bbs[b].succ[k]]++;
+    }
+  nedges = 0;
+  CFG_FOREACH_EDGE({ succ_off[from+1]++; pred_off[to+1]++; nedges++; });
+  for (i=0; i < n; i++)
+    {
+      succ_off[i+1] += succ_off[i];
+      pred_off[i+1] += pred_off[i];
+    }
+  succ_adj = calloc(nedges, sizeof(int));
+  pred_adj = calloc(nedges, sizeof(int));
+  if (!succ_adj || !pred_adj)
+    fatal("out of virtual memory");
+  {
+    int *sfill = calloc(n, sizeof(int)), *pfill = calloc(n, sizeof(int));
+
+    if (!sfill || !pfill)
+      fatal("out of virtual memory");
+    CFG_FOREACH_EDGE({
+      succ_adj[succ_off[from] + sfill[from]++] = to;
+      pred_adj[pred_off[to] + pfill[to]++] = from;
+    });
+    free(sfill);
+    free(pfill);
+  }
+#undef CFG_FOREACH_EDGE
+  free(fill);
+
+  idom = calloc(n, sizeof(int));
+  if (!idom)
+    fatal("out of virtual memory");
+
+  /* immediate post-dominators: dominators of the reverse CFG from exit */
+  cfg_idoms(n, cfg_nbbs + 1, pred_off, pred_adj, succ_off, succ_adj, idom);
+  for (b=0; b < cfg_nbbs; b++)
+    cfg_bbs[b].ipdom = (idom[b] < cfg_nbbs) ? idom[b] : -1;
+
+  /* immediate dominators, from the entry */
+  cfg_idoms(n, cfg_nbbs, succ_off, succ_adj, pred_off, pred_adj, idom);
+  for (b=0; b < cfg_nbbs; b++)
+    cfg_bbs[b].idom = (idom[b] < cfg_nbbs) ? idom[b] : -1;
+
+  /* number the dominator tree, so that dominance is a range check */
+  pre = calloc(n, sizeof(int));
+  post = calloc(n, sizeof(int));
+  stack = calloc(n, sizeof(int));
+  stamp = calloc(n, sizeof(int));
+  if (!pre || !post || !stack || !stamp)
+    fatal("out of virtual memory");
+  {
+    int *child_off = calloc(n + 1, sizeof(int)), *child = calloc(n, sizeof(int));
+    int *cfill = calloc(n, sizeof(int)), *next = calloc(n, sizeof(int));
+    int sp = 0, count = 0;
+
+    if (!child_off || !child || !cfill || !next)
+      fatal("out of virtual memory");
+    for (b=0; b < n; b++)
+      if (b != cfg_nbbs && idom[b] != -1)
+	child_off[idom[b]+1]++;
+    for (b=0; b < n; b++)
+      child_off[b+1] += child_off[b];
+    for (b=0; b < n; b++)
+      if (b != cfg_nbbs && idom[b] != -1)
+	child[child_off[idom[b]] + cfill[idom[b]]++] = b;
+    for (b=0; b < n; b++)
+      pre[b] = post[b] = -1;
+
+    stack[sp++] = cfg_nbbs;
+    pre[cfg_nbbs] = count++;
+    next[cfg_nbbs] = child_off[cfg_nbbs];
+    while (sp > 0)
+      {
+	int d = stack[sp-1];
+
+	if (next[d] < child_off[d+1])
+	  {
+	    int c = child[next[d]++];
+
+	    pre[c] = count++;
+	    next[c] = child_off[c];
+	    stack[sp++] = c;
+	  }
+	else
+	  {
+	    post[d] = count++;
+	    sp--;
+	  }
+      }
+    free(child_off);
+    free(child);
+    free(cfill);
+    free(next);
+  }
+#define CFG_DOMINATES(A, B)						\
+  (pre[A] != -1 && pre[B] != -1 && pre[A] <= pre[B] && post[B] <= post[A])
+
+  /* natural loops, one per header, the body is everything reaching a back
+     edge source without passing the header */
+  cfg_nloops = 0;
+  for (b=0; b < n; b++)
+    stamp[b] = -1;
+  for (b=0; b < cfg_nbbs; b++)
+    {
+      int e, sp = 0;
+
+      for (e=pred_off[b]; e < pred_off[b+1]; e++)
+	{
+	  int u = pred_adj[e];
+
+	  if (u < cfg_nbbs && CFG_DOMINATES(b, u) && stamp[u] != b)
+	    {
+	      if (stamp[b] != b)
+		{
+		  stamp[b] = b;
+		  cfg_bbs[b].loop_head = TRUE;
+		  cfg_bbs[b].loop_depth++;
+		  cfg_nloops++;
+		}
+	      if (stamp[u] != b)
+		{
+		  stamp[u] = b;
+		  cfg_bbs[u].loop_depth++;
+		  stack[sp++] = u;
+		}
+	    }
+	}
+      while (sp > 0)
+	{
+	  int x = stack[--sp];
+
+	  for (e=pred_off[x]; e < pred_off[x+1]; e++)
+	    {
+	      int p = pred_adj[e];
+
+	      if (p < cfg_nbbs && stamp[p] != b && CFG_DOMINATES(b, p))
+		{
+		  stamp[p] = b;
+		  cfg_bbs[p].loop_depth++;
+		  stack[sp++] = p;
+		}
+	    }
+	}
+    }
+#undef CFG_DOMINATES
+
+  /* short hammocks: the region between a conditional branch and its
+     immediate post-dominator, without loops or calls */
+  cfg_nhammocks = 0;
+  for (b=0; b < n; b++)
+    stamp[b] = -1;
+  for (b=0; b < cfg_nbbs; b++)
+    {
+      struct cfg_bb_t *bb = &cfg_bbs[b];
+      int sp = 0, size = 0, k, ok = TRUE;
+
+      if (bb->nsucc != 2 || bb->ipdom == -1)
+	continue;
+
+      stamp[b] = b;
+      stamp[bb->ipdom] = b;
+      for (k=0; k < 2; k++)
+	if (stamp[bb->succ[k]] != b)
+	  {
+	    stamp[bb->succ[k]] = b;
+	    stack[sp++] = bb->succ[k];
+	  }
+      while (ok && sp > 0)
+	{
+	  struct cfg_bb_t *x = &cfg_bbs[stack[--sp]];
+	  md_inst_t inst = text[CFG_INST_INDEX(x->start) + x->ninsts - 1];
+	  enum md_opcode op;
+
+	  MD_SET_OPCODE(op, inst);
+	  size += x->ninsts;
+	  if (x->loop_head || x->nsucc == 0 || (MD_OP_FLAGS(op) & F_CALL)
+	      || size > CFG_MAX_HAMMOCK)
+	    {
+	      ok = FALSE;
+	      break;
+	    }
+	  for (k=0; k < x->nsucc; k++)
+	    {
+	      if (x->succ[k] == b)
+		ok = FALSE;
+	      else if (stamp[x->succ[k]] != b)
+		{
+		  stamp[x->succ[k]] = b;
+		  stack[sp++] = x->succ[k];
+		}
+	    }
+	}
+      if (ok)
+	{
+	  bb->hammock = size;
+	  cfg_nhammocks++;
+	}
+    }
+
+  free(pre);
+  free(post);
+  free(stack);
+  free(stamp);
+  free(idom);
+  free(succ_off);
+  free(succ_adj);
+  free(pred_off);
+  free(pred_adj);
+}
+
+/* read the CFG from the sidecar file FNAME, if it belongs to the text
+   with hash HASH, returns non-zero on success */
+static int
+cfg_read_cache(char *fname, qword_t hash)
+{
+  struct cfg_file_hdr_t hdr;
+  FILE *fd;
+  int i, b;
+
+  fd = fopen(fname, "rb");
+  if (!fd)
+    return FALSE;
+  if (fread(&hdr, sizeof(hdr), 1, fd) != 1
+      || memcmp(hdr.magic, CFG_MAGIC, sizeof(hdr.magic)) != 0
+      || hdr.version != CFG_VERSION
+      || hdr.bb_size != sizeof(struct cfg_bb_t)
+      || hdr.hash != hash
+      || hdr.text_base != cfg_text_base
+      || hdr.ninsts != cfg_ninsts
+      || hdr.nbbs < 1 || hdr.nbbs > cfg_ninsts)
+    {
+      fclose(fd);
+      return FALSE;
+    }
+
+  cfg_bbs = calloc(hdr.nbbs, sizeof(struct cfg_bb_t));
+  if (!cfg_bbs)
+    fatal("out of virtual memory");
+  if (fread(cfg_bbs, sizeof(struct cfg_bb_t), hdr.nbbs, fd) != hdr.nbbs)
+    {
+      fclose(fd);
+      free(cfg_bbs);
+      cfg_bbs = NULL;
+      return FALSE;
+    }
+  fclose(fd);
+
+  /* rebuild the block map, checking the blocks' links on the way */
+  for (b=0, i=0; b < hdr.nbbs; b++)
+    {
+      struct cfg_bb_t *bb = &cfg_bbs[b];
+      int j, bad = FALSE;
+
+      if (bb->nsucc < 0 || bb->nsucc > 2)
+	bad = TRUE;
+      for (j=0; !bad && j < bb->nsucc; j++)
+	if (bb->succ[j] < 0 || bb->succ[j] >= hdr.nbbs)
+	  bad = TRUE;
+      if (bb->ipdom < -1 || bb->ipdom >= hdr.nbbs
+	  || bb->idom < -1 || bb->idom >= hdr.nbbs)
+	bad = TRUE;
+
+      if (bad
+	  || bb->ninsts < 1
+	  || bb->start != cfg_text_base + i*sizeof(md_inst_t)
+	  || i + bb->ninsts > cfg_ninsts)
+	{
+	  free(cfg_bbs);
+	  cfg_bbs = NULL;
+	  return FALSE;
+	}
+      for (j=0; j < bb->ninsts; j++)
+	cfg_inst_bb[i++] = b;
+    }
+  if (i != cfg_ninsts)
+    {
+      free(cfg_bbs);
+      cfg_bbs = NULL;
+      return FALSE;
+    }
+
+  cfg_nbbs = hdr.nbbs;
+  cfg_nloops = hdr.nloops;
+  cfg_nhammocks = hdr.nhammocks;
+  return TRUE;
+}
+
+/* write the CFG to the sidecar file FNAME */
+static void
+cfg_write_cache(char *fname, qword_t hash)
+{
+  struct cfg_file_hdr_t hdr;
+  FILE *fd;
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, CFG_MAGIC, sizeof(hdr.magic));
+  hdr.version = CFG_VERSION;
+  hdr.bb_size = sizeof(struct cfg_bb_t);
+  hdr.hash = hash;
+  hdr.text_base = cfg_text_base;
+  hdr.ninsts = cfg_ninsts;
+  hdr.nbbs = cfg_nbbs;
+  hdr.nloops = cfg_nloops;
+  hdr.nhammocks = cfg_nhammocks;
+
+  fd = fopen(fname, "wb");
+  if (!fd)
+    {
+      warn("could not write CFG cache file `%s'", fname);
+      return;
+    }
+  if (fwrite(&hdr, sizeof(hdr), 1, fd) != 1
+      || fwrite(cfg_bbs, sizeof(struct cfg_bb_t), cfg_nbbs, fd) != cfg_nbbs)
+    warn("could not write CFG cache file `%s'", fname);
+  fclose(fd);
+}
+
+/* return the 64-bit FNV-1a hash of the text segment loaded into MEM, which
+   identifies the binary to files derived from it (CFG cache, fork hints) */
+qword_t
+cfg_text_hash(struct mem_t *mem)	/* memory holding the text segment */
+{
+  qword_t hash = ULL(14695981039346656037);
+  md_addr_t pc;
+  md_inst_t inst;
+  unsigned char *p = (unsigned char *)&inst;
+  int j;
+
+  for (pc = ld_text_base; pc < ld_text_base + ld_text_size;
+       pc += sizeof(md_inst_t))
+    {
+      MD_FETCH_INST(inst, mem, pc);
+      for (j=0; j < sizeof(md_inst_t); j++)
+	hash = (hash ^ p[j]) * ULL(1099511628211);
+    }
+  return hash;
+}
+
+/* build the CFG of the text segment loaded into MEM, if CACHE_FNAME is
+   non-NULL, the CFG is read from that file if it holds the CFG of the same
+   text, and otherwise written there after it is built */
+void
+cfg_init(struct mem_t *mem,		/* memory holding the text segment */
+	 char *cache_fname)		/* sidecar cache file, or NULL */
+{
+  md_inst_t *text;
+  qword_t hash;
+  int i;
+
+  cfg_text_base = ld_text_base;
+  cfg_ninsts = ld_text_size / sizeof(md_inst_t);
+  if (cfg_ninsts < 1)
+    fatal("no text segment to build a CFG of");
+
+  cfg_inst_bb = calloc(cfg_ninsts, sizeof(int));
+  text = calloc(cfg_ninsts, sizeof(md_inst_t));
+  if (!cfg_inst_bb || !text)
+    fatal("out of virtual memory");
+
+  /* read the text */
+  for (i=0; i < cfg_ninsts; i++)
+    MD_FETCH_INST(text[i], mem, cfg_text_base + i*sizeof(md_inst_t));
+  hash = cfg_text_hash(mem);
+
+  cfg_cached = cache_fname && cfg_read_cache(cache_fname, hash);
+  if (!cfg_cached)
+    {
+      cfg_build(text);
+      if (cache_fname)
+	cfg_write_cache(cache_fname, hash);
+    }
+
+  free(text);
+}
+
+/* register CFG statistics */
+void
+cfg_reg_stats(struct stat_sdb_t *sdb)	/* stats data base */
+{
+  stat_reg_int(sdb, "cfg_blocks",
+	       "basic blocks in the text segment CFG",
+	       &cfg_nbbs, cfg_nbbs, NULL);
+  stat_reg_int(sdb, "cfg_loops",
+	       "natural loops in the text segment CFG",
+	       &cfg_nloops, cfg_nloops, NULL);
+  stat_reg_int(sdb, "cfg_hammocks",
+	       "conditional branches guarding a short hammock",
+	       &cfg_nhammocks, cfg_nhammocks, NULL);
+  stat_reg_int(sdb, "cfg_cached",
+	       "CFG read from the sidecar cache file?",
+	       &cfg_cached, cfg_cached, NULL);
+}
+
+/* return the basic block holding PC, or NULL if unknown */
+struct cfg_bb_t *
+cfg_bb(md_addr_t pc)			/* text address */
+{
+  int i;
+
+  if (!cfg_bbs)
+    return NULL;
+  i = CFG_INST_INDEX(pc);
+  return (i != -1) ? &cfg_bbs[cfg_inst_bb[i]] : NULL;
+}
+
+/* return the address where the paths leaving the basic block of PC
+   reconverge (the start of its immediate post-dominator), 0 if none */
+md_addr_t
+cfg_ipdom(md_addr_t pc)			/* text address */
+{
+  struct cfg_bb_t *bb = cfg_bb(pc);
+
+  return (bb && bb->ipdom != -1) ? cfg_bbs[bb->ipdom].start : 0;
+}
+
+/* return non-zero if PC's basic block heads a natural loop */
+int
+cfg_loop_head(md_addr_t pc)		/* text address */
+{
+  struct cfg_bb_t *bb = cfg_bb(pc);
+
+  return bb ? bb->loop_head : FALSE;
+}
+
+/* return the loop nesting depth of PC, 0 if not in a loop */
+int
+cfg_loop_depth(md_addr_t pc)		/* text address */
+{
+  struct cfg_bb_t *bb = cfg_bb(pc);
+
+  return bb ? bb->loop_depth : 0;
+}
+
+/* return the number of instructions in the hammock guarded by the
+   conditional branch at PC, or -1 if PC does not guard a short hammock */
+int
+cfg_hammock_size(md_addr_t pc)		/* text address */
+{
+  struct cfg_bb_t *bb = cfg_bb(pc);
+
+  /* only the branch ending the block guards the hammock */
+  if (!bb || pc != bb->start + (bb->ninsts - 1)*sizeof(md_inst_t))
+    return -1;
+  return bb->hammock;
+}
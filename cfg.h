@@ -0,0 +1,141 @@
+/* cfg.h - static control flow graph interfaces */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdio.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "memory.h"
+#include "stats.h"
+
+/*
+ * This module builds a static control flow graph (CFG) of the loaded
+ * program's text segment, i.e., ld_text_base .. ld_text_base+ld_text_size.
+ * The text is decoded once: basic blocks end at control instructions and
+ * start at direct branch/jump targets; calls are assumed to return to their
+ * fall-through, while returns and indirect jumps lead to a virtual exit
+ * node.  From the CFG, the module computes immediate post-dominators (where
+ * both paths of a branch reconverge), dominators and natural loops, and the
+ * size of the hammocks guarded by conditional branches.
+ *
+ * All queries take a text address and run in constant time, they index a
+ * per-instruction block map.  Addresses outside the text segment (or
+ * queries before cfg_init()) return the "unknown" value of each query.
+ *
+ * Building the CFG of a large binary takes a while, so the result may be
+ * cached in a sidecar file, keyed by a hash of the text segment, and is
+ * reloaded from there when the same binary is simulated again.
+ */
+
+/* hammocks larger than this (in instructions, both arms) are not short */
+#define CFG_MAX_HAMMOCK		64
+
+/* a basic block */
+struct cfg_bb_t {
+  md_addr_t start;		/* address of the first instruction */
+  int ninsts;			/* number of instructions */
+  int nsucc;			/* number of successors (0 => exit) */
+  int succ[2];			/* successor blocks */
+  int ipdom;			/* immediate post-dominator, -1 if exit/none */
+  int idom;			/* immediate dominator, -1 if entry/none */
+  int loop_head;		/* non-zero if a natural loop header */
+  int loop_depth;		/* number of natural loops holding the block */
+  int hammock;			/* insts in the hammock guarded by the block's
+				   conditional branch, -1 if none or long */
+};
+
+/* basic blocks, in address order, valid after cfg_init() */
+extern int cfg_nbbs;
+extern struct cfg_bb_t *cfg_bbs;
+
+/* build the CFG of the text segment loaded into MEM, if CACHE_FNAME is
+   non-NULL, the CFG is read from that file if it holds the CFG of the same
+   text, and otherwise written there after it is built */
+void
+cfg_init(struct mem_t *mem,		/* memory holding the text segment */
+	 char *cache_fname);		/* sidecar cache file, or NULL */
+
+/* return the 64-bit FNV-1a hash of the text segment loaded into MEM, which
+   identifies the binary to files derived from it (CFG cache, fork hints) */
+qword_t
+cfg_text_hash(struct mem_t *mem);	/* memory holding the text segment */
+
+/* register CFG statistics */
+void
+cfg_reg_stats(struct stat_sdb_t *sdb);	/* stats data base */
+
+/* return the basic block holding PC, or NULL if unknown */
+struct cfg_bb_t *
+cfg_bb(md_addr_t pc);			/* text address */
+
+/* return the address where the paths leaving the basic block of PC
+   reconverge (the start of its immediate post-dominator), 0 if none */
+md_addr_t
+cfg_ipdom(md_addr_t pc);		/* text address */
+
+/* return non-zero if PC's basic block heads a natural loop */
+int
+cfg_loop_head(md_addr_t pc);		/* text address */
+
+/* return the loop nesting depth of PC, 0 if not in a loop */
+int
+cfg_loop_depth(md_addr_t pc);		/* text address */
+
+/* return the number of instructions in the hammock guarded by the
+   conditional branch at PC, or -1 if PC does not guard a short hammock */
+int
+cfg_hammock_size(md_addr_t pc);		/* text address */
+
+#endif /* CFG_H */
@@ -51,6 +51,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #ifdef _MSC_VER
 #include <io.h>
 #else /* !_MSC_VER */
@@ -64,6 +65,7 @@
 #include "memory.h"
 #include "loader.h"
 #include "libexo/libexo.h"
+#include "eiobin.h"
 #include "syscall.h"
 #include "sim.h"
 #include "endian.h"
@@ -75,6 +77,11 @@
 
 #define EIO_FILE_HEADER							\
   "/* This is a SimpleScalar EIO file - DO NOT MOVE OR EDIT THIS LINE! */\n"
+
+/* EIO file kinds, EXO text or binary (see eiobin.h) */
+#define EIO_TEXT_FILE		1
+#define EIO_BIN_FILE		2
+
 /*
    EIO transaction format:
 
@@ -94,7 +101,7 @@
 static counter_t eio_trans_icnt = -1;
 
 FILE *
-eio_create(char *fname)
+eio_create(char *fname, int binary)
 {
   FILE *fd;
   struct exo_term_t *exo;
@@ -106,6 +113,14 @@ eio_create(char *fname)
   if (!fd)
     fatal("unable to create EIO file `%s'", fname);
 
+  if (binary)
+    {
+      /* emit binary EIO file header */
+      eio_bin_create(fd, MD_EIO_FILE_FORMAT, EIO_FILE_VERSION,
+		     target_big_endian);
+      return fd;
+    }
+
   /* emit EIO file header */
   fprintf(fd, "%s\n", EIO_FILE_HEADER);
   fprintf(fd, "/* file_format: %d, file_version: %d, big_endian: %d */\n", 
@@ -122,11 +137,41 @@ eio_create(char *fname)
   return fd;
 }
 
+/* returns the kind of EIO file FNAME is, EIO_TEXT_FILE, EIO_BIN_FILE, or
+   zero if it has no valid EIO header */
+static int
+eio_file_kind(char *fname)
+{
+  FILE *fd;
+  int kind = 0;
+  char buf[512];
+
+  /* open possible EIO file */
+  fd = gzopen(fname, "r");
+  if (!fd)
+    return 0;
+
+  /* read and check EIO file header, the binary magic is one line */
+  if (fgets(buf, 512, fd) != NULL)
+    {
+      if (!strcmp(buf, EIO_FILE_HEADER))
+	kind = EIO_TEXT_FILE;
+      else if (!strcmp(buf, EIO_BIN_MAGIC))
+	kind = EIO_BIN_FILE;
+    }
+
+  /* all done, close up file */
+  gzclose(fd);
+
+  return kind;
+}
+
 FILE *
 eio_open(char *fname)
 {
   FILE *fd;
   struct exo_term_t *exo;
+  struct eio_bin_t *bin;
   int file_format, file_version, big_endian, target_big_endian;
 
   target_big_endian = (endian_host_byte_order() == endian_big);
@@ -135,23 +180,34 @@ eio_open(char *fname)
   if (!fd)
     fatal("unable to open EIO file `%s'", fname);
 
-  /* read and check EIO file header */
-  exo = exo_read(fd);
-  if (!exo
-      || exo->ec != ec_list
-      || !exo->as_list.head
-      || exo->as_list.head->ec != ec_integer
-      || !exo->as_list.head->next
-      || exo->as_list.head->next->ec != ec_integer
-      || !exo->as_list.head->next->next
-      || exo->as_list.head->next->next->ec != ec_integer
-      || exo->as_list.head->next->next->next != NULL)
-    fatal("could not read EIO file header");
-
-  file_format = exo->as_list.head->as_integer.val;
-  file_version = exo->as_list.head->next->as_integer.val;
-  big_endian = exo->as_list.head->next->next->as_integer.val;
-  exo_delete(exo);
+  if (eio_file_kind(fname) == EIO_BIN_FILE)
+    {
+      /* read and check binary EIO file header */
+      bin = eio_bin_open(fd);
+      file_format = bin->file_format;
+      file_version = bin->file_version;
+      big_endian = bin->big_endian;
+    }
+  else
+    {
+      /* read and check EIO file header */
+      exo = exo_read(fd);
+      if (!exo
+	  || exo->ec != ec_list
+	  || !exo->as_list.head
+	  || exo->as_list.head->ec != ec_integer
+	  || !exo->as_list.head->next
+	  || exo->as_list.head->next->ec != ec_integer
+	  || !exo->as_list.head->next->next
+	  || exo->as_list.head->next->next->ec != ec_integer
+	  || exo->as_list.head->next->next->next != NULL)
+	fatal("could not read EIO file header");
+
+      file_format = exo->as_list.head->as_integer.val;
+      file_version = exo->as_list.head->next->as_integer.val;
+      big_endian = exo->as_list.head->next->next->as_integer.val;
+      exo_delete(exo);
+    }
 
   if (file_format != MD_EIO_FILE_FORMAT)
     fatal("EIO file `%s' has incompatible format", fname);
@@ -175,34 +231,38 @@ eio_open(char *fname)
 int
 eio_valid(char *fname)
 {
-  FILE *fd;
-  char buf[512];
-
-  /* open possible EIO file */
-  fd = gzopen(fname, "r");
-  if (!fd)
-    return FALSE;
-
-  /* read and check EIO file header */
-  fgets(buf, 512, fd);
-
-  /* check the header */
-  if (strcmp(buf, EIO_FILE_HEADER))
-    return FALSE;
-
-  /* all done, close up file */
-  gzclose(fd);
-
-  /* else, has a valid header, go with it... */
-  return TRUE;
+  return eio_file_kind(fname) != 0;
 }
 
 void
 eio_close(FILE *fd)
 {
+  struct eio_bin_t *bin;
+
+  /* binary EIO files are finished with their transaction index */
+  if ((bin = eio_bin_lookup(fd)) != NULL)
+    eio_bin_close(bin);
   gzclose(fd);
 }
 
+/* write EXO term EXO to the checkpoint on stream FD, preceded by COMMENT in
+   text EIO files */
+static void
+chkpt_put(FILE *fd, struct eio_bin_t *bin, char *comment,
+	  struct exo_term_t *exo)
+{
+  if (bin)
+    eio_bin_put_term(bin, exo);
+  else
+    {
+      if (comment)
+	fprintf(fd, "/* %s */\n", comment);
+      exo_print(exo, fd);
+      fprintf(fd, "\n\n");
+    }
+  exo_delete(exo);
+}
+
 /* check point current architected state to stream FD, returns
    EIO transaction count (an EIO file pointer) */
 counter_t
@@ -213,95 +273,89 @@ eio_write_chkpt(struct regs_t *regs,		/* regs to dump */
   int i;
   struct exo_term_t *exo;
   struct mem_pte_t *pte;
+  struct eio_bin_t *bin;
+  char comment[128];
 
-  myfprintf(fd, "/* ** start checkpoint @ %n... */\n\n", eio_trans_icnt);
+  /* binary checkpoints are one record of the same EXO terms */
+  bin = eio_bin_lookup(fd);
+  if (bin)
+    eio_bin_begin(bin, EIO_REC_CHKPT);
+  else
+    myfprintf(fd, "/* ** start checkpoint @ %n... */\n\n", eio_trans_icnt);
 
-  myfprintf(fd, "/* EIO file pointer: %n... */\n", eio_trans_icnt);
-  exo = exo_new(ec_integer, (exo_integer_t)eio_trans_icnt);
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
+  mysprintf(comment, "EIO file pointer: %n...", eio_trans_icnt);
+  chkpt_put(fd, bin, comment,
+	    exo_new(ec_integer, (exo_integer_t)eio_trans_icnt));
 
   /* dump misc regs: icnt, PC, NPC, etc... */
-  fprintf(fd, "/* misc regs icnt, PC, NPC, etc... */\n");
-  exo = MD_MISC_REGS_TO_EXO(regs);
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
+  chkpt_put(fd, bin, "misc regs icnt, PC, NPC, etc...",
+	    MD_MISC_REGS_TO_EXO(regs));
 
   /* dump integer registers */
-  fprintf(fd, "/* integer regs */\n");
   exo = exo_new(ec_list, NULL);
   for (i=0; i < MD_NUM_IREGS; i++)
     exo->as_list.head = exo_chain(exo->as_list.head, MD_IREG_TO_EXO(regs, i));
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
+  chkpt_put(fd, bin, "integer regs", exo);
 
   /* dump FP registers */
-  fprintf(fd, "/* FP regs (integer format) */\n");
   exo = exo_new(ec_list, NULL);
   for (i=0; i < MD_NUM_FREGS; i++)
     exo->as_list.head = exo_chain(exo->as_list.head, MD_FREG_TO_EXO(regs, i));
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
-
-  fprintf(fd, "/* writing `%d' memory pages... */\n", (int)mem->page_count);
-  exo = exo_new(ec_list,
-		exo_new(ec_integer, (exo_integer_t)mem->page_count),
-		exo_new(ec_address, (exo_integer_t)ld_brk_point),
-		exo_new(ec_address, (exo_integer_t)ld_stack_min),
-		NULL);
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
-
-  fprintf(fd, "/* text segment specifiers (base & size) */\n");
-  exo = exo_new(ec_list,
-		exo_new(ec_address, (exo_integer_t)ld_text_base),
-		exo_new(ec_integer, (exo_integer_t)ld_text_size),
-		NULL);
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
-
-  fprintf(fd, "/* data segment specifiers (base & size) */\n");
-  exo = exo_new(ec_list,
-		exo_new(ec_address, (exo_integer_t)ld_data_base),
-		exo_new(ec_integer, (exo_integer_t)ld_data_size),
-		NULL);
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
-
-  fprintf(fd, "/* stack segment specifiers (base & size) */\n");
-  exo = exo_new(ec_list,
-		exo_new(ec_address, (exo_integer_t)ld_stack_base),
-		exo_new(ec_integer, (exo_integer_t)ld_stack_size),
-		NULL);
-  exo_print(exo, fd);
-  fprintf(fd, "\n\n");
-  exo_delete(exo);
+  chkpt_put(fd, bin, "FP regs (integer format)", exo);
+
+  sprintf(comment, "writing `%d' memory pages...", (int)mem->page_count);
+  chkpt_put(fd, bin, comment,
+	    exo_new(ec_list,
+		    exo_new(ec_integer, (exo_integer_t)mem->page_count),
+		    exo_new(ec_address, (exo_integer_t)ld_brk_point),
+		    exo_new(ec_address, (exo_integer_t)ld_stack_min),
+		    NULL));
+
+  chkpt_put(fd, bin, "text segment specifiers (base & size)",
+	    exo_new(ec_list,
+		    exo_new(ec_address, (exo_integer_t)ld_text_base),
+		    exo_new(ec_integer, (exo_integer_t)ld_text_size),
+		    NULL));
+
+  chkpt_put(fd, bin, "data segment specifiers (base & size)",
+	    exo_new(ec_list,
+		    exo_new(ec_address, (exo_integer_t)ld_data_base),
+		    exo_new(ec_integer, (exo_integer_t)ld_data_size),
+		    NULL));
+
+  chkpt_put(fd, bin, "stack segment specifiers (base & size)",
+	    exo_new(ec_list,
+		    exo_new(ec_address, (exo_integer_t)ld_stack_base),
+		    exo_new(ec_integer, (exo_integer_t)ld_stack_size),
+		    NULL));
 
   /* visit all active memory pages, and dump them to the checkpoint file */
   MEM_FORALL(mem, i, pte)
     {
       /* dump this page... */
-      exo = exo_new(ec_list,
-		    exo_new(ec_address, (exo_integer_t)MEM_PTE_ADDR(pte, i)),
-		    exo_new(ec_blob, MD_PAGE_SIZE, pte->page),
-		    NULL);
-      exo_print(exo, fd);
-      fprintf(fd, "\n\n");
-      exo_delete(exo);
+      chkpt_put(fd, bin, NULL,
+		exo_new(ec_list,
+			exo_new(ec_address,
+				(exo_integer_t)MEM_PTE_ADDR(pte, i)),
+			exo_new(ec_blob, MD_PAGE_SIZE, pte->page),
+			NULL));
     }
 
-  myfprintf(fd, "/* ** end checkpoint @ %n... */\n\n", eio_trans_icnt);
+  if (bin)
+    eio_bin_end(bin);
+  else
+    myfprintf(fd, "/* ** end checkpoint @ %n... */\n\n", eio_trans_icnt);
 
   return eio_trans_icnt;
 }
 
+/* read the next EXO term of the checkpoint on stream FD */
+static struct exo_term_t *
+chkpt_get(FILE *fd, struct eio_bin_t *bin)
+{
+  return bin ? eio_bin_get_term(bin) : exo_read(fd);
+}
+
 /* read check point of architected state from stream FD, returns
    EIO transaction count (an EIO file pointer) */
 counter_t
@@ -312,9 +366,15 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   int i, page_count;
   counter_t trans_icnt;
   struct exo_term_t *exo, *elt;
+  struct eio_bin_t *bin;
+
+  /* binary checkpoints are one record of the same EXO terms */
+  bin = eio_bin_lookup(fd);
+  if (bin && eio_bin_next(bin) != EIO_REC_CHKPT)
+    fatal("could not read EIO checkpoint");
 
   /* read the EIO file pointer */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_integer)
     fatal("could not read EIO file pointer");
@@ -322,12 +382,12 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   exo_delete(exo);
 
   /* read misc regs: icnt, PC, NPC, HI, LO, FCC */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   MD_EXO_TO_MISC_REGS(exo, sim_num_insn, regs);
   exo_delete(exo);
 
   /* read integer registers */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_list)
     fatal("could not read EIO integer regs");
@@ -348,7 +408,7 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   exo_delete(exo);
 
   /* read FP registers */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_list)
     fatal("could not read EIO FP regs");
@@ -369,7 +429,7 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   exo_delete(exo);
 
   /* read the number of page defs, and memory config */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_list
       || !exo->as_list.head
@@ -386,7 +446,7 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   exo_delete(exo);
 
   /* read text segment specifiers */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_list
       || !exo->as_list.head
@@ -400,7 +460,7 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   exo_delete(exo);
 
   /* read data segment specifiers */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_list
       || !exo->as_list.head
@@ -414,7 +474,7 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
   exo_delete(exo);
 
   /* read stack segment specifiers */
-  exo = exo_read(fd);
+  exo = chkpt_get(fd, bin);
   if (!exo
       || exo->ec != ec_list
       || !exo->as_list.head
@@ -434,7 +494,7 @@ eio_read_chkpt(struct regs_t *regs,		/* regs to dump */
       struct exo_term_t *blob;
 
       /* read the page */
-      exo = exo_read(fd);
+      exo = chkpt_get(fd, bin);
       if (!exo
 	  || exo->ec != ec_list
 	  || !exo->as_list.head
@@ -577,6 +637,7 @@ eio_write_trace(FILE *eio_fd,			/* EIO stream file desc */
 {
   int i;
   struct exo_term_t *exo;
+  struct eio_bin_t *bin;
 
   /* write syscall register inputs ($r2..$r7) */
   input_regs = exo_new(ec_list, NULL);
@@ -619,8 +680,17 @@ eio_write_trace(FILE *eio_fd,			/* EIO stream file desc */
 		input_regs, input_mem,
 		output_regs, output_mem,
 		NULL);
-  exo_print(exo, eio_fd);
-  fprintf(eio_fd, "\n\n");
+  if ((bin = eio_bin_lookup(eio_fd)) != NULL)
+    {
+      eio_bin_begin(bin, EIO_REC_TRANS);
+      eio_bin_put_trans(bin, exo);
+      eio_bin_end(bin);
+    }
+  else
+    {
+      exo_print(exo, eio_fd);
+      fprintf(eio_fd, "\n\n");
+    }
 
   /* release input storage */
   exo_delete(exo);
@@ -629,6 +699,110 @@ eio_write_trace(FILE *eio_fd,			/* EIO stream file desc */
   eio_trans_icnt = icnt;
 }
 
+/* simulate view'able I/O of NBYTES at DATA */
+static void
+eio_view_output(struct regs_t *regs, unsigned char *data, int nbytes)
+{
+  if (sim_progfd)
+    {
+      /* redirect program output to file */
+      fwrite(data, 1, nbytes, sim_progfd);
+    }
+  else
+    {
+      /* write the output to stdout/stderr */
+      write(MD_STREAM_FILENO(regs), data, nbytes);
+    }
+}
+
+/* replay the next transaction of binary EIO stream BIN, the binary
+   counterpart of the EXO transaction checks and updates below */
+static void
+read_bin_trace(struct eio_bin_t *bin,		/* binary EIO stream */
+	       counter_t icnt,			/* instruction count */
+	       struct regs_t *regs,		/* registers to update */
+	       mem_access_fn mem_fn,		/* generic memory accessor */
+	       struct mem_t *mem)		/* memory to update */
+{
+  int i;
+  unsigned int n, size;
+  md_addr_t loc;
+  unsigned char *data;
+  struct exo_term_t reg;
+
+  if (eio_bin_next(bin) != EIO_REC_TRANS)
+    fatal("cannot read EIO transaction");
+
+  /* one more transaction processed */
+  eio_trans_icnt = icnt;
+
+  /* register values go through a scratch EXO term, so the MD_EXO_*
+     register accessors apply unchanged */
+  reg.next = NULL;
+  reg.ec = ec_address;
+
+  /* check ICNT and PC inputs */
+  if (icnt != (counter_t)eio_bin_get_qword(bin))
+    fatal("EIO trace inconsistency: ICNT mismatch");
+  if (regs->regs_PC != (md_addr_t)eio_bin_get_qword(bin))
+    fatal("EIO trace inconsistency: PC mismatch");
+
+  /* check integer register inputs */
+  n = eio_bin_get_word(bin);
+  if (n != MD_LAST_IN_REG - MD_FIRST_IN_REG + 1)
+    fatal("EIO trace inconsistency: input reg count mismatch");
+  for (i=MD_FIRST_IN_REG; i <= MD_LAST_IN_REG; i++)
+    {
+      reg.as_integer.val = (exo_integer_t)eio_bin_get_qword(bin);
+      if (MD_EXO_CMP_IREG(&reg, regs, i))
+	fatal("EIO trace inconsistency: R[%d] input mismatch", i);
+    }
+
+  /* check memory inputs */
+  for (n=eio_bin_get_word(bin); n > 0; n--)
+    {
+      loc = (md_addr_t)eio_bin_get_qword(bin);
+      size = eio_bin_get_word(bin);
+      data = eio_bin_get_bytes(bin, size);
+
+      for (i=0; i < size; i++)
+	{
+	  unsigned char val;
+
+	  (*mem_fn)(mem, Read, loc + i, &val, sizeof(unsigned char));
+	  if (val != data[i])
+	    fatal("EIO trace inconsistency: addr 0x%08p input mismatch",
+		  loc + i);
+	}
+
+      /* simulate view'able I/O */
+      if (MD_OUTPUT_SYSCALL(regs))
+	eio_view_output(regs, data, size);
+    }
+
+  /* adjust breakpoint and write integer register outputs */
+  n = eio_bin_get_word(bin);
+  if (n != MD_LAST_OUT_REG - MD_FIRST_OUT_REG + 2)
+    fatal("EIO trace inconsistency: output reg count mismatch");
+  ld_brk_point = (md_addr_t)eio_bin_get_qword(bin);
+  for (i=MD_FIRST_OUT_REG; i <= MD_LAST_OUT_REG; i++)
+    {
+      reg.as_integer.val = (exo_integer_t)eio_bin_get_qword(bin);
+      MD_EXO_TO_IREG(&reg, regs, i);
+    }
+
+  /* write memory outputs */
+  for (n=eio_bin_get_word(bin); n > 0; n--)
+    {
+      loc = (md_addr_t)eio_bin_get_qword(bin);
+      size = eio_bin_get_word(bin);
+      data = eio_bin_get_bytes(bin, size);
+
+      for (i=0; i < size; i++)
+	(*mem_fn)(mem, Write, loc + i, &data[i], sizeof(unsigned char));
+    }
+}
+
 /* syscall proxy handler from an EIO trace, architect registers
    and memory are assumed to be precise when this function is called,
    register and memory are updated with the results of the sustem call */
@@ -644,6 +818,7 @@ eio_read_trace(FILE *eio_fd,			/* EIO stream file desc */
   struct exo_term_t *exo, *exo_icnt, *exo_pc;
   struct exo_term_t *exo_inregs, *exo_inmem, *exo_outregs, *exo_outmem;
   struct exo_term_t *brkrec, *regrec, *memrec;
+  struct eio_bin_t *bin;
 
   /* exit() system calls get executed for real... */
   if (MD_EXIT_SYSCALL(regs))
@@ -652,6 +827,13 @@ eio_read_trace(FILE *eio_fd,			/* EIO stream file desc */
       panic("returned from exit() system call");
     }
 
+  /* binary EIO transactions are read without building EXO terms */
+  if ((bin = eio_bin_lookup(eio_fd)) != NULL)
+    {
+      read_bin_trace(bin, icnt, regs, mem_fn, mem);
+      return;
+    }
+
   /* else, read the external I/O (EIO) transaction */
   exo = exo_read(eio_fd);
 
@@ -737,19 +919,7 @@ eio_read_trace(FILE *eio_fd,			/* EIO stream file desc */
 
       /* simulate view'able I/O */
       if (MD_OUTPUT_SYSCALL(regs))
-	{
-	  if (sim_progfd)
-	    {
-	      /* redirect program output to file */
-	      fwrite(blob->as_blob.data, 1, blob->as_blob.size, sim_progfd);
-	    }
-	  else
-	    {
-	      /* write the output to stdout/stderr */
-	      write(MD_STREAM_FILENO(regs),
-		    blob->as_blob.data, blob->as_blob.size);
-	    }
-	}
+	eio_view_output(regs, blob->as_blob.data, blob->as_blob.size);
     }
 
   /*
@@ -815,6 +985,16 @@ void
 eio_fast_forward(FILE *eio_fd, counter_t icnt)
 {
   struct exo_term_t *exo, *exo_icnt;
+  struct eio_bin_t *bin;
+
+  /* binary EIO files seek straight to it through their index */
+  if ((bin = eio_bin_lookup(eio_fd)) != NULL)
+    {
+      if (!eio_bin_seek(bin, icnt))
+	fatal("could not fast forward to EIO checkpoint");
+      eio_trans_icnt = icnt;
+      return;
+    }
 
   do
     {
@@ -61,8 +61,11 @@
 /* EIO file version */
 #define EIO_FILE_VERSION		3
 
-FILE *eio_create(char *fname);
+/* create EIO file FNAME, in the binary format (see eiobin.h) if BINARY,
+   else as EXO text */
+FILE *eio_create(char *fname, int binary);
 
+/* open EIO file FNAME, text or binary */
 FILE *eio_open(char *fname);
 
 /* returns non-zero if file FNAME has a valid EIO header */
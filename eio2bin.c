@@ -0,0 +1,166 @@
+/* eio2bin.c - EIO text trace to binary trace converter */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "regs.h"
+#include "memory.h"
+#include "libexo/libexo.h"
+#include "eio.h"
+#include "eiobin.h"
+
+/* number of EXO terms in a checkpoint ahead of its memory pages */
+#define CHKPT_HDR_TERMS		8
+
+/* index of the memory page count term in a checkpoint */
+#define CHKPT_PAGES_TERM	4
+
+/*
+ * usage: eio2bin <text EIO file> <binary EIO file>
+ *
+ * rewrites an EIO trace or checkpoint file in the EXO text format as a
+ * binary EIO file (see eiobin.h), record for record, without re-executing
+ * the program; `.gz' files are (de)compressed on the fly
+ */
+int
+main(int argc, char **argv)
+{
+  int i, nterms;
+  counter_t nchkpts = 0, ntrans = 0;
+  FILE *infd, *outfd;
+  struct exo_term_t *exo;
+  struct eio_bin_t *bin;
+
+  if (argc != 3)
+    {
+      fprintf(stderr, "usage: %s <text EIO file> <binary EIO file>\n",
+	      argv[0]);
+      exit(1);
+    }
+
+  if (!(infd = gzopen(argv[1], "r")))
+    fatal("cannot open EIO file `%s'", argv[1]);
+
+  /* the header is the same three integers in both formats */
+  exo = exo_read(infd);
+  if (!exo
+      || exo->ec != ec_list
+      || !exo->as_list.head
+      || exo->as_list.head->ec != ec_integer
+      || !exo->as_list.head->next
+      || exo->as_list.head->next->ec != ec_integer
+      || !exo->as_list.head->next->next
+      || exo->as_list.head->next->next->ec != ec_integer
+      || exo->as_list.head->next->next->next != NULL)
+    fatal("`%s' is not a text EIO file", argv[1]);
+  if (exo->as_list.head->next->as_integer.val != EIO_FILE_VERSION)
+    fatal("EIO file `%s' has incompatible version", argv[1]);
+
+  if (!(outfd = gzopen(argv[2], "w")))
+    fatal("cannot create binary EIO file `%s'", argv[2]);
+  bin = eio_bin_create(outfd,
+		       (int)exo->as_list.head->as_integer.val,
+		       (int)exo->as_list.head->next->as_integer.val,
+		       (int)exo->as_list.head->next->next->as_integer.val);
+  exo_delete(exo);
+
+  while ((exo = exo_read(infd)) != NULL)
+    {
+      if (exo->ec == ec_integer)
+	{
+	  /* a checkpoint, its EIO file pointer then the remaining terms */
+	  eio_bin_begin(bin, EIO_REC_CHKPT);
+	  for (i=0, nterms=CHKPT_HDR_TERMS; ; )
+	    {
+	      if (i == CHKPT_PAGES_TERM)
+		{
+		  if (exo->ec != ec_list
+		      || !exo->as_list.head
+		      || exo->as_list.head->ec != ec_integer)
+		    fatal("could not read EIO memory page count");
+		  nterms += (int)exo->as_list.head->as_integer.val;
+		}
+	      eio_bin_put_term(bin, exo);
+	      exo_delete(exo);
+
+	      if (++i == nterms)
+		break;
+	      if (!(exo = exo_read(infd)))
+		fatal("EIO checkpoint is truncated");
+	    }
+	  eio_bin_end(bin);
+	  nchkpts++;
+	}
+      else
+	{
+	  /* a system call transaction */
+	  eio_bin_begin(bin, EIO_REC_TRANS);
+	  eio_bin_put_trans(bin, exo);
+	  eio_bin_end(bin);
+	  exo_delete(exo);
+	  ntrans++;
+	}
+    }
+  gzclose(infd);
+
+  eio_bin_close(bin);
+  gzclose(outfd);
+
+  myfprintf(stderr, "eio2bin: %n checkpoint(s), %n transaction(s)\n",
+	    nchkpts, ntrans);
+
+  return 0;
+}
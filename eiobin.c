@@ -0,0 +1,608 @@
+/* eiobin.c - binary EIO trace format routines */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "libexo/libexo.h"
+#include "eiobin.h"
+
+/* size of a record's <kind> <size> prefix */
+#define REC_HDR_SIZE		8
+
+/* size of the file trailer, index offset and EIO_BIN_INDEX_MAGIC */
+#define TRAILER_SIZE		16
+
+/* size of the file header */
+#define FILE_HDR_SIZE		(EIO_BIN_MAGIC_SIZE + 12)
+
+/* open binary streams, looked up by FILE pointer */
+static struct eio_bin_t *eio_bin_streams = NULL;
+
+/* little-endian field codecs */
+static void
+put_le(unsigned char *p, qword_t val, int nbytes)
+{
+  int i;
+
+  for (i=0; i < nbytes; i++, val >>= 8)
+    p[i] = (unsigned char)val;
+}
+
+static qword_t
+get_le(unsigned char *p, int nbytes)
+{
+  int i;
+  qword_t val = 0;
+
+  for (i=nbytes-1; i >= 0; i--)
+    val = (val << 8) | p[i];
+  return val;
+}
+
+/* make room for NBYTES more payload bytes */
+static unsigned char *
+buf_grow(struct eio_bin_t *bin, unsigned int nbytes)
+{
+  unsigned char *p;
+
+  if (bin->len + nbytes > bin->size)
+    {
+      while (bin->len + nbytes > bin->size)
+	bin->size = bin->size ? 2 * bin->size : 4096;
+      bin->buf = realloc(bin->buf, bin->size);
+      if (!bin->buf)
+	fatal("out of virtual memory");
+    }
+  p = bin->buf + bin->len;
+  bin->len += nbytes;
+  return p;
+}
+
+/* write NBYTES at P to the file, counting the file offset */
+static void
+bin_write(struct eio_bin_t *bin, void *p, unsigned int nbytes)
+{
+  if (fwrite(p, 1, nbytes, bin->fd) != nbytes)
+    fatal("could not write binary EIO file");
+  bin->offset += nbytes;
+}
+
+/* read NBYTES to P from the file, returns FALSE at end of file */
+static int
+bin_read(struct eio_bin_t *bin, void *p, unsigned int nbytes)
+{
+  unsigned int n;
+
+  n = fread(p, 1, nbytes, bin->fd);
+  if (n == 0 && feof(bin->fd))
+    return FALSE;
+  if (n != nbytes)
+    fatal("binary EIO file is truncated");
+  return TRUE;
+}
+
+static struct eio_bin_t *
+bin_new(FILE *fd)
+{
+  struct eio_bin_t *bin;
+
+  bin = calloc(1, sizeof(struct eio_bin_t));
+  if (!bin)
+    fatal("out of virtual memory");
+  bin->fd = fd;
+  bin->next = eio_bin_streams;
+  eio_bin_streams = bin;
+  return bin;
+}
+
+/* returns non-zero if stream FD starts with a binary EIO header, reads
+   EIO_BIN_MAGIC_SIZE bytes */
+int
+eio_bin_magic(FILE *fd)
+{
+  char magic[EIO_BIN_MAGIC_SIZE];
+
+  return (fread(magic, 1, EIO_BIN_MAGIC_SIZE, fd) == EIO_BIN_MAGIC_SIZE
+	  && !memcmp(magic, EIO_BIN_MAGIC, EIO_BIN_MAGIC_SIZE));
+}
+
+/* start a binary EIO file on FD, writes the header */
+struct eio_bin_t *
+eio_bin_create(FILE *fd, int file_format, int file_version, int big_endian)
+{
+  struct eio_bin_t *bin;
+  unsigned char hdr[FILE_HDR_SIZE];
+
+  bin = bin_new(fd);
+  bin->writing = TRUE;
+  bin->file_format = file_format;
+  bin->file_version = file_version;
+  bin->big_endian = big_endian;
+
+  memcpy(hdr, EIO_BIN_MAGIC, EIO_BIN_MAGIC_SIZE);
+  put_le(hdr + EIO_BIN_MAGIC_SIZE, file_format, 4);
+  put_le(hdr + EIO_BIN_MAGIC_SIZE + 4, file_version, 4);
+  put_le(hdr + EIO_BIN_MAGIC_SIZE + 8, big_endian, 4);
+  bin_write(bin, hdr, FILE_HDR_SIZE);
+
+  return bin;
+}
+
+/* read the next record of any kind, returns zero at end of file */
+static int
+read_rec(struct eio_bin_t *bin)
+{
+  unsigned int size;
+  unsigned char hdr[REC_HDR_SIZE];
+
+  if (!bin_read(bin, hdr, REC_HDR_SIZE))
+    return 0;
+  bin->kind = (int)get_le(hdr, 4);
+  size = (unsigned int)get_le(hdr + 4, 4);
+
+  bin->len = 0;
+  bin->pos = 0;
+  buf_grow(bin, size);
+  if (size != 0 && !bin_read(bin, bin->buf, size))
+    fatal("binary EIO file is truncated");
+
+  return bin->kind;
+}
+
+/* read the next record, returns its EIO_REC_* kind, or zero at the end of
+   the transactions */
+int
+eio_bin_next(struct eio_bin_t *bin)
+{
+  int kind;
+
+  /* the index follows the last transaction */
+  kind = read_rec(bin);
+  return kind == EIO_REC_INDEX ? 0 : kind;
+}
+
+/* load the transaction index named by the file trailer, if FD can seek */
+static void
+load_index(struct eio_bin_t *bin)
+{
+  int i;
+  counter_t index_offset;
+  unsigned char trailer[TRAILER_SIZE];
+
+  if (fseek(bin->fd, -TRAILER_SIZE, SEEK_END) != 0)
+    return;
+
+  if (fread(trailer, 1, TRAILER_SIZE, bin->fd) == TRAILER_SIZE
+      && !memcmp(trailer + 8, EIO_BIN_INDEX_MAGIC, 8))
+    {
+      index_offset = (counter_t)get_le(trailer, 8);
+      if (fseek(bin->fd, (long)index_offset, SEEK_SET) != 0
+	  || read_rec(bin) != EIO_REC_INDEX)
+	fatal("could not read binary EIO index");
+
+      bin->index_num = bin->index_size = eio_bin_get_word(bin);
+      bin->index = calloc(bin->index_size + 1,
+			  sizeof(struct eio_bin_index_t));
+      if (!bin->index)
+	fatal("out of virtual memory");
+      for (i=0; i < bin->index_num; i++)
+	{
+	  bin->index[i].icnt = (counter_t)eio_bin_get_qword(bin);
+	  bin->index[i].offset = (counter_t)eio_bin_get_qword(bin);
+	}
+    }
+
+  /* back to the first record */
+  if (fseek(bin->fd, FILE_HDR_SIZE, SEEK_SET) != 0)
+    fatal("could not rewind binary EIO file");
+}
+
+/* open a binary EIO file on FD, reads and checks the header and, if FD can
+   seek, loads the transaction index */
+struct eio_bin_t *
+eio_bin_open(FILE *fd)
+{
+  struct eio_bin_t *bin;
+  unsigned char hdr[FILE_HDR_SIZE - EIO_BIN_MAGIC_SIZE];
+
+  if (!eio_bin_magic(fd)
+      || fread(hdr, 1, sizeof(hdr), fd) != sizeof(hdr))
+    fatal("could not read binary EIO file header");
+
+  bin = bin_new(fd);
+  bin->file_format = (int)get_le(hdr, 4);
+  bin->file_version = (int)get_le(hdr + 4, 4);
+  bin->big_endian = (int)get_le(hdr + 8, 4);
+
+  load_index(bin);
+
+  return bin;
+}
+
+/* returns the binary stream open on FD, or NULL for text EIO files */
+struct eio_bin_t *
+eio_bin_lookup(FILE *fd)
+{
+  struct eio_bin_t *bin;
+
+  for (bin=eio_bin_streams; bin != NULL; bin=bin->next)
+    {
+      if (bin->fd == fd)
+	return bin;
+    }
+  return NULL;
+}
+
+/* release binary stream BIN, a written file gets its index and trailer;
+   FD is not closed */
+void
+eio_bin_close(struct eio_bin_t *bin)
+{
+  int i;
+  struct eio_bin_t **pbin;
+  unsigned char trailer[TRAILER_SIZE];
+
+  if (bin->writing)
+    {
+      counter_t index_offset = bin->offset;
+
+      eio_bin_begin(bin, EIO_REC_INDEX);
+      eio_bin_put_word(bin, bin->index_num);
+      for (i=0; i < bin->index_num; i++)
+	{
+	  eio_bin_put_qword(bin, bin->index[i].icnt);
+	  eio_bin_put_qword(bin, bin->index[i].offset);
+	}
+      eio_bin_end(bin);
+
+      put_le(trailer, index_offset, 8);
+      memcpy(trailer + 8, EIO_BIN_INDEX_MAGIC, 8);
+      bin_write(bin, trailer, TRAILER_SIZE);
+      fflush(bin->fd);
+    }
+
+  for (pbin=&eio_bin_streams; *pbin != NULL; pbin=&(*pbin)->next)
+    {
+      if (*pbin == bin)
+	{
+	  *pbin = bin->next;
+	  break;
+	}
+    }
+
+  if (bin->buf)
+    free(bin->buf);
+  if (bin->index)
+    free(bin->index);
+  free(bin);
+}
+
+/* start building an EIO_REC_* record of KIND */
+void
+eio_bin_begin(struct eio_bin_t *bin, int kind)
+{
+  bin->kind = kind;
+  bin->len = 0;
+  bin->rec_offset = bin->offset;
+}
+
+/* write the record being built */
+void
+eio_bin_end(struct eio_bin_t *bin)
+{
+  unsigned char hdr[REC_HDR_SIZE];
+
+  if (bin->kind == EIO_REC_TRANS)
+    {
+      if (bin->index_num == bin->index_size)
+	{
+	  bin->index_size = bin->index_size ? 2 * bin->index_size : 1024;
+	  bin->index = realloc(bin->index, bin->index_size
+			       * sizeof(struct eio_bin_index_t));
+	  if (!bin->index)
+	    fatal("out of virtual memory");
+	}
+      bin->index[bin->index_num].icnt = bin->rec_icnt;
+      bin->index[bin->index_num].offset = bin->rec_offset;
+      bin->index_num++;
+    }
+
+  put_le(hdr, bin->kind, 4);
+  put_le(hdr + 4, bin->len, 4);
+  bin_write(bin, hdr, REC_HDR_SIZE);
+  bin_write(bin, bin->buf, bin->len);
+}
+
+/* append a word, qword, raw bytes or an EXO term to the record */
+void
+eio_bin_put_word(struct eio_bin_t *bin, word_t val)
+{
+  put_le(buf_grow(bin, 4), val, 4);
+}
+
+void
+eio_bin_put_qword(struct eio_bin_t *bin, qword_t val)
+{
+  put_le(buf_grow(bin, 8), val, 8);
+}
+
+void
+eio_bin_put_bytes(struct eio_bin_t *bin, void *p, unsigned int size)
+{
+  if (size != 0)
+    memcpy(buf_grow(bin, size), p, size);
+}
+
+void
+eio_bin_put_term(struct eio_bin_t *bin, struct exo_term_t *exo)
+{
+  int len;
+  struct exo_term_t *elt;
+
+  *buf_grow(bin, 1) = (unsigned char)exo->ec;
+  switch (exo->ec)
+    {
+    case ec_integer:
+      eio_bin_put_qword(bin, (qword_t)exo->as_integer.val);
+      break;
+
+    case ec_address:
+      eio_bin_put_qword(bin, (qword_t)exo->as_address.val);
+      break;
+
+    case ec_blob:
+      eio_bin_put_word(bin, exo->as_blob.size);
+      eio_bin_put_bytes(bin, exo->as_blob.data, exo->as_blob.size);
+      break;
+
+    case ec_list:
+      for (len=0, elt=exo->as_list.head; elt != NULL; elt=elt->next)
+	len++;
+      eio_bin_put_word(bin, len);
+      for (elt=exo->as_list.head; elt != NULL; elt=elt->next)
+	eio_bin_put_term(bin, elt);
+      break;
+
+    default:
+      fatal("EXO class `%s' cannot be written to a binary EIO file",
+	    exo_class_str[exo->ec]);
+    }
+}
+
+/* append a list of register values, in EXO format */
+static void
+put_regs(struct eio_bin_t *bin, struct exo_term_t *list)
+{
+  int len;
+  struct exo_term_t *elt;
+
+  for (len=0, elt=list->as_list.head; elt != NULL; elt=elt->next)
+    len++;
+  eio_bin_put_word(bin, len);
+  for (elt=list->as_list.head; elt != NULL; elt=elt->next)
+    {
+      if (elt->ec != ec_address)
+	fatal("cannot write EIO transaction: bad register value");
+      eio_bin_put_qword(bin, (qword_t)elt->as_address.val);
+    }
+}
+
+/* append a list of (addr, blob) memory blocks, in EXO format */
+static void
+put_mem(struct eio_bin_t *bin, struct exo_term_t *list)
+{
+  int len;
+  struct exo_term_t *elt, *addr, *blob;
+
+  for (len=0, elt=list->as_list.head; elt != NULL; elt=elt->next)
+    len++;
+  eio_bin_put_word(bin, len);
+  for (elt=list->as_list.head; elt != NULL; elt=elt->next)
+    {
+      if (elt->ec != ec_list
+	  || !(addr = elt->as_list.head)
+	  || addr->ec != ec_address
+	  || !(blob = addr->next)
+	  || blob->ec != ec_blob
+	  || blob->next != NULL)
+	fatal("cannot write EIO transaction: bad memory transaction");
+      eio_bin_put_qword(bin, (qword_t)addr->as_address.val);
+      eio_bin_put_word(bin, blob->as_blob.size);
+      eio_bin_put_bytes(bin, blob->as_blob.data, blob->as_blob.size);
+    }
+}
+
+/* append the EIO transaction in EXO format EXO, as eio_write_trace()
+   builds it and text EIO files hold it */
+void
+eio_bin_put_trans(struct eio_bin_t *bin, struct exo_term_t *exo)
+{
+  struct exo_term_t *exo_icnt, *exo_pc;
+  struct exo_term_t *exo_inregs, *exo_inmem, *exo_outregs, *exo_outmem;
+
+  if (!exo
+      || exo->ec != ec_list
+      || !(exo_icnt = exo->as_list.head)
+      || exo_icnt->ec != ec_integer
+      || !(exo_pc = exo_icnt->next)
+      || exo_pc->ec != ec_address
+      || !(exo_inregs = exo_pc->next)
+      || exo_inregs->ec != ec_list
+      || !(exo_inmem = exo_inregs->next)
+      || exo_inmem->ec != ec_list
+      || !(exo_outregs = exo_inmem->next)
+      || exo_outregs->ec != ec_list
+      || !(exo_outmem = exo_outregs->next)
+      || exo_outmem->ec != ec_list
+      || exo_outmem->next != NULL)
+    fatal("cannot write EIO transaction");
+
+  bin->rec_icnt = (counter_t)exo_icnt->as_integer.val;
+  eio_bin_put_qword(bin, (qword_t)exo_icnt->as_integer.val);
+  eio_bin_put_qword(bin, (qword_t)exo_pc->as_address.val);
+  put_regs(bin, exo_inregs);
+  put_mem(bin, exo_inmem);
+  put_regs(bin, exo_outregs);
+  put_mem(bin, exo_outmem);
+}
+
+/* read a word, qword, SIZE raw bytes or an EXO term from the record, bytes
+   point into the record buffer and are valid until the next record */
+unsigned char *
+eio_bin_get_bytes(struct eio_bin_t *bin, unsigned int size)
+{
+  unsigned char *p;
+
+  if (bin->pos + size > bin->len)
+    fatal("binary EIO record is truncated");
+  p = bin->buf + bin->pos;
+  bin->pos += size;
+  return p;
+}
+
+word_t
+eio_bin_get_word(struct eio_bin_t *bin)
+{
+  return (word_t)get_le(eio_bin_get_bytes(bin, 4), 4);
+}
+
+qword_t
+eio_bin_get_qword(struct eio_bin_t *bin)
+{
+  return get_le(eio_bin_get_bytes(bin, 8), 8);
+}
+
+struct exo_term_t *
+eio_bin_get_term(struct eio_bin_t *bin)
+{
+  int ec;
+  unsigned int i, len;
+  struct exo_term_t *exo, *elt, *tail;
+
+  ec = *eio_bin_get_bytes(bin, 1);
+  switch (ec)
+    {
+    case ec_integer:
+      exo = exo_new(ec_integer, (exo_integer_t)eio_bin_get_qword(bin));
+      break;
+
+    case ec_address:
+      exo = exo_new(ec_address, (exo_address_t)eio_bin_get_qword(bin));
+      break;
+
+    case ec_blob:
+      len = eio_bin_get_word(bin);
+      exo = exo_new(ec_blob, len, eio_bin_get_bytes(bin, len));
+      break;
+
+    case ec_list:
+      len = eio_bin_get_word(bin);
+      exo = exo_new(ec_list, NULL);
+      for (i=0, tail=NULL; i < len; i++, tail=elt)
+	{
+	  elt = eio_bin_get_term(bin);
+	  if (tail)
+	    tail->next = elt;
+	  else
+	    exo->as_list.head = elt;
+	}
+      break;
+
+    default:
+      fatal("bad EXO class in binary EIO record");
+    }
+
+  return exo;
+}
+
+/* position BIN just after the transaction at ICNT, returns zero if the
+   trace has none */
+int
+eio_bin_seek(struct eio_bin_t *bin, counter_t icnt)
+{
+  int lo, hi, mid, kind;
+
+  if (bin->index)
+    {
+      /* binary search the index, transactions are in ICNT order */
+      lo = 0; hi = bin->index_num - 1;
+      while (lo <= hi)
+	{
+	  mid = (lo + hi) / 2;
+	  if (bin->index[mid].icnt < icnt)
+	    lo = mid + 1;
+	  else if (bin->index[mid].icnt > icnt)
+	    hi = mid - 1;
+	  else
+	    {
+	      if (fseek(bin->fd, (long)bin->index[mid].offset, SEEK_SET) != 0)
+		fatal("could not seek in binary EIO file");
+	      return eio_bin_next(bin) == EIO_REC_TRANS;
+	    }
+	}
+      return FALSE;
+    }
+
+  /* no index, e.g., a compressed file, read records up to ICNT */
+  while ((kind = eio_bin_next(bin)) != 0)
+    {
+      if (kind == EIO_REC_TRANS
+	  && (counter_t)get_le(bin->buf, 8) == icnt)
+	return TRUE;
+    }
+  return FALSE;
+}
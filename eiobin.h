@@ -0,0 +1,185 @@
+/* eiobin.h - binary EIO trace format interfaces */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+
+#ifndef EIOBIN_H
+#define EIOBIN_H
+
+#include <stdio.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "libexo/libexo.h"
+
+/*
+ * binary EIO file format (EIO v2), a header followed by length-prefixed
+ * records, all integers are little-endian:
+ *
+ *	header			- EIO_BIN_MAGIC, <format>, <version>,
+ *				  <big_endian> (words)
+ *	record			- <kind> <size> (words), then <size> bytes
+ *
+ *	EIO_REC_CHKPT		- the checkpoint's EXO terms, in the order
+ *				  eio_write_chkpt() prints them as text
+ *	EIO_REC_TRANS		- one system call transaction:
+ *		<icnt> <pc>				(qwords)
+ *		<n> <reg>...				input regs
+ *		<n> (<addr> <size> <bytes>)...		input memory
+ *		<n> <brk> <reg>...			output regs
+ *		<n> (<addr> <size> <bytes>)...		output memory
+ *	EIO_REC_INDEX		- <n>, then <icnt> <offset> (qwords) for each
+ *				  EIO_REC_TRANS record, in file order
+ *
+ * counts and sizes are words, registers and addresses are qwords, and
+ * memory blocks are raw target bytes; a written file ends with the index
+ * record and a trailer of its offset (qword) and EIO_BIN_INDEX_MAGIC, so
+ * a reader that can seek finds a transaction by instruction count without
+ * reading the ones before it.  EXO terms in checkpoints are a class byte
+ * followed by a qword (integers and addresses), a word size and raw bytes
+ * (blobs), or a word length and that many terms (lists)
+ */
+#define EIO_BIN_MAGIC		"\177SSEIO2\n"
+#define EIO_BIN_MAGIC_SIZE	8
+#define EIO_BIN_INDEX_MAGIC	"SSEIOIDX"
+
+#define EIO_REC_CHKPT		1
+#define EIO_REC_TRANS		2
+#define EIO_REC_INDEX		3
+
+/* one index entry, a transaction and its record's file offset */
+struct eio_bin_index_t {
+  counter_t icnt;			/* transaction instruction count */
+  counter_t offset;			/* record offset in file */
+};
+
+/* binary EIO stream state */
+struct eio_bin_t {
+  struct eio_bin_t *next;		/* next open binary stream */
+  FILE *fd;				/* EIO file */
+  int writing;				/* opened by eio_bin_create()? */
+  int file_format, file_version;	/* header fields */
+  int big_endian;
+
+  /* current record, being built or read back */
+  int kind;				/* EIO_REC_* */
+  unsigned char *buf;			/* record payload */
+  unsigned int len, size, pos;		/* payload length, buffer size,
+					   and read position */
+  counter_t rec_icnt;			/* transaction ICNT, if EIO_REC_TRANS */
+  counter_t rec_offset;			/* record offset in file */
+  counter_t offset;			/* bytes written so far */
+
+  /* transaction index, built while writing or loaded from the trailer */
+  struct eio_bin_index_t *index;
+  int index_num, index_size;
+};
+
+/* returns non-zero if stream FD starts with a binary EIO header, reads
+   EIO_BIN_MAGIC_SIZE bytes */
+int
+eio_bin_magic(FILE *fd);
+
+/* start a binary EIO file on FD, writes the header */
+struct eio_bin_t *
+eio_bin_create(FILE *fd, int file_format, int file_version, int big_endian);
+
+/* open a binary EIO file on FD, reads and checks the header and, if FD can
+   seek, loads the transaction index */
+struct eio_bin_t *
+eio_bin_open(FILE *fd);
+
+/* returns the binary stream open on FD, or NULL for text EIO files */
+struct eio_bin_t *
+eio_bin_lookup(FILE *fd);
+
+/* release binary stream BIN, a written file gets its index and trailer;
+   FD is not closed */
+void
+eio_bin_close(struct eio_bin_t *bin);
+
+/* start building an EIO_REC_* record of KIND */
+void
+eio_bin_begin(struct eio_bin_t *bin, int kind);
+
+/* write the record being built */
+void
+eio_bin_end(struct eio_bin_t *bin);
+
+/* append a word, qword, raw bytes or an EXO term to the record */
+void eio_bin_put_word(struct eio_bin_t *bin, word_t val);
+void eio_bin_put_qword(struct eio_bin_t *bin, qword_t val);
+void eio_bin_put_bytes(struct eio_bin_t *bin, void *p, unsigned int size);
+void eio_bin_put_term(struct eio_bin_t *bin, struct exo_term_t *exo);
+
+/* append the EIO transaction in EXO format EXO, as eio_write_trace()
+   builds it and text EIO files hold it */
+void
+eio_bin_put_trans(struct eio_bin_t *bin, struct exo_term_t *exo);
+
+/* read the next record, returns its EIO_REC_* kind, or zero at the end of
+   the transactions */
+int
+eio_bin_next(struct eio_bin_t *bin);
+
+/* read a word, qword, SIZE raw bytes or an EXO term from the record, bytes
+   point into the record buffer and are valid until the next record */
+word_t eio_bin_get_word(struct eio_bin_t *bin);
+qword_t eio_bin_get_qword(struct eio_bin_t *bin);
+unsigned char *eio_bin_get_bytes(struct eio_bin_t *bin, unsigned int size);
+struct exo_term_t *eio_bin_get_term(struct eio_bin_t *bin);
+
+/* position BIN just after the transaction at ICNT, returns zero if the
+   trace has none */
+int
+eio_bin_seek(struct eio_bin_t *bin, counter_t icnt);
+
+#endif /* EIOBIN_H */
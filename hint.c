@@ -0,0 +1,232 @@
+/* hint.c - per-branch fork hint file routines */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "memory.h"
+#include "loader.h"
+#include "cfg.h"
+#include "hint.h"
+
+/* hint file header and record formats, in host byte order */
+#define HINT_MAGIC		"sshint\n"
+#define HINT_VERSION		2
+
+struct hint_file_hdr_t {
+  char magic[8];			/* HINT_MAGIC */
+  int version;				/* HINT_VERSION */
+  int nhints;				/* records that follow */
+  char pred_name[32];			/* profiled predictor */
+  md_addr_t text_base;			/* profiled program's text base */
+  unsigned int text_size;		/* ... its text size */
+  int pad;
+  qword_t text_hash;			/* ... and FNV-1a hash of its text */
+};
+
+struct hint_file_rec_t {
+  md_addr_t PC;				/* branch address */
+  counter_t count;			/* times executed */
+  counter_t misses;			/* times mis-predicted */
+  int hammock;				/* guarded hammock size, or -1 */
+  int pad;
+};
+
+/* hint hash table, chained by PC */
+#define HINT_HASH_SIZE		4096
+#define HINT_HASH(PC)		(((PC) >> MD_BR_SHIFT) & (HINT_HASH_SIZE - 1))
+
+static struct hint_t *hint_table[HINT_HASH_SIZE];
+
+/* number of hints loaded or created */
+int hint_nhints = 0;
+
+/* header of the loaded hint file, checked by hint_check() */
+static char *hint_fname = NULL;
+static struct hint_file_hdr_t hint_hdr;
+
+/* return the hint of the branch at PC, or NULL if there is none */
+struct hint_t *
+hint_lookup(md_addr_t PC)		/* branch address */
+{
+  struct hint_t *h;
+
+  for (h = hint_table[HINT_HASH(PC)]; h; h = h->next)
+    if (h->PC == PC)
+      return h;
+  return NULL;
+}
+
+/* return the hint of the branch at PC, creating an empty one if there is
+   none */
+struct hint_t *
+hint_touch(md_addr_t PC)		/* branch address */
+{
+  struct hint_t *h = hint_lookup(PC);
+
+  if (h)
+    return h;
+
+  h = calloc(1, sizeof(struct hint_t));
+  if (!h)
+    fatal("out of virtual memory");
+  h->PC = PC;
+  h->hammock = -1;
+  h->next = hint_table[HINT_HASH(PC)];
+  hint_table[HINT_HASH(PC)] = h;
+  hint_nhints++;
+
+  return h;
+}
+
+/* write all hints to FNAME, PRED_NAME names the predictor profiled */
+void
+hint_write(char *fname,			/* hint file name */
+	   char *pred_name,		/* profiled predictor */
+	   struct mem_t *mem)		/* memory holding the program text */
+{
+  struct hint_file_hdr_t hdr;
+  struct hint_file_rec_t rec;
+  struct hint_t *h;
+  FILE *fd;
+  int i;
+
+  fd = fopen(fname, "wb");
+  if (!fd)
+    fatal("cannot open hint file `%s'", fname);
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, HINT_MAGIC, sizeof(hdr.magic));
+  hdr.version = HINT_VERSION;
+  hdr.nhints = hint_nhints;
+  strncpy(hdr.pred_name, pred_name, sizeof(hdr.pred_name) - 1);
+  hdr.text_base = ld_text_base;
+  hdr.text_size = ld_text_size;
+  hdr.text_hash = cfg_text_hash(mem);
+  if (fwrite(&hdr, sizeof(hdr), 1, fd) != 1)
+    fatal("cannot write hint file `%s'", fname);
+
+  memset(&rec, 0, sizeof(rec));
+  for (i=0; i < HINT_HASH_SIZE; i++)
+    for (h = hint_table[i]; h; h = h->next)
+      {
+	rec.PC = h->PC;
+	rec.count = h->count;
+	rec.misses = h->misses;
+	rec.hammock = h->hammock;
+	if (fwrite(&rec, sizeof(rec), 1, fd) != 1)
+	  fatal("cannot write hint file `%s'", fname);
+      }
+
+  if (fclose(fd) != 0)
+    fatal("cannot write hint file `%s'", fname);
+}
+
+/* load the hints in FNAME */
+void
+hint_load(char *fname)			/* hint file name */
+{
+  struct hint_file_hdr_t hdr;
+  struct hint_file_rec_t rec;
+  FILE *fd;
+  int i;
+
+  fd = fopen(fname, "rb");
+  if (!fd)
+    fatal("cannot open hint file `%s'", fname);
+
+  if (fread(&hdr, sizeof(hdr), 1, fd) != 1
+      || memcmp(hdr.magic, HINT_MAGIC, sizeof(hdr.magic)) != 0)
+    fatal("`%s' is not a hint file", fname);
+  if (hdr.version != HINT_VERSION)
+    fatal("hint file `%s' has version %d, expected %d",
+	  fname, hdr.version, HINT_VERSION);
+
+  for (i=0; i < hdr.nhints; i++)
+    {
+      struct hint_t *h;
+
+      if (fread(&rec, sizeof(rec), 1, fd) != 1)
+	fatal("hint file `%s' is truncated", fname);
+      h = hint_touch(rec.PC);
+      h->count += rec.count;
+      h->misses += rec.misses;
+      h->hammock = rec.hammock;
+    }
+
+  fclose(fd);
+
+  hint_fname = mystrdup(fname);
+  hint_hdr = hdr;
+  hint_hdr.pred_name[sizeof(hint_hdr.pred_name) - 1] = '\0';
+}
+
+/* check the loaded hints against the program loaded into MEM, a different
+   text segment is fatal, a different predictor than PRED_NAME only warns */
+void
+hint_check(struct mem_t *mem,		/* memory holding the program text */
+	   char *pred_name)		/* predictor in use */
+{
+  if (!hint_fname)
+    panic("no hints loaded");
+
+  if (hint_hdr.text_base != ld_text_base
+      || hint_hdr.text_size != ld_text_size
+      || hint_hdr.text_hash != cfg_text_hash(mem))
+    fatal("hint file `%s' was profiled on a different program", hint_fname);
+
+  if (strcmp(hint_hdr.pred_name, pred_name) != 0)
+    warn("hint file `%s' profiled predictor `%s', simulating `%s'",
+	 hint_fname, hint_hdr.pred_name, pred_name);
+}
@@ -0,0 +1,111 @@
+/* hint.h - per-branch fork hint file interfaces */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+#ifndef HINT_H
+#define HINT_H
+
+#include <stdio.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "memory.h"
+
+/*
+ * This module manages the fork hint file, a binary profile of the static
+ * branches of a program: how often each executed, how often a given
+ * branch predictor mis-predicted it, and the size of the hammock it guards
+ * (see cfg.h).  Profiling simulators (sim-bpred -bpred:hints) create hints
+ * with hint_touch() and save them with hint_write(); sim-outorder loads
+ * them with hint_load() and looks them up by PC to decide where forking a
+ * thread is worthwhile.  The file records the text segment of the profiled
+ * binary, hint_check() rejects hints applied to a different binary.
+ */
+
+/* a static branch's hint record */
+struct hint_t {
+  struct hint_t *next;		/* next hint in the hash bucket chain */
+  md_addr_t PC;			/* branch address */
+  counter_t count;		/* times executed */
+  counter_t misses;		/* times mis-predicted */
+  int hammock;			/* size of the guarded hammock, -1 if none */
+};
+
+/* number of hints loaded or created */
+extern int hint_nhints;
+
+/* return the hint of the branch at PC, or NULL if there is none */
+struct hint_t *
+hint_lookup(md_addr_t PC);		/* branch address */
+
+/* return the hint of the branch at PC, creating an empty one if there is
+   none */
+struct hint_t *
+hint_touch(md_addr_t PC);		/* branch address */
+
+/* write all hints to FNAME, PRED_NAME names the predictor profiled, MEM
+   holds the text segment of the profiled program */
+void
+hint_write(char *fname,			/* hint file name */
+	   char *pred_name,		/* profiled predictor */
+	   struct mem_t *mem);		/* memory holding the program text */
+
+/* load the hints in FNAME */
+void
+hint_load(char *fname);			/* hint file name */
+
+/* check the loaded hints against the program loaded into MEM, a different
+   text segment is fatal, a different predictor than PRED_NAME only warns */
+void
+hint_check(struct mem_t *mem,		/* memory holding the program text */
+	   char *pred_name);		/* predictor in use */
+
+#endif /* HINT_H */
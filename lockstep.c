@@ -0,0 +1,450 @@
+/* lockstep.c - commit stream digest and lockstep checker routines */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "regs.h"
+#include "memory.h"
+#include "syscall.h"
+#include "lockstep.h"
+
+/* functional core registers */
+static struct regs_t regs;
+
+/* functional core memory */
+static struct mem_t *mem = NULL;
+
+/* registers after the last system call executed by the timing simulator,
+   valid until the functional core reaches that call */
+static struct regs_t sys_regs;
+static int sys_regs_valid = FALSE;
+
+/* instructions checked */
+static counter_t lockstep_insn = 0;
+
+/* recent commit history, reported on a divergence */
+#define LOCKSTEP_HIST		8
+static struct lockstep_rec_t hist[LOCKSTEP_HIST];
+
+
+/*
+ * instruction records
+ */
+
+/* register dependence names, as decoded by sim-outorder */
+
+#define DNA			(0)
+
+#if defined(TARGET_PISA)
+
+/* general register dependence decoders */
+#define DGPR(N)			(N)
+#define DGPR_D(N)		((N) &~1)
+
+/* floating point register dependence decoders */
+#define DFPR_L(N)		(((N)+32)&~1)
+#define DFPR_F(N)		(((N)+32)&~1)
+#define DFPR_D(N)		(((N)+32)&~1)
+
+/* miscellaneous register dependence decoders */
+#define DHI			(0+32+32)
+#define DLO			(1+32+32)
+#define DFCC			(2+32+32)
+#define DTMP			(3+32+32)
+
+#elif defined(TARGET_ALPHA)
+
+/* general register dependence decoders, $r31 maps to DNA (0) */
+#define DGPR(N)			(31 - (N))
+
+/* floating point register dependence decoders */
+#define DFPR(N)			(((N) == 31) ? DNA : ((N)+32))
+
+/* miscellaneous register dependence decoders */
+#define DFPCR			(0+32+32)
+#define DUNIQ			(1+32+32)
+#define DTMP			(2+32+32)
+
+#else
+#error No ISA target defined...
+#endif
+
+/* value of the register with dependence name NAME in XREGS, 0 for none */
+static qword_t
+dep_value(struct regs_t *xregs, int name)
+{
+  if (name == DNA)
+    return 0;
+
+#if defined(TARGET_PISA)
+  if (name < 32)
+    return (qword_t)xregs->regs_R[name];
+  if (name < 64)
+    return ((qword_t)(word_t)xregs->regs_F.l[name - 32]
+	    | ((qword_t)(word_t)xregs->regs_F.l[name - 32 + 1] << 32));
+  switch (name)
+    {
+    case DHI:	return (qword_t)xregs->regs_C.hi;
+    case DLO:	return (qword_t)xregs->regs_C.lo;
+    case DFCC:	return (qword_t)xregs->regs_C.fcc;
+    }
+#elif defined(TARGET_ALPHA)
+  if (name < 32)
+    return xregs->regs_R[31 - name];
+  if (name < 64)
+    return xregs->regs_F.q[name - 32];
+  switch (name)
+    {
+    case DFPCR:	return xregs->regs_C.fpcr;
+    case DUNIQ:	return xregs->regs_C.uniq;
+    }
+#endif
+
+  return 0;
+}
+
+/* fill in REC for the instruction at REGS->REGS_PC just executed on REGS
+   and MEM, with output register dependence names OUT1 and OUT2 (as
+   decoded by sim-outorder), effective address ADDR and IS_WRITE set for a
+   store */
+void
+lockstep_rec_fill(struct lockstep_rec_t *rec,	/* record to fill in */
+		  struct regs_t *xregs,		/* registers after execution */
+		  struct mem_t *xmem,		/* memory after execution */
+		  int out1, int out2,		/* output dependence names */
+		  md_addr_t addr,		/* effective address */
+		  int is_write)			/* store? */
+{
+  rec->PC = xregs->regs_PC;
+  rec->NPC = xregs->regs_NPC;
+  rec->out[0] = dep_value(xregs, out1);
+  rec->out[1] = dep_value(xregs, out2);
+  rec->addr = addr;
+  rec->data = is_write
+    ? MEM_READ_QWORD(xmem, addr & ~(md_addr_t)(sizeof(qword_t)-1)) : 0;
+}
+
+/* FNV-1a step over the eight bytes of VAL */
+#define DIGEST_PRIME		ULL(0x100000001b3)
+static qword_t
+digest_qword(qword_t digest, qword_t val)
+{
+  int i;
+
+  for (i=0; i < 8; i++)
+    {
+      digest ^= (val >> (i * 8)) & 0xff;
+      digest *= DIGEST_PRIME;
+    }
+  return digest;
+}
+
+/* fold REC into the commit stream digest DIGEST, returns the new digest */
+qword_t
+lockstep_digest(qword_t digest,			/* digest so far */
+		struct lockstep_rec_t *rec)	/* committed instruction */
+{
+  digest = digest_qword(digest, (qword_t)rec->PC);
+  digest = digest_qword(digest, rec->out[0]);
+  digest = digest_qword(digest, rec->out[1]);
+  digest = digest_qword(digest, (qword_t)rec->addr);
+  digest = digest_qword(digest, rec->data);
+  return digest;
+}
+
+
+/*
+ * the functional core
+ */
+
+/* start lockstep checking from the architected state REGS and MEM, the
+   functional core runs on its own copy of both */
+void
+lockstep_init(struct regs_t *xregs,		/* architected registers */
+	      struct mem_t *xmem)		/* architected memory */
+{
+  regs = *xregs;
+  mem = mem_create("lockstep");
+  mem_init(mem);
+  mem_copy(mem, xmem);
+  sys_regs_valid = FALSE;
+  lockstep_insn = 0;
+}
+
+/* memory access function for system calls executed by the timing
+   simulator, system call writes are mirrored into the functional core's
+   memory */
+enum md_fault_type
+lockstep_mem_access(struct mem_t *xmem,		/* memory space to access */
+		    enum mem_cmd cmd,		/* Read or Write */
+		    md_addr_t addr,		/* target address to access */
+		    void *p,			/* where to copy to/from */
+		    int nbytes)			/* transfer length in bytes */
+{
+  enum md_fault_type fault;
+
+  fault = mem_access(xmem, cmd, addr, p, nbytes);
+  if (fault == md_fault_none && cmd == Write && mem)
+    fault = mem_access(mem, Write, addr, p, nbytes);
+  return fault;
+}
+
+/* record REGS, the registers after a system call executed by the timing
+   simulator, for the functional core to take when it reaches the call */
+void
+lockstep_syscall(struct regs_t *xregs)		/* registers after the call */
+{
+  /* not checking yet */
+  if (!mem)
+    return;
+
+  if (sys_regs_valid)
+    panic("system call executed before the last one was checked");
+  sys_regs = *xregs;
+  sys_regs_valid = TRUE;
+}
+
+/*
+ * precise architected register accessors
+ */
+
+/* next program counter */
+#define SET_NPC(EXPR)		(regs.regs_NPC = (EXPR))
+
+/* current program counter */
+#define CPC			(regs.regs_PC)
+
+/* general purpose registers */
+#define GPR(N)			(regs.regs_R[N])
+#define SET_GPR(N,EXPR)		(regs.regs_R[N] = (EXPR))
+
+#if defined(TARGET_PISA)
+
+/* floating point registers, L->word, F->single-prec, D->double-prec */
+#define FPR_L(N)		(regs.regs_F.l[(N)])
+#define SET_FPR_L(N,EXPR)	(regs.regs_F.l[(N)] = (EXPR))
+#define FPR_F(N)		(regs.regs_F.f[(N)])
+#define SET_FPR_F(N,EXPR)	(regs.regs_F.f[(N)] = (EXPR))
+#define FPR_D(N)		(regs.regs_F.d[(N) >> 1])
+#define SET_FPR_D(N,EXPR)	(regs.regs_F.d[(N) >> 1] = (EXPR))
+
+/* miscellaneous register accessors */
+#define SET_HI(EXPR)		(regs.regs_C.hi = (EXPR))
+#define HI			(regs.regs_C.hi)
+#define SET_LO(EXPR)		(regs.regs_C.lo = (EXPR))
+#define LO			(regs.regs_C.lo)
+#define FCC			(regs.regs_C.fcc)
+#define SET_FCC(EXPR)		(regs.regs_C.fcc = (EXPR))
+
+#elif defined(TARGET_ALPHA)
+
+/* floating point registers, L->word, F->single-prec, D->double-prec */
+#define FPR_Q(N)		(regs.regs_F.q[N])
+#define SET_FPR_Q(N,EXPR)	(regs.regs_F.q[N] = (EXPR))
+#define FPR(N)			(regs.regs_F.d[(N)])
+#define SET_FPR(N,EXPR)		(regs.regs_F.d[(N)] = (EXPR))
+
+/* miscellaneous register accessors */
+#define FPCR			(regs.regs_C.fpcr)
+#define SET_FPCR(EXPR)		(regs.regs_C.fpcr = (EXPR))
+#define UNIQ			(regs.regs_C.uniq)
+#define SET_UNIQ(EXPR)		(regs.regs_C.uniq = (EXPR))
+
+#else
+#error No ISA target defined...
+#endif
+
+/* precise architected memory state accessor macros */
+#define READ_BYTE(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_BYTE(mem, addr))
+#define READ_HALF(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_HALF(mem, addr))
+#define READ_WORD(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_WORD(mem, addr))
+#ifdef HOST_HAS_QWORD
+#define READ_QWORD(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_QWORD(mem, addr))
+#endif /* HOST_HAS_QWORD */
+
+#define WRITE_BYTE(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_BYTE(mem, addr, (SRC)))
+#define WRITE_HALF(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_HALF(mem, addr, (SRC)))
+#define WRITE_WORD(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_WORD(mem, addr, (SRC)))
+#ifdef HOST_HAS_QWORD
+#define WRITE_QWORD(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_QWORD(mem, addr, (SRC)))
+#endif /* HOST_HAS_QWORD */
+
+
+/* system calls are not executed, the registers left by the timing
+   simulator's execution of the call are taken instead */
+#define SYSCALL(INST)							\
+  (sys_regs_valid							\
+   ? (regs = sys_regs, sys_regs_valid = FALSE)				\
+   : (fatal("lockstep: system call not executed by the timing simulator"), 0))
+
+/* print REC, from SRC, to STREAM */
+static void
+rec_print(FILE *stream, char *src, struct lockstep_rec_t *rec)
+{
+  fprintf(stream, "  %-10s", src);
+  myfprintf(stream, " PC 0x%08p NPC 0x%08p out 0x%016lx 0x%016lx",
+	    rec->PC, rec->NPC, rec->out[0], rec->out[1]);
+  myfprintf(stream, " addr 0x%08p data 0x%016lx\n", rec->addr, rec->data);
+}
+
+/* step the functional core over the instruction committed at cycle NOW
+   and check it against REC, a divergence is fatal */
+void
+lockstep_check(struct lockstep_rec_t *rec,	/* committed instruction */
+	       tick_t now)			/* commit cycle */
+{
+  int i, out1, out2;
+  md_inst_t inst;
+  md_addr_t addr;
+  enum md_opcode op;
+  enum md_fault_type fault;
+  struct lockstep_rec_t *exp;
+
+  /* execute up to the next instruction that occupies the timing
+     simulator's window, NOPs are dropped at dispatch */
+  do
+    {
+      /* maintain $r0 semantics */
+      regs.regs_R[MD_REG_ZERO] = 0;
+#ifdef TARGET_ALPHA
+      regs.regs_F.d[MD_REG_ZERO] = 0.0;
+#endif /* TARGET_ALPHA */
+
+      /* get the next instruction to execute */
+      MD_FETCH_INST(inst, mem, regs.regs_PC);
+
+      /* set default next PC, outputs, reference address and fault */
+      regs.regs_NPC = regs.regs_PC + sizeof(md_inst_t);
+      out1 = out2 = DNA;
+      addr = 0;
+      fault = md_fault_none;
+
+      /* decode the instruction */
+      MD_SET_OPCODE(op, inst);
+
+      /* execute the instruction */
+      switch (op)
+	{
+#define DEFINST(OP,MSK,NAME,OPFORM,RES,FLAGS,O1,O2,I1,I2,I3)		\
+	case OP:							\
+	  out1 = O1; out2 = O2;						\
+	  SYMCAT(OP,_IMPL);						\
+	  break;
+#define DEFLINK(OP,MSK,NAME,MASK,SHIFT)					\
+	case OP:							\
+	  /* decoded as a NOP, as sim-outorder does */			\
+	  op = MD_NOP_OP;						\
+	  break;
+#define CONNECT(OP)
+#define DECLARE_FAULT(FAULT)						\
+	  { fault = (FAULT); break; }
+#include "machine.def"
+	default:
+	  op = MD_NOP_OP;
+	}
+
+      if (fault != md_fault_none)
+	fatal("lockstep: fault (%d) detected @ 0x%08p", fault, regs.regs_PC);
+
+      if (op == MD_NOP_OP)
+	{
+	  /* go to the next instruction */
+	  regs.regs_PC = regs.regs_NPC;
+	}
+    }
+  while (op == MD_NOP_OP);
+
+  /* compare against the committed instruction */
+  exp = &hist[lockstep_insn % LOCKSTEP_HIST];
+  lockstep_rec_fill(exp, &regs, mem, out1, out2,
+		    (MD_OP_FLAGS(op) & F_MEM) ? addr : 0,
+		    (MD_OP_FLAGS(op) & F_STORE) != 0);
+  lockstep_insn++;
+
+  if (exp->PC != rec->PC || exp->NPC != rec->NPC
+      || exp->out[0] != rec->out[0] || exp->out[1] != rec->out[1]
+      || exp->addr != rec->addr || exp->data != rec->data)
+    {
+      myfprintf(stderr, "lockstep: divergence at committed instruction %n, "
+		"cycle %n:\n", lockstep_insn, (counter_t)now);
+      fprintf(stderr, "  ");
+      md_print_insn(inst, exp->PC, stderr);
+      fprintf(stderr, "\n");
+      rec_print(stderr, "timing", rec);
+      rec_print(stderr, "functional", exp);
+      fprintf(stderr, "lockstep: preceding committed instructions:\n");
+      for (i=LOCKSTEP_HIST-1; i > 0; i--)
+	{
+	  if (lockstep_insn <= (counter_t)i)
+	    continue;
+	  rec_print(stderr, "",
+		    &hist[(lockstep_insn - 1 - i) % LOCKSTEP_HIST]);
+	}
+      fatal("commit stream diverged from the functional simulator");
+    }
+
+  /* go to the next instruction */
+  regs.regs_PC = regs.regs_NPC;
+}
@@ -0,0 +1,135 @@
+/* lockstep.h - commit stream digest and lockstep checker interfaces */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+
+#ifndef LOCKSTEP_H
+#define LOCKSTEP_H
+
+#include <stdio.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "regs.h"
+#include "memory.h"
+
+/*
+ * This module checks the committed instruction stream of a timing
+ * simulator.  Each committed instruction is summarized by a record of its
+ * PC, next PC, output register values and store data.  The records are
+ * folded into a rolling digest with lockstep_digest(), so two runs (e.g.,
+ * with and without eager execution) can be compared by a single stat.  With
+ * lockstep checking on, each record is also compared against a functional
+ * core, in the style of sim-safe, stepped once per committed instruction
+ * over its own copy of the architected state; the first divergence stops
+ * the simulation with the recent commit history.
+ *
+ * The functional core does not execute system calls, it takes their
+ * results from the timing simulator: the timing simulator passes
+ * lockstep_mem_access() to sys_syscall(), which mirrors the system call's
+ * memory writes, and then calls lockstep_syscall() with the resulting
+ * registers.
+ */
+
+/* a committed instruction */
+struct lockstep_rec_t {
+  md_addr_t PC;			/* instruction address */
+  md_addr_t NPC;		/* next PC */
+  qword_t out[2];		/* output register values, 0 if unused */
+  md_addr_t addr;		/* effective address of a load or store */
+  qword_t data;			/* after a store, the stored-to quadword */
+};
+
+/* fill in REC for the instruction at REGS->REGS_PC just executed on REGS
+   and MEM, with output register dependence names OUT1 and OUT2 (as
+   decoded by sim-outorder), effective address ADDR and IS_WRITE set for a
+   store */
+void
+lockstep_rec_fill(struct lockstep_rec_t *rec,	/* record to fill in */
+		  struct regs_t *regs,		/* registers after execution */
+		  struct mem_t *mem,		/* memory after execution */
+		  int out1, int out2,		/* output dependence names */
+		  md_addr_t addr,		/* effective address */
+		  int is_write);		/* store? */
+
+/* fold REC into the commit stream digest DIGEST, returns the new digest */
+qword_t
+lockstep_digest(qword_t digest,			/* digest so far */
+		struct lockstep_rec_t *rec);	/* committed instruction */
+
+/* start lockstep checking from the architected state REGS and MEM, the
+   functional core runs on its own copy of both */
+void
+lockstep_init(struct regs_t *regs,		/* architected registers */
+	      struct mem_t *mem);		/* architected memory */
+
+/* memory access function for system calls executed by the timing
+   simulator, system call writes are mirrored into the functional core's
+   memory */
+enum md_fault_type
+lockstep_mem_access(struct mem_t *mem,		/* memory space to access */
+		    enum mem_cmd cmd,		/* Read or Write */
+		    md_addr_t addr,		/* target address to access */
+		    void *p,			/* where to copy to/from */
+		    int nbytes);		/* transfer length in bytes */
+
+/* record REGS, the registers after a system call executed by the timing
+   simulator, for the functional core to take when it reaches the call */
+void
+lockstep_syscall(struct regs_t *regs);		/* registers after the call */
+
+/* step the functional core over the instruction committed at cycle NOW
+   and check it against REC, a divergence is fatal */
+void
+lockstep_check(struct lockstep_rec_t *rec,	/* committed instruction */
+	       tick_t now);			/* commit cycle */
+
+#endif /* LOCKSTEP_H */
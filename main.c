@@ -131,6 +131,12 @@ static char *sim_simout = NULL;
 static char *sim_progout = NULL;
 FILE *sim_progfd = NULL;
 
+/* stats output format and machine-readable stats output file name */
+enum stats_format_t { sf_text, sf_json, sf_csv, sf_NUM };
+static char *stats_format_emap[sf_NUM] = { "text", "json", "csv" };
+static int stats_format;
+static char *sim_statout = NULL;
+
 /* track first argument orphan, this is the program to execute */
 static int exec_index = -1;
 
@@ -184,6 +190,27 @@ usage(FILE *fd, int argc, char **argv)
 
 static int running = FALSE;
 
+/* print all simulator options and stats in the machine-readable FORMAT */
+static void
+print_stats_as(FILE *fd,		/* output stream */
+	       int format)		/* stats format, sf_json or sf_csv */
+{
+  if (format == sf_json)
+    {
+      fprintf(fd, "{\n\"options\": ");
+      opt_print_options_json(sim_odb, fd);
+      fprintf(fd, ",\n\"stats\": ");
+      stat_print_stats_json(sim_sdb, fd);
+      fprintf(fd, "\n}\n");
+    }
+  else
+    {
+      fprintf(fd, "section,name,index,value\n");
+      opt_print_options_csv(sim_odb, fd);
+      stat_print_stats_csv(sim_sdb, fd);
+    }
+}
+
 /* print all simulator stats */
 void
 sim_print_stats(FILE *fd)		/* output stream */
@@ -204,10 +231,36 @@ sim_print_stats(FILE *fd)		/* output stream */
   sim_mem_usage = (sbrk(0) - &etext) / 1024;
 #endif
 
+  /* write the stats file, rewritten each time stats are printed */
+  if (sim_statout != NULL)
+    {
+      FILE *sfd = fopen(sim_statout, "w");
+
+      /* no fatal(), this may be running in the fatal() hook */
+      if (!sfd)
+	warn("unable to write stats to file `%s'", sim_statout);
+      else
+	{
+	  if (stats_format == sf_text)
+	    {
+	      stat_print_stats(sim_sdb, sfd);
+	      sim_aux_stats(sfd);
+	    }
+	  else
+	    print_stats_as(sfd, stats_format);
+	  fclose(sfd);
+	}
+    }
+
   /* print simulation stats */
   fprintf(fd, "\nsim: ** simulation statistics **\n");
-  stat_print_stats(sim_sdb, fd);
-  sim_aux_stats(fd);
+  if (stats_format == sf_text || sim_statout != NULL)
+    {
+      stat_print_stats(sim_sdb, fd);
+      sim_aux_stats(fd);
+    }
+  else
+    print_stats_as(fd, stats_format);
   fprintf(fd, "\n");
 }
 
@@ -285,7 +338,18 @@ main(int argc, char **argv, char **envp)
 	      /* default */NICE_DEFAULT_VALUE, /* print */TRUE, NULL);
 #endif
 
-  /* FIXME: add stats intervals and max insts... */
+  /* stats output options */
+  opt_reg_enum(sim_odb, "-stats:format",
+	       "stats output format {text|json|csv}",
+	       &stats_format, /* default */"text",
+	       stats_format_emap, /* index map */NULL, sf_NUM,
+	       /* print */TRUE, /* format */NULL);
+  opt_reg_string(sim_odb, "-stats:out",
+		 "also write the stats in `-stats:format' to file, simulator "
+		 "output keeps the text stats",
+		 &sim_statout, /* default */NULL, /* print */TRUE, NULL);
+
+  /* FIXME: add max insts... */
 
   /* register all simulator-specific options */
   sim_reg_options(sim_odb);
@@ -51,6 +51,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "host.h"
 #include "misc.h"
@@ -262,6 +263,33 @@ mem_init(struct mem_t *mem)	/* memory space to initialize */
   mem->ptab_accesses = 0;
 }
 
+/* copy the contents of every page allocated in memory space SRC into memory
+   space DST, allocating the pages in DST as needed */
+void
+mem_copy(struct mem_t *dst,		/* memory space to copy to */
+	 struct mem_t *src)		/* memory space to copy from */
+{
+  int i;
+  md_addr_t addr;
+  byte_t *page;
+  struct mem_pte_t *pte;
+
+  for (i=0; i < MEM_PTAB_SIZE; i++)
+    {
+      for (pte=src->ptab[i]; pte != NULL; pte=pte->next)
+	{
+	  addr = MEM_PTE_ADDR(pte, i);
+	  page = mem_translate(dst, addr);
+	  if (!page)
+	    {
+	      mem_newpage(dst, addr);
+	      page = mem_translate(dst, addr);
+	    }
+	  memcpy(page, pte->page, MD_PAGE_SIZE);
+	}
+    }
+}
+
 /* dump a block of memory, returns any faults encountered */
 enum md_fault_type
 mem_dump(struct mem_t *mem,		/* memory space to display */
@@ -237,6 +237,12 @@ mem_reg_stats(struct mem_t *mem,	/* memory space to declare */
 void
 mem_init(struct mem_t *mem);	/* memory space to initialize */
 
+/* copy the contents of every page allocated in memory space SRC into memory
+   space DST, allocating the pages in DST as needed */
+void
+mem_copy(struct mem_t *dst,		/* memory space to copy to */
+	 struct mem_t *src);		/* memory space to copy from */
+
 /* dump a block of memory, returns any faults encountered */
 enum md_fault_type
 mem_dump(struct mem_t *mem,		/* memory space to display */
@@ -59,6 +59,10 @@
 #if defined(__alpha) || defined(linux)
 #include <unistd.h>
 #endif /* __alpha || linux */
+#ifndef _MSC_VER
+#include <time.h>
+#include <sys/time.h>
+#endif /* !_MSC_VER */
 
 #include "host.h"
 #include "misc.h"
@@ -354,6 +358,63 @@ elapsed_time(long sec)
   return tstr;
 }
 
+/* host time in nanoseconds since an arbitrary origin, for self-profiling */
+double
+host_nsecs(void)
+{
+#if defined(CLOCK_MONOTONIC)
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+#elif !defined(_MSC_VER)
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec * 1e9 + (double)tv.tv_usec * 1e3;
+#else /* _MSC_VER */
+  return (double)clock() * (1e9 / CLOCKS_PER_SEC);
+#endif
+}
+
+/* print string S as a quoted JSON string */
+void
+json_print_string(FILE *fd, char *s)
+{
+  fputc('"', fd);
+  for (; *s; s++)
+    {
+      if (*s == '"' || *s == '\\')
+	fprintf(fd, "\\%c", *s);
+      else if ((unsigned char)*s < ' ')
+	fprintf(fd, "\\u%04x", (unsigned char)*s);
+      else
+	fputc(*s, fd);
+    }
+  fputc('"', fd);
+}
+
+/* print string S as a CSV field, quoted only if it has to be */
+void
+csv_print_string(FILE *fd, char *s)
+{
+  if (!strpbrk(s, ",\"\r\n"))
+    {
+      fputs(s, fd);
+      return;
+    }
+
+  /* quoted field, embedded quotes are doubled */
+  fputc('"', fd);
+  for (; *s; s++)
+    {
+      if (*s == '"')
+	fputc('"', fd);
+      fputc(*s, fd);
+    }
+  fputc('"', fd);
+}
+
 /* assume bit positions numbered 31 to 0 (31 high order bit), extract num bits
    from word starting at position pos (with pos as the high order bit of those
    to be extracted), result is right justified and zero filled to high order
@@ -206,6 +206,15 @@ int log_base2(int n);
 /* return string describing elapsed time, passed in SEC in seconds */
 char *elapsed_time(long sec);
 
+/* host time in nanoseconds since an arbitrary origin, for self-profiling */
+double host_nsecs(void);
+
+/* print string S as a quoted JSON string */
+void json_print_string(FILE *fd, char *s);
+
+/* print string S as a CSV field, quoted only if it has to be */
+void csv_print_string(FILE *fd, char *s);
+
 /* assume bit positions numbered 31 to 0 (31 high order bit), extract num bits
    from word starting at position pos (with pos as the high order bit of those
    to be extracted), result is right justified and zero filled to high order
@@ -1520,6 +1520,130 @@ opt_print_options(struct opt_odb_t *odb,/* option data base */
     print_option_notes(odb, fd);
 }
 
+/* print element I of option OPT as a JSON value, or as a CSV field if !JSON */
+static void
+print_opt_value(struct opt_opt_t *opt,	/* option variable */
+		int i,			/* list element */
+		int json,		/* JSON value? */
+		FILE *fd)		/* output stream */
+{
+  char *estr;
+
+  switch (opt->oc)
+    {
+    case oc_int:
+      fprintf(fd, "%d", opt->variant.for_int.var[i]);
+      break;
+    case oc_uint:
+      fprintf(fd, "%u", opt->variant.for_uint.var[i]);
+      break;
+    case oc_float:
+      fprintf(fd, "%.12g", (double)opt->variant.for_float.var[i]);
+      break;
+    case oc_double:
+      fprintf(fd, "%.12g", opt->variant.for_double.var[i]);
+      break;
+    case oc_flag:
+      fputs(opt->variant.for_enum.var[i] ? "true" : "false", fd);
+      break;
+    case oc_enum:
+      estr = bind_to_str(opt->variant.for_enum.var[i],
+			 opt->variant.for_enum.emap,
+			 opt->variant.for_enum.eval,
+			 opt->variant.for_enum.emap_sz);
+      if (!estr)
+	panic("could not bind enum `%d' for option `%s'",
+	      opt->variant.for_enum.var[i], opt->name);
+      if (json)
+	json_print_string(fd, estr);
+      else
+	csv_print_string(fd, estr);
+      break;
+    case oc_string:
+      if (!opt->variant.for_string.var[i])
+	{
+	  if (json)
+	    fprintf(fd, "null");
+	}
+      else if (json)
+	json_print_string(fd, opt->variant.for_string.var[i]);
+      else
+	csv_print_string(fd, opt->variant.for_string.var[i]);
+      break;
+    default:
+      panic("bogus option class");
+    }
+}
+
+/* print all options and current values as a JSON object, one member per
+   option, list options are arrays */
+void
+opt_print_options_json(struct opt_odb_t *odb,/* option data base */
+		       FILE *fd)	/* output stream */
+{
+  struct opt_opt_t *opt;
+  int i, nelt;
+
+  fprintf(fd, "{");
+  for (opt=odb ? odb->options : NULL; opt != NULL; opt=opt->next)
+    {
+      fprintf(fd, "\n  ");
+      json_print_string(fd, opt->name);
+      fprintf(fd, ": ");
+      if (opt->nvars > 1)
+	{
+	  nelt = opt->nelt ? *opt->nelt : opt->nvars;
+	  fprintf(fd, "[");
+	  for (i=0; i<nelt; i++)
+	    {
+	      if (i != 0)
+		fprintf(fd, ", ");
+	      print_opt_value(opt, i, /* json */TRUE, fd);
+	    }
+	  fprintf(fd, "]");
+	}
+      else if (opt_null_string(opt))
+	fprintf(fd, "null");
+      else
+	print_opt_value(opt, 0, /* json */TRUE, fd);
+      if (opt->next)
+	fprintf(fd, ",");
+    }
+  fprintf(fd, "\n}");
+}
+
+/* print all options and current values as CSV rows of the form
+   `option,<name>,<list index>,<value>', the list index is empty for options
+   that are not lists */
+void
+opt_print_options_csv(struct opt_odb_t *odb,/* option data base */
+		      FILE *fd)		/* output stream */
+{
+  struct opt_opt_t *opt;
+  int i, nelt;
+
+  for (opt=odb ? odb->options : NULL; opt != NULL; opt=opt->next)
+    {
+      if (opt->nvars > 1)
+	{
+	  nelt = opt->nelt ? *opt->nelt : opt->nvars;
+	  for (i=0; i<nelt; i++)
+	    {
+	      fprintf(fd, "option,%s,%d,", opt->name, i);
+	      print_opt_value(opt, i, /* !json */FALSE, fd);
+	      fprintf(fd, "\n");
+	    }
+	}
+      else
+	{
+	  fprintf(fd, "option,%s,,", opt->name);
+	  if (!opt_null_string(opt))
+	    print_opt_value(opt, 0, /* !json */FALSE, fd);
+	  fprintf(fd, "\n");
+	}
+    }
+}
+
 /* print help information for an option */
 static void
 print_help(struct opt_opt_t *opt,	/* option variable */
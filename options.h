@@ -336,6 +336,19 @@ opt_print_options(struct opt_odb_t *odb,/* option data base */
 		  int terse,		/* print terse options? */
 		  int notes);		/* include notes? */
 
+/* print all options and current values as a JSON object, one member per
+   option, list options are arrays */
+void
+opt_print_options_json(struct opt_odb_t *odb,/* option data base */
+		       FILE *fd);	/* output stream */
+
+/* print all options and current values as CSV rows of the form
+   `option,<name>,<list index>,<value>', the list index is empty for options
+   that are not lists */
+void
+opt_print_options_csv(struct opt_odb_t *odb,/* option data base */
+		      FILE *fd);	/* output stream */
+
 /* print option help page with default values */
 void
 opt_print_help(struct opt_odb_t *odb,	/* option data base */
@@ -83,22 +83,28 @@ while (<TRC_FILE>)
     chop;
 
     # new instruction
-    if (/^\+\s+(\d+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(.*)\n?$/)
+    if (/^\+\s+(\d+)\s+(0x[0-9a-fA-F]+)\s+(0x[0-9a-fA-F]+)\s+(\d+\/\d+\/-?\d+\s+)?(.*)\n?$/)
       {
 	# register this instruction in the live instruction hash table
 	$insts{$1} = 1;
 	$insts_pc{$1} = $2;
 	$insts_addr{$1} = $3;
-	$insts_asm{$1} = $4;
+	$insts_asm{$1} = $5;
 	$insts_iid{$1} = 
 	    chr ((ord("a") + (($1 / 26) % 26))) .
 	    chr (ord("a") + ($1 % 26));
 
-	# print instruction id and asm info
-	print "$insts_iid{$1} = `$2: $4'\n";
+	# print instruction id and asm info, and the eager path if traced
+	$pseq = $1;
+	$path = $4;
+	$path =~ s/\s+$//;
+	if ($path ne "")
+	  { print "$insts_iid{$pseq} = `$insts_pc{$pseq}: $insts_asm{$pseq}' [$path]\n"; }
+	else
+	  { print "$insts_iid{$pseq} = `$insts_pc{$pseq}: $insts_asm{$pseq}'\n"; }
       }
     # deleted instruction
-    elsif (/^\-\s+(\d+)\n?$/)
+    elsif (/^\-\s+(\d+)(\s+\w+)?\n?$/)
       {
 	# record deletion, these are processed after pipe info is printed
 	@dead_pseqs = ($1, @dead_pseqs);
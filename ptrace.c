@@ -51,6 +51,10 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef HOST_HAS_PTHREADS
+#include <pthread.h>
+#endif /* HOST_HAS_PTHREADS */
 
 #include "host.h"
 #include "misc.h"
@@ -61,6 +65,9 @@
 /* pipetrace file */
 FILE *ptrace_outfd = NULL;
 
+/* write the pipetrace in the binary format */
+int ptrace_binary = FALSE;
+
 /* pipetracing is active */
 int ptrace_active = FALSE;
 
@@ -70,6 +77,258 @@ struct range_range_t ptrace_range;
 /* one-shot switch for pipetracing */
 int ptrace_oneshot = FALSE;
 
+/*
+ * binary pipetrace writer: records are encoded into a ring of large buffers,
+ * filled buffers are handed to a writer thread (if the host has POSIX
+ * threads, else they are written in place) so the simulator only blocks on
+ * the trace file when the whole ring is waiting to be written
+ */
+
+/* size of each trace buffer, and the number of buffers in the ring */
+#define PTB_BUF_SIZE		(4*1024*1024)
+#define PTB_NUM_BUFS		4
+
+/* worst-case size of a record, other than its uop description */
+#define PTB_MAX_REC		(64 + sizeof(md_inst_t))
+
+static unsigned char *ptb_bufs[PTB_NUM_BUFS];	/* buffer ring */
+static int ptb_lens[PTB_NUM_BUFS];		/* bytes in each filled buffer */
+static int ptb_head;				/* buffer being filled */
+static unsigned char *ptb_p, *ptb_end;		/* fill pointer, and limit */
+
+/* encoder state, deltas are taken against these */
+static unsigned int ptb_last_iseq;
+static md_addr_t ptb_last_pc;
+static tick_t ptb_last_cycle;
+
+/* PC -> instruction bits already sent, open addressed on the PC */
+static md_addr_t *ptb_text_pcs;
+static md_inst_t *ptb_text_insts;
+static int ptb_text_size, ptb_text_num;
+
+#ifdef HOST_HAS_PTHREADS
+static pthread_t ptb_writer;
+static pthread_mutex_t ptb_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t ptb_filled = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t ptb_drained = PTHREAD_COND_INITIALIZER;
+static int ptb_tail;				/* oldest filled buffer */
+static int ptb_nfull;				/* filled buffers */
+static int ptb_done;				/* no more buffers coming */
+static int ptb_error;				/* a buffer could not be written */
+
+/* writer thread, writes filled buffers out in ring order; a write error is
+   only recorded, it is reported by the simulator thread (fatal() prints the
+   stats and exits, which must not happen from here) */
+static void *
+ptb_write_bufs(void *arg)
+{
+  int buf, err;
+
+  for (;;)
+    {
+      pthread_mutex_lock(&ptb_lock);
+      while (!ptb_nfull && !ptb_done)
+	pthread_cond_wait(&ptb_filled, &ptb_lock);
+      if (!ptb_nfull)
+	{
+	  pthread_mutex_unlock(&ptb_lock);
+	  return NULL;
+	}
+      buf = ptb_tail;
+      pthread_mutex_unlock(&ptb_lock);
+
+      err = (fwrite(ptb_bufs[buf], 1, ptb_lens[buf], ptrace_outfd)
+	     != (size_t)ptb_lens[buf]);
+
+      pthread_mutex_lock(&ptb_lock);
+      if (err)
+	ptb_error = TRUE;
+      ptb_tail = (ptb_tail + 1) % PTB_NUM_BUFS;
+      ptb_nfull--;
+      pthread_cond_signal(&ptb_drained);
+      pthread_mutex_unlock(&ptb_lock);
+    }
+}
+
+/* report a write error recorded by the writer thread, only once */
+static void
+ptb_check_error(void)
+{
+  int err;
+
+  pthread_mutex_lock(&ptb_lock);
+  err = ptb_error;
+  ptb_error = FALSE;
+  pthread_mutex_unlock(&ptb_lock);
+  if (err)
+    fatal("could not write pipetrace");
+}
+#endif /* HOST_HAS_PTHREADS */
+
+/* hand the buffer being filled over to be written, and move on to the next
+   buffer in the ring */
+static void
+ptb_flush(void)
+{
+  ptb_lens[ptb_head] = ptb_p - ptb_bufs[ptb_head];
+  if (!ptb_lens[ptb_head])
+    return;
+
+#ifdef HOST_HAS_PTHREADS
+  pthread_mutex_lock(&ptb_lock);
+  ptb_nfull++;
+  pthread_cond_signal(&ptb_filled);
+  ptb_head = (ptb_head + 1) % PTB_NUM_BUFS;
+  while (ptb_nfull == PTB_NUM_BUFS)
+    pthread_cond_wait(&ptb_drained, &ptb_lock);
+  pthread_mutex_unlock(&ptb_lock);
+  ptb_check_error();
+#else /* !HOST_HAS_PTHREADS */
+  if (fwrite(ptb_bufs[ptb_head], 1, ptb_lens[ptb_head], ptrace_outfd)
+      != (size_t)ptb_lens[ptb_head])
+    fatal("could not write pipetrace");
+#endif /* HOST_HAS_PTHREADS */
+
+  ptb_p = ptb_bufs[ptb_head];
+  ptb_end = ptb_p + PTB_BUF_SIZE;
+}
+
+/* make room for a record of up to EXTRA bytes past PTB_MAX_REC */
+#define PTB_RESERVE(EXTRA)						\
+  do {									\
+    if (ptb_end - ptb_p < (long)(PTB_MAX_REC + (EXTRA)))		\
+      ptb_flush();							\
+  } while (0)
+
+/* encode an unsigned varint, seven bits per byte, low-order first */
+static void
+ptb_put_varint(qword_t val)
+{
+  while (val >= 0x80)
+    {
+      *ptb_p++ = (unsigned char)((val & 0x7f) | 0x80);
+      val >>= 7;
+    }
+  *ptb_p++ = (unsigned char)val;
+}
+
+/* encode a signed delta as a zig-zag varint */
+static void
+ptb_put_delta(sqword_t delta)
+{
+  ptb_put_varint(((qword_t)delta << 1) ^ (qword_t)(delta >> 63));
+}
+
+/* encode the sequence number, PC and path of a new instruction or uop */
+static void
+ptb_put_inst(unsigned int iseq, md_addr_t pc, md_addr_t addr,
+	     int thread, int fork, int level)
+{
+  ptb_put_delta((int)(iseq - ptb_last_iseq));
+  ptb_last_iseq = iseq;
+  ptb_put_delta((sqword_t)(pc - ptb_last_pc));
+  ptb_last_pc = pc;
+  ptb_put_varint(addr);
+  ptb_put_varint(thread);
+  ptb_put_varint(fork);
+  ptb_put_varint(level);
+}
+
+/* send the instruction bits at PC, unless they were sent before */
+static void
+ptb_put_text(md_addr_t pc, md_inst_t inst)
+{
+  int i;
+
+  /* grow the PC table at half occupancy */
+  if (2 * (ptb_text_num + 1) > ptb_text_size)
+    {
+      md_addr_t *old_pcs = ptb_text_pcs;
+      md_inst_t *old_insts = ptb_text_insts;
+      int old_size = ptb_text_size;
+
+      ptb_text_size = old_size ? 2 * old_size : 4096;
+      ptb_text_pcs = malloc(ptb_text_size * sizeof(md_addr_t));
+      ptb_text_insts = calloc(ptb_text_size, sizeof(md_inst_t));
+      if (!ptb_text_pcs || !ptb_text_insts)
+	fatal("out of virtual memory");
+      for (i = 0; i < ptb_text_size; i++)
+	ptb_text_pcs[i] = PTB_NO_PC;
+      for (i = 0; i < old_size; i++)
+	if (old_pcs[i] != PTB_NO_PC)
+	  {
+	    int j = (old_pcs[i] >> 2) & (ptb_text_size - 1);
+
+	    while (ptb_text_pcs[j] != PTB_NO_PC)
+	      j = (j + 1) & (ptb_text_size - 1);
+	    ptb_text_pcs[j] = old_pcs[i];
+	    ptb_text_insts[j] = old_insts[i];
+	  }
+      free(old_pcs);
+      free(old_insts);
+    }
+
+  i = (pc >> 2) & (ptb_text_size - 1);
+  while (ptb_text_pcs[i] != PTB_NO_PC && ptb_text_pcs[i] != pc)
+    i = (i + 1) & (ptb_text_size - 1);
+  if (ptb_text_pcs[i] == pc
+      && !memcmp(&ptb_text_insts[i], &inst, sizeof(md_inst_t)))
+    return;
+
+  if (ptb_text_pcs[i] == PTB_NO_PC)
+    ptb_text_num++;
+  ptb_text_pcs[i] = pc;
+  ptb_text_insts[i] = inst;
+
+  *ptb_p++ = PTB_TEXT;
+  ptb_put_varint(pc);
+  memcpy(ptb_p, &inst, sizeof(md_inst_t));
+  ptb_p += sizeof(md_inst_t);
+}
+
+/* start a binary pipetrace on the opened trace file */
+static void
+ptb_open(void)
+{
+  int i;
+
+  for (i = 0; i < PTB_NUM_BUFS; i++)
+    {
+      ptb_bufs[i] = malloc(PTB_BUF_SIZE);
+      if (!ptb_bufs[i])
+	fatal("out of virtual memory");
+    }
+  ptb_head = 0;
+  ptb_p = ptb_bufs[0];
+  ptb_end = ptb_p + PTB_BUF_SIZE;
+
+  memcpy(ptb_p, PTB_MAGIC, 4);
+  ptb_p += 4;
+  *ptb_p++ = PTB_VERSION;
+  *ptb_p++ = sizeof(md_inst_t);
+
+#ifdef HOST_HAS_PTHREADS
+  if (pthread_create(&ptb_writer, NULL, ptb_write_bufs, NULL) != 0)
+    fatal("cannot start the pipetrace writer thread");
+#endif /* HOST_HAS_PTHREADS */
+}
+
+/* write out what is left of a binary pipetrace */
+static void
+ptb_close(void)
+{
+  ptb_flush();
+#ifdef HOST_HAS_PTHREADS
+  pthread_mutex_lock(&ptb_lock);
+  ptb_done = TRUE;
+  pthread_cond_signal(&ptb_filled);
+  pthread_mutex_unlock(&ptb_lock);
+  pthread_join(ptb_writer, NULL);
+  ptb_check_error();
+#endif /* HOST_HAS_PTHREADS */
+  fflush(ptrace_outfd);
+}
+
 /* open pipeline trace */
 void
 ptrace_open(char *fname,		/* output filename */
@@ -104,16 +363,21 @@ ptrace_open(char *fname,		/* output filename */
     ptrace_outfd = stdout;
   else
     {
-      ptrace_outfd = fopen(fname, "w");
+      ptrace_outfd = fopen(fname, ptrace_binary ? "wb" : "w");
       if (!ptrace_outfd)
 	fatal("cannot open pipetrace output file `%s'", fname);
     }
+
+  if (ptrace_binary)
+    ptb_open();
 }
 
 /* close pipeline trace */
 void
 ptrace_close(void)
 {
+  if (ptrace_binary && ptrace_outfd != NULL)
+    ptb_close();
   if (ptrace_outfd != NULL && ptrace_outfd != stderr && ptrace_outfd != stdout)
     fclose(ptrace_outfd);
 }
@@ -123,9 +387,22 @@ void
 __ptrace_newinst(unsigned int iseq,	/* instruction sequence number */
 		 md_inst_t inst,	/* new instruction */
 		 md_addr_t pc,		/* program counter of instruction */
-		 md_addr_t addr)	/* address referenced, if load/store */
+		 md_addr_t addr,	/* address referenced, if load/store */
+		 int thread,		/* fetching thread */
+		 int fork,		/* forks spun off by thread so far */
+		 int level)		/* mis-speculation level */
 {
-  myfprintf(ptrace_outfd, "+ %u 0x%08p 0x%08p ", iseq, pc, addr);
+  if (ptrace_binary)
+    {
+      PTB_RESERVE(PTB_MAX_REC);
+      ptb_put_text(pc, inst);
+      *ptb_p++ = PTB_NEWINST;
+      ptb_put_inst(iseq, pc, addr, thread, fork, level);
+      return;
+    }
+
+  myfprintf(ptrace_outfd, "+ %u 0x%08p 0x%08p %d/%d/%d ",
+	    iseq, pc, addr, thread, fork, level);
   md_print_insn(inst, addr, ptrace_outfd);
   fprintf(ptrace_outfd, "\n");
 
@@ -138,10 +415,26 @@ void
 __ptrace_newuop(unsigned int iseq,	/* instruction sequence number */
 		char *uop_desc,		/* new uop description */
 		md_addr_t pc,		/* program counter of instruction */
-		md_addr_t addr)		/* address referenced, if load/store */
+		md_addr_t addr,		/* address referenced, if load/store */
+		int thread,		/* fetching thread */
+		int fork,		/* forks spun off by thread so far */
+		int level)		/* mis-speculation level */
 {
-  myfprintf(ptrace_outfd,
-	    "+ %u 0x%08p 0x%08p [%s]\n", iseq, pc, addr, uop_desc);
+  if (ptrace_binary)
+    {
+      int len = MIN(strlen(uop_desc), PTB_MAX_UOP);
+
+      PTB_RESERVE(len);
+      *ptb_p++ = PTB_NEWUOP;
+      ptb_put_inst(iseq, pc, addr, thread, fork, level);
+      ptb_put_varint(len);
+      memcpy(ptb_p, uop_desc, len);
+      ptb_p += len;
+      return;
+    }
+
+  myfprintf(ptrace_outfd, "+ %u 0x%08p 0x%08p %d/%d/%d [%s]\n",
+	    iseq, pc, addr, thread, fork, level, uop_desc);
 
   if (ptrace_outfd == stderr || ptrace_outfd == stdout)
     fflush(ptrace_outfd);
@@ -149,9 +442,25 @@ __ptrace_newuop(unsigned int iseq,	/* instruction sequence number */
 
 /* declare instruction retirement or squash */
 void
-__ptrace_endinst(unsigned int iseq)	/* instruction sequence number */
+__ptrace_endinst(unsigned int iseq,	/* instruction sequence number */
+		 int reason)		/* why it ended, PEND_* */
 {
-  fprintf(ptrace_outfd, "- %u\n", iseq);
+  static char *reasons[PEND_NUM] = PEND_NAMES;
+
+  if (reason < 0 || reason >= PEND_NUM)
+    panic("bogus instruction end reason");
+
+  if (ptrace_binary)
+    {
+      PTB_RESERVE(0);
+      *ptb_p++ = PTB_ENDINST;
+      ptb_put_delta((int)(iseq - ptb_last_iseq));
+      ptb_last_iseq = iseq;
+      *ptb_p++ = (unsigned char)reason;
+      return;
+    }
+
+  fprintf(ptrace_outfd, "- %u %s\n", iseq, reasons[reason]);
 
   if (ptrace_outfd == stderr || ptrace_outfd == stdout)
     fflush(ptrace_outfd);
@@ -161,6 +470,15 @@ __ptrace_endinst(unsigned int iseq)	/* instruction sequence number */
 void
 __ptrace_newcycle(tick_t cycle)		/* new cycle */
 {
+  if (ptrace_binary)
+    {
+      PTB_RESERVE(0);
+      *ptb_p++ = PTB_NEWCYCLE;
+      ptb_put_varint((qword_t)(cycle - ptb_last_cycle));
+      ptb_last_cycle = cycle;
+      return;
+    }
+
   fprintf(ptrace_outfd, "@ %.0f\n", (double)cycle);
 
   if (ptrace_outfd == stderr || ptrace_outfd == stdout)
@@ -173,6 +491,26 @@ __ptrace_newstage(unsigned int iseq,	/* instruction sequence number */
 		  char *pstage,		/* pipeline stage entered */
 		  unsigned int pevents)/* pipeline events while in stage */
 {
+  if (ptrace_binary)
+    {
+      static char *stages[PTB_NUM_STAGES] = PTB_STAGES;
+      int stage;
+
+      for (stage = 0; stage < PTB_NUM_STAGES; stage++)
+	if (pstage == stages[stage] || !strcmp(pstage, stages[stage]))
+	  break;
+      if (stage == PTB_NUM_STAGES)
+	panic("unknown pipeline stage `%s'", pstage);
+
+      PTB_RESERVE(0);
+      *ptb_p++ = PTB_NEWSTAGE;
+      ptb_put_delta((int)(iseq - ptb_last_iseq));
+      ptb_last_iseq = iseq;
+      *ptb_p++ = (unsigned char)stage;
+      ptb_put_varint(pevents);
+      return;
+    }
+
   fprintf(ptrace_outfd, "* %u %s 0x%08x\n", iseq, pstage, pevents);
 
   if (ptrace_outfd == stderr || ptrace_outfd == stdout)
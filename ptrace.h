@@ -60,11 +60,18 @@
 /*
  * pipeline events:
  *
- *	+ <iseq> <pc> <addr> <inst>	- new instruction def
- *	- <iseq>			- instruction squashed or retired
+ *	+ <iseq> <pc> <addr> <path> <inst>
+ *					- new instruction def
+ *	+ <iseq> <pc> <addr> <path> [<desc>]
+ *					- new uop def
+ *	- <iseq> <reason>		- instruction squashed or retired
  *	@ <cycle>			- new cycle def
  *	* <iseq> <stage> <events>	- instruction stage transition
  *
+ * <path> is the eager execution path that fetched the instruction, written
+ * as <thread>/<fork>/<level>: its thread id, the number of forks that thread
+ * had spun off when the instruction was fetched, and its mis-speculation
+ * level; <reason> is one of PEND_NAMES
  */
 
 /*
@@ -88,9 +95,67 @@
 #define PEV_MPDETECT		0x00000008	/* mis-pred branch detected */
 #define PEV_AGEN		0x00000010	/* address generation */
 
+/* instruction end reasons, retirement and each kind of squash */
+#define PEND_RETIRE		0	/* committed */
+#define PEND_MISPRED		1	/* squashed by branch mis-pred recovery */
+#define PEND_FORKLOSS		2	/* squashed, its forked path won */
+#define PEND_MISFETCH		3	/* squashed by a fetch redirect */
+#define PEND_NOP		4	/* dropped at dispatch */
+#define PEND_NUM		5
+
+/* instruction end reason names, in PEND_* order */
+#define PEND_NAMES							\
+  { "retire", "mispred", "forkloss", "misfetch", "nop" }
+
+/*
+ * binary pipetrace format, a header followed by records that each start with
+ * a PTB_* record type byte:
+ *
+ *	header				- "SSPT", version byte, sizeof(md_inst_t)
+ *	PTB_TEXT <pc> <inst>		- instruction bits at PC, sent once per
+ *					  PC ahead of its first PTB_NEWINST
+ *	PTB_NEWINST <iseq> <pc> <addr> <thread> <fork> <level>
+ *					- new instruction def
+ *	PTB_NEWUOP <iseq> <pc> <addr> <thread> <fork> <level> <len> <desc>
+ *					- new uop def
+ *	PTB_ENDINST <iseq> <reason>	- instruction squashed or retired
+ *	PTB_NEWCYCLE <cycle>		- new cycle def
+ *	PTB_NEWSTAGE <iseq> <stage> <events>
+ *					- instruction stage transition
+ *
+ * <iseq> and <pc> are zig-zag varint deltas from the previous record's,
+ * <cycle> is a varint delta from the previous cycle, <addr>, <thread>,
+ * <fork>, <level>, <len> and <events> are varints, <stage> is a byte index
+ * into PTB_STAGES, <reason> is a PEND_* byte and <inst> is
+ * sizeof(md_inst_t) raw bytes; see ptread.h for a reader
+ */
+#define PTB_MAGIC		"SSPT"
+#define PTB_VERSION		2
+
+#define PTB_TEXT		1
+#define PTB_NEWINST		2
+#define PTB_NEWUOP		3
+#define PTB_ENDINST		4
+#define PTB_NEWCYCLE		5
+#define PTB_NEWSTAGE		6
+
+/* pipeline stages, in binary stage index order */
+#define PTB_STAGES							\
+  { PST_IFETCH, PST_DISPATCH, PST_EXECUTE, PST_WRITEBACK, PST_COMMIT }
+#define PTB_NUM_STAGES		5
+
+/* longest uop description kept in a binary pipetrace */
+#define PTB_MAX_UOP		255
+
+/* empty PC table slot, never an instruction address */
+#define PTB_NO_PC		((md_addr_t)-1)
+
 /* pipetrace file */
 extern FILE *ptrace_outfd;
 
+/* write the pipetrace in the binary format (set before ptrace_open()) */
+extern int ptrace_binary;
+
 /* pipetracing is active */
 extern int ptrace_active;
 
@@ -118,12 +183,12 @@ ptrace_close(void);
    : (ptrace_active = FALSE))
 
 /* main interfaces, with fast checks */
-#define ptrace_newinst(A,B,C,D)						\
-  if (ptrace_active) __ptrace_newinst((A),(B),(C),(D))
-#define ptrace_newuop(A,B,C,D)						\
-  if (ptrace_active) __ptrace_newuop((A),(B),(C),(D))
-#define ptrace_endinst(A)						\
-  if (ptrace_active) __ptrace_endinst((A))
+#define ptrace_newinst(A,B,C,D,T,F,L)					\
+  if (ptrace_active) __ptrace_newinst((A),(B),(C),(D),(T),(F),(L))
+#define ptrace_newuop(A,B,C,D,T,F,L)					\
+  if (ptrace_active) __ptrace_newuop((A),(B),(C),(D),(T),(F),(L))
+#define ptrace_endinst(A,R)						\
+  if (ptrace_active) __ptrace_endinst((A),(R))
 #define ptrace_newcycle(A)						\
   if (ptrace_active) __ptrace_newcycle((A))
 #define ptrace_newstage(A,B,C)						\
@@ -137,18 +202,25 @@ void
 __ptrace_newinst(unsigned int iseq,	/* instruction sequence number */
 		 md_inst_t inst,	/* new instruction */
 		 md_addr_t pc,		/* program counter of instruction */
-		 md_addr_t addr);	/* address referenced, if load/store */
+		 md_addr_t addr,	/* address referenced, if load/store */
+		 int thread,		/* fetching thread */
+		 int fork,		/* forks spun off by thread so far */
+		 int level);		/* mis-speculation level */
 
 /* declare a new uop */
 void
 __ptrace_newuop(unsigned int iseq,	/* instruction sequence number */
 		char *uop_desc,		/* new uop description */
 		md_addr_t pc,		/* program counter of instruction */
-		md_addr_t addr);	/* address referenced, if load/store */
+		md_addr_t addr,		/* address referenced, if load/store */
+		int thread,		/* fetching thread */
+		int fork,		/* forks spun off by thread so far */
+		int level);		/* mis-speculation level */
 
 /* declare instruction retirement or squash */
 void
-__ptrace_endinst(unsigned int iseq);	/* instruction sequence number */
+__ptrace_endinst(unsigned int iseq,	/* instruction sequence number */
+		 int reason);		/* why it ended, PEND_* */
 
 /* declare a new cycle */
 void
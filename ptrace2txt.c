@@ -0,0 +1,104 @@
+/* ptrace2txt.c - convert a binary pipetrace to the text format */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "ptread.h"
+
+/*
+ * usage: ptrace2txt <binary trace> [<text trace>]
+ *
+ * rewrites a pipetrace recorded with `-ptrace:binary' in the text format
+ * written without it, e.g., for pipeview.pl; `-' names stdin/stdout
+ */
+int
+main(int argc, char **argv)
+{
+  FILE *infd, *outfd;
+  struct ptread_t *pt;
+  struct ptread_rec_t rec;
+
+  if (argc < 2 || argc > 3)
+    {
+      fprintf(stderr, "usage: %s <binary trace> [<text trace>]\n", argv[0]);
+      exit(1);
+    }
+
+  if (!strcmp(argv[1], "-"))
+    infd = stdin;
+  else if (!(infd = fopen(argv[1], "rb")))
+    fatal("cannot open binary pipetrace `%s'", argv[1]);
+
+  if (argc < 3 || !strcmp(argv[2], "-"))
+    outfd = stdout;
+  else if (!(outfd = fopen(argv[2], "w")))
+    fatal("cannot open text pipetrace `%s'", argv[2]);
+
+  /* instructions are disassembled as they are read back */
+  md_init_decoder();
+
+  pt = ptread_open(infd);
+  while (ptread_next(pt, &rec))
+    ptread_print(outfd, &rec);
+  ptread_close(pt);
+
+  if (infd != stdin)
+    fclose(infd);
+  if (fclose(outfd) != 0)
+    fatal("could not write text pipetrace");
+
+  return 0;
+}
@@ -0,0 +1,428 @@
+/* ptread.c - binary pipetrace reader routines */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "ptread.h"
+
+/* stage names, in binary stage index order */
+static char *stage_names[PTB_NUM_STAGES] = PTB_STAGES;
+
+/* instruction end reason names, in PEND_* order */
+static char *reason_names[PEND_NUM] = PEND_NAMES;
+
+/* open a binary or text pipetrace on FD, checks a binary trace header */
+struct ptread_t *
+ptread_open(FILE *fd)
+{
+  struct ptread_t *pt;
+  char magic[4];
+  int c, version, inst_size;
+
+  pt = calloc(1, sizeof(struct ptread_t));
+  if (!pt)
+    fatal("out of virtual memory");
+  pt->fd = fd;
+
+  /* text pipetrace lines never start with the binary trace magic */
+  c = getc(fd);
+  if (c != PTB_MAGIC[0])
+    {
+      if (c != EOF)
+	ungetc(c, fd);
+      pt->binary = FALSE;
+      return pt;
+    }
+
+  magic[0] = c;
+  if (fread(magic + 1, 1, 3, fd) != 3 || memcmp(magic, PTB_MAGIC, 4))
+    fatal("not a pipetrace");
+  version = getc(fd);
+  inst_size = getc(fd);
+  if (version != PTB_VERSION)
+    fatal("binary pipetrace version %d, expected %d", version, PTB_VERSION);
+  if (inst_size != sizeof(md_inst_t))
+    fatal("binary pipetrace is for another target (instruction size %d)",
+	  inst_size);
+  pt->binary = TRUE;
+
+  return pt;
+}
+
+/* release a pipetrace reader, FD is not closed */
+void
+ptread_close(struct ptread_t *pt)
+{
+  free(pt->text_pcs);
+  free(pt->text_insts);
+  free(pt);
+}
+
+/* read an unsigned varint */
+static qword_t
+get_varint(struct ptread_t *pt)
+{
+  qword_t val = 0;
+  int c, shift = 0;
+
+  do {
+    c = getc(pt->fd);
+    if (c == EOF)
+      fatal("truncated binary pipetrace");
+    val |= (qword_t)(c & 0x7f) << shift;
+    shift += 7;
+  } while (c & 0x80);
+  return val;
+}
+
+/* read a zig-zag varint delta */
+static sqword_t
+get_delta(struct ptread_t *pt)
+{
+  qword_t val = get_varint(pt);
+
+  return (sqword_t)(val >> 1) ^ -(sqword_t)(val & 1);
+}
+
+/* find the PC table slot for PC */
+static int
+text_slot(struct ptread_t *pt, md_addr_t pc)
+{
+  int i = (pc >> 2) & (pt->text_size - 1);
+
+  while (pt->text_pcs[i] != PTB_NO_PC && pt->text_pcs[i] != pc)
+    i = (i + 1) & (pt->text_size - 1);
+  return i;
+}
+
+/* record the instruction bits INST at PC */
+static void
+text_insert(struct ptread_t *pt, md_addr_t pc, md_inst_t inst)
+{
+  int i;
+
+  if (2 * (pt->text_num + 1) > pt->text_size)
+    {
+      md_addr_t *old_pcs = pt->text_pcs;
+      md_inst_t *old_insts = pt->text_insts;
+      int old_size = pt->text_size;
+
+      pt->text_size = old_size ? 2 * old_size : 4096;
+      pt->text_pcs = malloc(pt->text_size * sizeof(md_addr_t));
+      pt->text_insts = calloc(pt->text_size, sizeof(md_inst_t));
+      if (!pt->text_pcs || !pt->text_insts)
+	fatal("out of virtual memory");
+      for (i = 0; i < pt->text_size; i++)
+	pt->text_pcs[i] = PTB_NO_PC;
+      for (i = 0; i < old_size; i++)
+	if (old_pcs[i] != PTB_NO_PC)
+	  {
+	    int j = text_slot(pt, old_pcs[i]);
+
+	    pt->text_pcs[j] = old_pcs[i];
+	    pt->text_insts[j] = old_insts[i];
+	  }
+      free(old_pcs);
+      free(old_insts);
+    }
+
+  i = text_slot(pt, pc);
+  if (pt->text_pcs[i] == PTB_NO_PC)
+    pt->text_num++;
+  pt->text_pcs[i] = pc;
+  pt->text_insts[i] = inst;
+}
+
+/* read the sequence number, PC and path of a new instruction or uop */
+static void
+get_inst(struct ptread_t *pt, struct ptread_rec_t *rec)
+{
+  pt->iseq += (int)get_delta(pt);
+  rec->iseq = pt->iseq;
+  pt->pc += (md_addr_t)get_delta(pt);
+  rec->pc = pt->pc;
+  rec->addr = (md_addr_t)get_varint(pt);
+  rec->thread = (int)get_varint(pt);
+  rec->fork = (int)get_varint(pt);
+  rec->level = (int)get_varint(pt);
+}
+
+/* parse a text pipetrace line into REC, returns FALSE if it is not one */
+static int
+parse_line(char *line, struct ptread_rec_t *rec)
+{
+  char *p, *end;
+  int i, n;
+
+  switch (line[0])
+    {
+    case '+':
+      rec->iseq = (unsigned int)strtoul(line + 1, &p, 10);
+      rec->pc = (md_addr_t)strtoull(p, &p, 16);
+      rec->addr = (md_addr_t)strtoull(p, &p, 16);
+      rec->thread = rec->fork = rec->level = 0;
+      if (sscanf(p, " %d/%d/%d%n", &rec->thread, &rec->fork, &rec->level,
+		 &n) == 3)
+	p += n;
+      while (*p == ' ')
+	p++;
+      end = p + strlen(p);
+      if (*p == '[' && end[-1] == ']')
+	{
+	  /* new uop, keep the description without its brackets */
+	  rec->type = PTB_NEWUOP;
+	  strncpy(rec->desc, p + 1, end - p - 2);
+	  rec->desc[end - p - 2] = '\0';
+	}
+      else
+	{
+	  rec->type = PTB_NEWINST;
+	  rec->inst_valid = FALSE;
+	  strcpy(rec->desc, p);
+	}
+      return TRUE;
+
+    case '-':
+      rec->type = PTB_ENDINST;
+      rec->iseq = (unsigned int)strtoul(line + 1, &p, 10);
+      while (*p == ' ')
+	p++;
+      rec->reason = PEND_RETIRE;
+      for (i = 0; i < PEND_NUM; i++)
+	if (!strcmp(p, reason_names[i]))
+	  rec->reason = i;
+      return TRUE;
+
+    case '@':
+      rec->type = PTB_NEWCYCLE;
+      rec->cycle = (tick_t)strtod(line + 1, NULL);
+      return TRUE;
+
+    case '*':
+      rec->type = PTB_NEWSTAGE;
+      rec->iseq = (unsigned int)strtoul(line + 1, &p, 10);
+      while (*p == ' ')
+	p++;
+      for (i = 0; i < PTB_NUM_STAGES; i++)
+	if (!strncmp(p, stage_names[i], strlen(stage_names[i]))
+	    && p[strlen(stage_names[i])] == ' ')
+	  break;
+      if (i == PTB_NUM_STAGES)
+	return FALSE;
+      rec->stage = i;
+      rec->pevents = (unsigned int)strtoul(p + strlen(stage_names[i]), NULL,
+					   16);
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+/* read the next text pipetrace record into REC, skipping lines that are not
+   pipetrace records */
+static int
+text_next(struct ptread_t *pt, struct ptread_rec_t *rec)
+{
+  char line[PTREAD_MAX_LINE];
+  int len;
+
+  while (fgets(line, PTREAD_MAX_LINE, pt->fd))
+    {
+      len = strlen(line);
+      while (len > 0 && (line[len-1] == '\n' || line[len-1] == '\r'))
+	line[--len] = '\0';
+      if (parse_line(line, rec))
+	{
+	  if (rec->type == PTB_NEWCYCLE)
+	    pt->cycle = rec->cycle;
+	  return TRUE;
+	}
+    }
+  return FALSE;
+}
+
+/* read the next record into REC, returns FALSE at the end of the trace */
+int
+ptread_next(struct ptread_t *pt, struct ptread_rec_t *rec)
+{
+  int c, i, len;
+  md_addr_t pc;
+  md_inst_t inst;
+
+  if (!pt->binary)
+    return text_next(pt, rec);
+
+  for (;;)
+    {
+      c = getc(pt->fd);
+      if (c == EOF)
+	return FALSE;
+      rec->type = c;
+
+      switch (c)
+	{
+	case PTB_TEXT:
+	  pc = (md_addr_t)get_varint(pt);
+	  if (fread(&inst, sizeof(md_inst_t), 1, pt->fd) != 1)
+	    fatal("truncated binary pipetrace");
+	  text_insert(pt, pc, inst);
+	  continue;
+
+	case PTB_NEWINST:
+	  get_inst(pt, rec);
+	  if (!pt->text_size
+	      || pt->text_pcs[i = text_slot(pt, rec->pc)] == PTB_NO_PC)
+	    fatal("binary pipetrace has no instruction at 0x%08p", rec->pc);
+	  rec->inst_valid = TRUE;
+	  rec->inst = pt->text_insts[i];
+	  return TRUE;
+
+	case PTB_NEWUOP:
+	  get_inst(pt, rec);
+	  len = (int)get_varint(pt);
+	  if (len > PTB_MAX_UOP
+	      || fread(rec->desc, 1, len, pt->fd) != (size_t)len)
+	    fatal("truncated binary pipetrace");
+	  rec->desc[len] = '\0';
+	  return TRUE;
+
+	case PTB_ENDINST:
+	  pt->iseq += (int)get_delta(pt);
+	  rec->iseq = pt->iseq;
+	  rec->reason = getc(pt->fd);
+	  if (rec->reason < 0 || rec->reason >= PEND_NUM)
+	    fatal("bad end reason %d in binary pipetrace", rec->reason);
+	  return TRUE;
+
+	case PTB_NEWCYCLE:
+	  pt->cycle += (tick_t)get_varint(pt);
+	  rec->cycle = pt->cycle;
+	  return TRUE;
+
+	case PTB_NEWSTAGE:
+	  pt->iseq += (int)get_delta(pt);
+	  rec->iseq = pt->iseq;
+	  rec->stage = getc(pt->fd);
+	  if (rec->stage < 0 || rec->stage >= PTB_NUM_STAGES)
+	    fatal("bad stage index %d in binary pipetrace", rec->stage);
+	  rec->pevents = (unsigned int)get_varint(pt);
+	  return TRUE;
+
+	default:
+	  fatal("bad record type %d in binary pipetrace", c);
+	}
+    }
+}
+
+/* name of binary stage index STAGE, as used by the text pipetrace */
+char *
+ptread_stage_name(int stage)
+{
+  if (stage < 0 || stage >= PTB_NUM_STAGES)
+    panic("bogus stage index");
+  return stage_names[stage];
+}
+
+/* name of instruction end reason REASON (PEND_*) */
+char *
+ptread_reason_name(int reason)
+{
+  if (reason < 0 || reason >= PEND_NUM)
+    panic("bogus instruction end reason");
+  return reason_names[reason];
+}
+
+/* print record REC to FD in the text pipetrace format */
+void
+ptread_print(FILE *fd, struct ptread_rec_t *rec)
+{
+  switch (rec->type)
+    {
+    case PTB_NEWINST:
+      myfprintf(fd, "+ %u 0x%08p 0x%08p %d/%d/%d ",
+		rec->iseq, rec->pc, rec->addr,
+		rec->thread, rec->fork, rec->level);
+      if (rec->inst_valid)
+	md_print_insn(rec->inst, rec->addr, fd);
+      else
+	fputs(rec->desc, fd);
+      fprintf(fd, "\n");
+      break;
+
+    case PTB_NEWUOP:
+      myfprintf(fd, "+ %u 0x%08p 0x%08p %d/%d/%d [%s]\n",
+		rec->iseq, rec->pc, rec->addr,
+		rec->thread, rec->fork, rec->level, rec->desc);
+      break;
+
+    case PTB_ENDINST:
+      fprintf(fd, "- %u %s\n", rec->iseq, reason_names[rec->reason]);
+      break;
+
+    case PTB_NEWCYCLE:
+      fprintf(fd, "@ %.0f\n", (double)rec->cycle);
+      break;
+
+    case PTB_NEWSTAGE:
+      fprintf(fd, "* %u %s 0x%08x\n",
+	      rec->iseq, stage_names[rec->stage], rec->pevents);
+      break;
+
+    default:
+      panic("bogus pipetrace record type");
+    }
+}
@@ -0,0 +1,127 @@
+/* ptread.h - binary pipetrace reader interfaces */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+#ifndef PTREAD_H
+#define PTREAD_H
+
+#include <stdio.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "ptrace.h"
+
+/*
+ * pipetrace reader, for the binary format written by `-ptrace:binary' and
+ * for text pipetraces, see ptrace.h for both layouts; binary PTB_TEXT
+ * records are folded into the reader's PC table and never returned, so
+ * each record read back is one line of the text pipetrace
+ */
+
+/* longest text pipetrace line read */
+#define PTREAD_MAX_LINE		1024
+
+/* pipetrace reader state */
+struct ptread_t {
+  FILE *fd;				/* trace file */
+  int binary;				/* binary trace? else text */
+  unsigned int iseq;			/* last instruction sequence number */
+  md_addr_t pc;				/* last instruction PC */
+  tick_t cycle;				/* current cycle */
+  md_addr_t *text_pcs;			/* PC -> instruction bits table */
+  md_inst_t *text_insts;
+  int text_size, text_num;
+};
+
+/* one decoded pipetrace record */
+struct ptread_rec_t {
+  int type;				/* PTB_* record type */
+  unsigned int iseq;			/* instruction sequence number */
+  md_addr_t pc;				/* instruction PC (NEWINST/NEWUOP) */
+  md_addr_t addr;			/* address referenced, if load/store */
+  int thread;				/* fetching thread (NEWINST/NEWUOP) */
+  int fork;				/* forks thread had spun off */
+  int level;				/* mis-speculation level */
+  int inst_valid;			/* INST valid? else DESC is the asm */
+  md_inst_t inst;			/* instruction bits (NEWINST) */
+  char desc[PTREAD_MAX_LINE];		/* uop description (NEWUOP), or
+					   disassembly (text NEWINST) */
+  int reason;				/* why it ended, PEND_* (ENDINST) */
+  tick_t cycle;				/* cycle (NEWCYCLE) */
+  int stage;				/* stage index (NEWSTAGE) */
+  unsigned int pevents;			/* pipeline events (NEWSTAGE) */
+};
+
+/* open a binary or text pipetrace on FD, checks a binary trace header */
+struct ptread_t *
+ptread_open(FILE *fd);
+
+/* release a pipetrace reader, FD is not closed */
+void
+ptread_close(struct ptread_t *pt);
+
+/* read the next record into REC, returns FALSE at the end of the trace */
+int
+ptread_next(struct ptread_t *pt, struct ptread_rec_t *rec);
+
+/* name of binary stage index STAGE, as used by the text pipetrace */
+char *
+ptread_stage_name(int stage);
+
+/* name of instruction end reason REASON (PEND_*) */
+char *
+ptread_reason_name(int reason);
+
+/* print record REC to FD in the text pipetrace format */
+void
+ptread_print(FILE *fd, struct ptread_rec_t *rec);
+
+#endif /* PTREAD_H */
@@ -0,0 +1,594 @@
+/* ptview.c - pipetrace analyzer */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "ptread.h"
+
+/*
+ * usage: ptview {-options} <trace>
+ *
+ * streams a text or binary pipetrace (`-' is stdin) once and prints:
+ *
+ *   - per-thread instruction counts, retired and squashed by reason
+ *   - a squash timeline, one line per squash event (the instructions ended
+ *     for the same reason in the same cycle) naming the threads it hit
+ *   - per-stage latency histograms of the retired instructions
+ *   - per-thread pipeline diagrams of the instructions live in a window of
+ *     cycles, one row per instruction and one column per cycle: the stage
+ *     letter (F D E W C) in the cycle the stage is entered, lower case while
+ *     it stays there, and `x' in the cycle it is squashed
+ */
+
+/* binary stage index of the commit stage */
+#define COMMIT_STAGE		(PTB_NUM_STAGES - 1)
+
+/* default diagram window, in cycles from the start of the trace */
+#define DEF_WINDOW		64
+
+/* latency histogram buckets: 0, 1, 2-3, 4-7, ..., and the overflow */
+#define NUM_BUCKETS		16
+
+/* no cycle */
+#define NO_CYCLE		((tick_t)-1)
+
+/* an instruction or uop in the trace */
+struct inst_t {
+  int valid;				/* live instruction? */
+  unsigned int iseq;			/* sequence number */
+  int type;				/* PTB_NEWINST or PTB_NEWUOP */
+  md_addr_t pc, addr;			/* PC, and address referenced */
+  int thread, fork, level;		/* fetching path */
+  int inst_valid;			/* INST valid? else DESC */
+  md_inst_t inst;			/* instruction bits */
+  char *desc;				/* uop description or disassembly */
+  tick_t stage_cycle[PTB_NUM_STAGES];	/* cycle each stage was entered */
+  tick_t end_cycle;			/* cycle it ended, or NO_CYCLE */
+  int reason;				/* why it ended, PEND_* */
+};
+
+/* per-thread counts */
+struct thread_t {
+  counter_t insts;			/* instructions and uops started */
+  counter_t ended[PEND_NUM];		/* and ended, by reason */
+};
+
+/* options */
+static tick_t win_start = NO_CYCLE, win_end = NO_CYCLE;
+static int only_thread = -1;
+static int max_squashes = 100;
+
+/* live instructions, direct mapped on the sequence number */
+static struct inst_t *live;
+static int live_size;
+
+/* diagram rows, instructions live in the window */
+static struct inst_t *rows;
+static int rows_num, rows_size;
+
+/* per-thread counts */
+static struct thread_t *threads;
+static int threads_num;
+
+/* retired instruction latency histograms, per stage and total */
+static counter_t hist[PTB_NUM_STAGES+1][NUM_BUCKETS];
+static counter_t hist_sum[PTB_NUM_STAGES+1], hist_num[PTB_NUM_STAGES+1];
+
+/* threads named per squash event */
+#define SQ_THREADS		8
+
+/* squash event being accumulated */
+static tick_t sq_cycle = NO_CYCLE;
+static int sq_reason, sq_insts;
+static int sq_threads[SQ_THREADS], sq_threads_num;
+static counter_t sq_events, sq_printed;
+
+/* current cycle */
+static tick_t cycle = 0;
+static tick_t first_cycle = NO_CYCLE;
+
+/* stage letters, in binary stage index order */
+static char stage_letters[PTB_NUM_STAGES] = { 'F', 'D', 'E', 'W', 'C' };
+
+/* get the per-thread counts of THREAD */
+static struct thread_t *
+get_thread(int thread)
+{
+  if (thread < 0)
+    fatal("bad thread id %d in pipetrace", thread);
+  if (thread >= threads_num)
+    {
+      int n = threads_num;
+
+      threads_num = thread + 1;
+      threads = realloc(threads, threads_num * sizeof(struct thread_t));
+      if (!threads)
+	fatal("out of virtual memory");
+      memset(threads + n, 0, (threads_num - n) * sizeof(struct thread_t));
+    }
+  return &threads[thread];
+}
+
+/* get the live table slot of ISEQ, growing the table to make room for a new
+   instruction if NEW is set */
+static struct inst_t *
+get_live(unsigned int iseq, int new)
+{
+  struct inst_t *ip;
+
+  if (!live_size)
+    {
+      live_size = 4096;
+      live = calloc(live_size, sizeof(struct inst_t));
+      if (!live)
+	fatal("out of virtual memory");
+    }
+
+  ip = &live[iseq & (live_size - 1)];
+  while (new && ip->valid && ip->iseq != iseq)
+    {
+      /* an older instruction is still live, double the table */
+      struct inst_t *old = live;
+      int i, old_size = live_size;
+
+      live_size *= 2;
+      live = calloc(live_size, sizeof(struct inst_t));
+      if (!live)
+	fatal("out of virtual memory");
+      for (i = 0; i < old_size; i++)
+	if (old[i].valid)
+	  live[old[i].iseq & (live_size - 1)] = old[i];
+      free(old);
+      ip = &live[iseq & (live_size - 1)];
+    }
+
+  return (new || (ip->valid && ip->iseq == iseq)) ? ip : NULL;
+}
+
+/* histogram bucket of latency LAT */
+static int
+bucket(tick_t lat)
+{
+  int b = 0;
+
+  while (lat > 0 && b < NUM_BUCKETS - 1)
+    {
+      lat >>= 1;
+      b++;
+    }
+  return b;
+}
+
+/* account for latency LAT in histogram H */
+static void
+hist_add(int h, tick_t lat)
+{
+  hist[h][bucket(lat)]++;
+  hist_sum[h] += lat;
+  hist_num[h]++;
+}
+
+/* print the squash event being accumulated, if any */
+static void
+squash_flush(void)
+{
+  if (sq_cycle == NO_CYCLE)
+    return;
+
+  sq_events++;
+  if (sq_printed < max_squashes)
+    {
+      int i;
+
+      if (!sq_printed)
+	fprintf(stdout, "squash timeline:\n");
+      fprintf(stdout, "  @%-10.0f %-8s %5d insts, threads",
+	      (double)sq_cycle, ptread_reason_name(sq_reason), sq_insts);
+      for (i = 0; i < sq_threads_num && i < SQ_THREADS; i++)
+	fprintf(stdout, "%s%d", i ? "," : " ", sq_threads[i]);
+      fprintf(stdout, "%s\n", sq_threads_num > SQ_THREADS ? ",..." : "");
+      sq_printed++;
+    }
+  sq_cycle = NO_CYCLE;
+}
+
+/* instruction IP has ended */
+static void
+inst_end(struct inst_t *ip)
+{
+  int s, next;
+
+  get_thread(ip->thread)->ended[ip->reason]++;
+
+  if (ip->reason == PEND_RETIRE)
+    {
+      /* time in each stage entered, up to the next stage entered, commit
+	 is left out as instructions retire in the cycle they commit */
+      for (s = 0; s < COMMIT_STAGE; s++)
+	{
+	  if (ip->stage_cycle[s] == NO_CYCLE)
+	    continue;
+	  for (next = s + 1; next < PTB_NUM_STAGES; next++)
+	    if (ip->stage_cycle[next] != NO_CYCLE)
+	      break;
+	  hist_add(s, (next < PTB_NUM_STAGES
+		       ? ip->stage_cycle[next] : ip->end_cycle)
+		   - ip->stage_cycle[s]);
+	}
+      for (s = 0; s < PTB_NUM_STAGES; s++)
+	if (ip->stage_cycle[s] != NO_CYCLE)
+	  {
+	    hist_add(PTB_NUM_STAGES, ip->end_cycle - ip->stage_cycle[s]);
+	    break;
+	  }
+    }
+  else if (ip->reason != PEND_NOP)
+    {
+      int i;
+
+      /* squashes for one reason in one cycle make up a single event */
+      if (sq_cycle != ip->end_cycle || sq_reason != ip->reason)
+	{
+	  squash_flush();
+	  sq_cycle = ip->end_cycle;
+	  sq_reason = ip->reason;
+	  sq_insts = 0;
+	  sq_threads_num = 0;
+	}
+      sq_insts++;
+      for (i = 0; i < sq_threads_num && i < SQ_THREADS; i++)
+	if (sq_threads[i] == ip->thread)
+	  break;
+      if (i == sq_threads_num)
+	{
+	  if (i < SQ_THREADS)
+	    sq_threads[i] = ip->thread;
+	  sq_threads_num++;
+	}
+    }
+}
+
+/* keep instruction IP for the diagram if it was live in the window */
+static void
+inst_keep(struct inst_t *ip)
+{
+  tick_t start = NO_CYCLE;
+  int s;
+
+  for (s = 0; s < PTB_NUM_STAGES && start == NO_CYCLE; s++)
+    start = ip->stage_cycle[s];
+
+  if (start == NO_CYCLE || start >= win_end
+      || (ip->end_cycle != NO_CYCLE && ip->end_cycle < win_start)
+      || (only_thread >= 0 && ip->thread != only_thread))
+    {
+      free(ip->desc);
+      return;
+    }
+
+  if (rows_num == rows_size)
+    {
+      rows_size = rows_size ? 2 * rows_size : 1024;
+      rows = realloc(rows, rows_size * sizeof(struct inst_t));
+      if (!rows)
+	fatal("out of virtual memory");
+    }
+  rows[rows_num++] = *ip;
+}
+
+/* order diagram rows by thread, then by sequence number */
+static int
+row_cmp(const void *a, const void *b)
+{
+  const struct inst_t *ra = a, *rb = b;
+
+  if (ra->thread != rb->thread)
+    return ra->thread - rb->thread;
+  return (ra->iseq > rb->iseq) - (ra->iseq < rb->iseq);
+}
+
+/* print the pipeline diagrams */
+static void
+print_diagrams(void)
+{
+  int r, s, thread = -1;
+  tick_t c, first;
+
+  qsort(rows, rows_num, sizeof(struct inst_t), row_cmp);
+
+  for (r = 0; r < rows_num; r++)
+    {
+      struct inst_t *ip = &rows[r];
+      char state = ' ';
+
+      if (ip->thread != thread)
+	{
+	  thread = ip->thread;
+	  fprintf(stdout, "\nthread %d pipeline, cycles %.0f-%.0f:\n",
+		  thread, (double)win_start, (double)(win_end - 1));
+	  fprintf(stdout, "  %10s %-10s |", "iseq", "path");
+	  for (c = win_start; c < win_end; c++)
+	    fputc(c % 10 == 0 ? '0' + (int)((c / 10) % 10) : ' ', stdout);
+	  fprintf(stdout, "|\n");
+	}
+
+      fprintf(stdout, "  %10u %3d/%d/%-4d |",
+	      ip->iseq, ip->thread, ip->fork, ip->level);
+      /* walk from the first stage entered, to know the stage at WIN_START */
+      for (first = win_start, s = 0; s < PTB_NUM_STAGES; s++)
+	if (ip->stage_cycle[s] != NO_CYCLE && ip->stage_cycle[s] < first)
+	  first = ip->stage_cycle[s];
+      for (c = first; c < win_end; c++)
+	{
+	  char mark = state;
+
+	  for (s = 0; s < PTB_NUM_STAGES; s++)
+	    if (ip->stage_cycle[s] == c)
+	      mark = stage_letters[s];
+	  if (mark != state && mark != ' ')
+	    state = mark - 'A' + 'a';
+	  if (ip->end_cycle != NO_CYCLE && c >= ip->end_cycle)
+	    {
+	      if (c == ip->end_cycle && ip->reason != PEND_RETIRE)
+		mark = 'x';
+	      else if (c > ip->end_cycle)
+		mark = ' ';
+	      state = ' ';
+	    }
+	  if (c >= win_start)
+	    fputc(mark, stdout);
+	}
+      myfprintf(stdout, "| 0x%08p ", ip->pc);
+      if (ip->type == PTB_NEWUOP)
+	fprintf(stdout, "[%s]", ip->desc);
+      else if (ip->inst_valid)
+	md_print_insn(ip->inst, ip->addr, stdout);
+      else
+	fputs(ip->desc, stdout);
+      fprintf(stdout, " %s\n",
+	      ip->end_cycle == NO_CYCLE ? "" : ptread_reason_name(ip->reason));
+    }
+}
+
+/* print the latency histograms */
+static void
+print_histograms(void)
+{
+  int b, s;
+
+  fprintf(stdout, "\nstage latencies of retired instructions (cycles):\n");
+  fprintf(stdout, "  %-10s", "latency");
+  for (s = 0; s < COMMIT_STAGE; s++)
+    fprintf(stdout, " %12s", ptread_stage_name(s));
+  fprintf(stdout, " %12s\n", "total");
+
+  for (b = 0; b < NUM_BUCKETS; b++)
+    {
+      char label[32];
+
+      if (b < 2)
+	sprintf(label, "%d", b);
+      else if (b < NUM_BUCKETS - 1)
+	sprintf(label, "%d-%d", 1 << (b - 1), (1 << b) - 1);
+      else
+	sprintf(label, ">=%d", 1 << (b - 1));
+      fprintf(stdout, "  %-10s", label);
+      for (s = 0; s <= PTB_NUM_STAGES; s++)
+	if (s != COMMIT_STAGE)
+	  fprintf(stdout, " %12.0f", (double)hist[s][b]);
+      fprintf(stdout, "\n");
+    }
+
+  fprintf(stdout, "  %-10s", "mean");
+  for (s = 0; s <= PTB_NUM_STAGES; s++)
+    if (s != COMMIT_STAGE)
+      fprintf(stdout, " %12.2f",
+	      hist_num[s] ? (double)hist_sum[s] / (double)hist_num[s] : 0.0);
+  fprintf(stdout, "\n");
+}
+
+/* print the per-thread counts */
+static void
+print_threads(void)
+{
+  int r, t;
+
+  fprintf(stdout, "\n  %6s %12s", "thread", "insts");
+  for (r = 0; r < PEND_NUM; r++)
+    fprintf(stdout, " %12s", ptread_reason_name(r));
+  fprintf(stdout, "\n");
+  for (t = 0; t < threads_num; t++)
+    {
+      if (!threads[t].insts)
+	continue;
+      fprintf(stdout, "  %6d %12.0f", t, (double)threads[t].insts);
+      for (r = 0; r < PEND_NUM; r++)
+	fprintf(stdout, " %12.0f", (double)threads[t].ended[r]);
+      fprintf(stdout, "\n");
+    }
+}
+
+static void
+usage(char *prog)
+{
+  fprintf(stderr,
+	  "usage: %s {-options} <trace>\n"
+	  "  -d <start>:<end>   pipeline diagram cycles (default: first %d)\n"
+	  "  -t <thread>        only diagram this thread\n"
+	  "  -n <num>           squash events to list (default: %d)\n",
+	  prog, DEF_WINDOW, max_squashes);
+  exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+  FILE *fd;
+  struct ptread_t *pt;
+  struct ptread_rec_t rec;
+  struct inst_t *ip;
+  int i, s;
+
+  for (i = 1; i < argc - 1; i++)
+    {
+      if (!strcmp(argv[i], "-d") && i + 1 < argc - 1)
+	{
+	  double start, end;
+
+	  if (sscanf(argv[++i], "%lf:%lf", &start, &end) != 2 || end <= start)
+	    usage(argv[0]);
+	  win_start = (tick_t)start;
+	  win_end = (tick_t)end;
+	}
+      else if (!strcmp(argv[i], "-t") && i + 1 < argc - 1)
+	only_thread = atoi(argv[++i]);
+      else if (!strcmp(argv[i], "-n") && i + 1 < argc - 1)
+	max_squashes = atoi(argv[++i]);
+      else
+	usage(argv[0]);
+    }
+  if (i != argc - 1)
+    usage(argv[0]);
+
+  if (!strcmp(argv[i], "-"))
+    fd = stdin;
+  else if (!(fd = fopen(argv[i], "rb")))
+    fatal("cannot open pipetrace `%s'", argv[i]);
+
+  /* binary traces are disassembled as they are printed */
+  md_init_decoder();
+
+  pt = ptread_open(fd);
+  while (ptread_next(pt, &rec))
+    {
+      switch (rec.type)
+	{
+	case PTB_NEWCYCLE:
+	  cycle = rec.cycle;
+	  if (first_cycle == NO_CYCLE)
+	    {
+	      first_cycle = cycle;
+	      if (win_start == NO_CYCLE)
+		{
+		  win_start = cycle;
+		  win_end = cycle + DEF_WINDOW;
+		}
+	    }
+	  break;
+
+	case PTB_NEWINST:
+	case PTB_NEWUOP:
+	  ip = get_live(rec.iseq, /* new */TRUE);
+	  if (ip->valid)
+	    free(ip->desc);
+	  ip->valid = TRUE;
+	  ip->iseq = rec.iseq;
+	  ip->type = rec.type;
+	  ip->pc = rec.pc;
+	  ip->addr = rec.addr;
+	  ip->thread = rec.thread;
+	  ip->fork = rec.fork;
+	  ip->level = rec.level;
+	  ip->inst_valid = rec.type == PTB_NEWINST && rec.inst_valid;
+	  ip->inst = rec.inst;
+	  ip->desc = ip->inst_valid ? NULL : mystrdup(rec.desc);
+	  for (s = 0; s < PTB_NUM_STAGES; s++)
+	    ip->stage_cycle[s] = NO_CYCLE;
+	  ip->end_cycle = NO_CYCLE;
+	  get_thread(rec.thread)->insts++;
+	  break;
+
+	case PTB_NEWSTAGE:
+	  /* stage transitions of ended instructions are ignored */
+	  if ((ip = get_live(rec.iseq, /* !new */FALSE)) != NULL)
+	    ip->stage_cycle[rec.stage] = cycle;
+	  break;
+
+	case PTB_ENDINST:
+	  if ((ip = get_live(rec.iseq, /* !new */FALSE)) != NULL)
+	    {
+	      ip->end_cycle = cycle;
+	      ip->reason = rec.reason;
+	      inst_end(ip);
+	      inst_keep(ip);
+	      ip->valid = FALSE;
+	    }
+	  break;
+
+	default:
+	  panic("bogus pipetrace record type");
+	}
+    }
+  ptread_close(pt);
+  if (fd != stdin)
+    fclose(fd);
+  squash_flush();
+
+  /* instructions still live at the end of the trace are only diagrammed */
+  for (i = 0; i < live_size; i++)
+    if (live[i].valid)
+      inst_keep(&live[i]);
+
+  if (sq_events > sq_printed)
+    fprintf(stdout, "  ... %.0f more squash events\n",
+	    (double)(sq_events - sq_printed));
+  print_threads();
+  print_histograms();
+  if (win_start != NO_CYCLE)
+    print_diagrams();
+
+  return 0;
+}
@@ -64,6 +64,8 @@
 #include "options.h"
 #include "stats.h"
 #include "bpred.h"
+#include "cfg.h"
+#include "hint.h"
 #include "sim.h"
 
 /*
@@ -108,6 +110,9 @@ static int btb_config[2] =
 /* branch predictor */
 static struct bpred_t *pred;
 
+/* fork hint file to write, or NULL */
+static char *hint_fname;
+
 /* track number of insn and refs */
 static counter_t sim_num_refs = 0;
 
@@ -179,6 +184,11 @@ sim_reg_options(struct opt_odb_t *odb)
 		   btb_config, btb_nelt, &btb_nelt,
 		   /* default */btb_config,
 		   /* print */TRUE, /* format */NULL, /* !accrue */FALSE);
+
+  opt_reg_string(odb, "-bpred:hints",
+		 "write per-branch fork hints (for sim-outorder -fork:hints)",
+		 &hint_fname, /* default */NULL,
+		 /* print */TRUE, /* format */NULL);
 }
 
 /* check simulator-specific option values */
@@ -326,6 +336,10 @@ sim_load_prog(char *fname,		/* program to load */
   /* load program text and data, set up environment, memory, and regs */
   ld_load_prog(fname, argc, argv, envp, &regs, mem, TRUE);
 
+  /* the hints record the hammock each branch guards */
+  if (hint_fname)
+    cfg_init(mem, /* no cache */NULL);
+
   /* initialize the DLite debugger */
   dlite_init(md_reg_obj, dlite_mem_obj, bpred_mstate_obj);
 }
@@ -348,7 +362,8 @@ sim_aux_stats(FILE *stream)		/* output stream */
 void
 sim_uninit(void)
 {
-  /* nada */
+  if (hint_fname)
+    hint_write(hint_fname, pred_type, mem);
 }
 
 
@@ -544,6 +559,18 @@ sim_main(void)
 			   /* correct pred? */pred_PC == regs.regs_NPC,
 			   /* opcode */op,
 			   /* predictor update pointer */&update_rec);
+
+	      /* profile the branch for the fork hints */
+	      if (hint_fname)
+		{
+		  struct hint_t *h = hint_touch(regs.regs_PC);
+
+		  if (!h->count)
+		    h->hammock = cfg_hammock_size(regs.regs_PC);
+		  h->count++;
+		  if (pred_PC != regs.regs_NPC)
+		    h->misses++;
+		}
 	    }
 	}
 
@@ -96,6 +96,9 @@ static int fastfwding = FALSE;
 static char *trace_fname;
 static FILE *trace_fd = NULL;
 
+/* write EIO traces and checkpoints as EXO text, else binary */
+static int eio_text;
+
 /* checkpoint filename and file descriptor */
 static enum { no_chkpt, one_shot_chkpt, periodic_chkpt } chkpt_kind = no_chkpt;
 static char *chkpt_fname;
@@ -145,6 +148,10 @@ sim_reg_options(struct opt_odb_t *odb)
 		 &trace_fname, /* default */NULL,
 		 /* print */TRUE, NULL);
 
+  opt_reg_flag(odb, "-eio:text",
+	       "write EIO traces and checkpoints in the EXO text format",
+	       &eio_text, /* default */FALSE, /* print */TRUE, NULL);
+
   opt_reg_string_list(odb, "-perdump",
 		      "periodic checkpoint every n instructions: "
 		      "<base fname> <interval>",
@@ -251,7 +258,7 @@ sim_load_prog(char *fname,		/* program to load */
 
       /* create the checkpoint file */
       chkpt_fname = chkpt_opts[0];
-      chkpt_fd = eio_create(chkpt_fname);
+      chkpt_fd = eio_create(chkpt_fname, !eio_text);
 
       /* indicate checkpointing is now active... */
       chkpt_kind = one_shot_chkpt;
@@ -279,7 +286,7 @@ sim_load_prog(char *fname,		/* program to load */
 	      trace_fname);
 
       /* create an EIO trace file */
-      trace_fd = eio_create(trace_fname);
+      trace_fd = eio_create(trace_fname, !eio_text);
     }
 
   /* initialize the DLite debugger */
@@ -527,7 +534,7 @@ sim_main(void)
 
 	  /* 'chkpt_fname' should be a printf format string */
 	  sprintf(this_chkpt_fname, chkpt_fname, chkpt_num);
-	  chkpt_fd = eio_create(this_chkpt_fname);
+	  chkpt_fd = eio_create(this_chkpt_fname, !eio_text);
 
 	  myfprintf(stderr, "sim: writing checkpoint file `%s' @ inst %n...\n",
 		  this_chkpt_fname, sim_num_insn);
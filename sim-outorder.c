@@ -55,6 +55,21 @@
 #include <assert.h>
 #include <signal.h>
 
+#ifdef SIM_UBENCH
+/* micro-benchmark build (linked into sim-ubench): the simulator interface
+   is renamed out of the way of sim-ubench's own, only the kernels exported
+   at the end of this file are used */
+#define sim_reg_options		outorder_reg_options
+#define sim_check_options	outorder_check_options
+#define sim_reg_stats		outorder_reg_stats
+#define sim_init		outorder_init
+#define sim_load_prog		outorder_load_prog
+#define sim_aux_config		outorder_aux_config
+#define sim_aux_stats		outorder_aux_stats
+#define sim_uninit		outorder_uninit
+#define sim_main		outorder_main
+#endif /* SIM_UBENCH */
+
 #include "host.h"
 #include "misc.h"
 #include "machine.h"
@@ -70,15 +85,27 @@
 #include "eval.h"
 #include "stats.h"
 #include "ptrace.h"
+#include "symbol.h"
+#include "cfg.h"
+#include "hint.h"
+#include "lockstep.h"
 #include "dlite.h"
 #include "sim.h"
 
 /* Need to define these at compile time
   sim-outorder has no way of recovering past a single level of misspeculation
   i.e. if I misspeculate on a branch, I can't misspeculate down the next branch*/
-#define MAX_THREADS 16
-#define MAX_SPEC_LEVELS 128
+#ifdef SIM_SINGLE_PATH
+/* single-path build (the sim-outorder-1t target): the thread count is a
+   compile-time constant, so the eager execution machinery folds away */
+#define max_threads 1
+static int max_threads_opt; /* -max:threads, must be 1 */
+#define THREAD_ID(ID) 0
+#else /* !SIM_SINGLE_PATH */
 static int max_threads; /* maximum threads allowed to run */
+#define THREAD_ID(ID) (ID)
+#endif /* SIM_SINGLE_PATH */
+static int max_spec_levels; /* maximum nested mis-speculation levels per thread */
 static int fork_penalty; /* penalty given for forking a branch */
 static int max_fetches_before_switch; /* max fetches for given thread before switching */
 int current_fetching_thread = 0;
@@ -89,14 +116,109 @@ struct thread_state {
     int spec_mode;
     int spec_level;
     int fork_counter; /* current fork counter of this thread */
-    int parent_fork_counters[MAX_THREADS]; /* Shows the fork counter of every thread. This is -1 if thread is not parent. */
+    int *parent_fork_counters; /* Shows the fork counter of every thread (max_threads entries). This is -1 if thread is not parent. */
     int in_use; /* is this thread currently in use */
     int keep_fetching; /* should we keep fetching from this thread */
+    md_addr_t fetch_blk; /* I-cache block last read by this thread */
+    tick_t fetch_blk_cycle; /* cycle in which fetch_blk was read */
+    tick_t fetch_resume; /* cycle in which a blocked thread may fetch again */
+    int RUU_num; /* live (non-squashed) RUU entries held by this thread */
+    int LSQ_num; /* live (non-squashed) LSQ entries held by this thread */
+    counter_t sta_unknown; /* LSQ allocation of this thread's oldest store of unknown address (or earlier) */
+    tick_t start_cycle; /* cycle in which this thread was last forked */
+    counter_t num_insn; /* instructions committed by this thread */
 };
 static struct thread_state *thread_states;
 static counter_t sim_num_forks = 0;
 static counter_t sim_num_nonspec_forks = 0;
 static counter_t sim_num_spec_forks = 0;
+static counter_t sim_num_hint_skips = 0;
+static counter_t fork_throttle_occ_skips = 0;
+static counter_t fork_throttle_depth_skips = 0;
+static counter_t fork_throttle_fst_skips = 0;
+static counter_t fork_fst_useful = 0;
+static counter_t fork_fst_wasted = 0;
+
+/* eager execution effectiveness: correct-path forks resolved in favour of
+   the forked thread, and the cycles they are estimated to have saved over a
+   single-path recovery (the forked path's head start plus the avoided
+   redirect penalty) */
+static counter_t fork_won = 0;
+static counter_t fork_cycles_saved = 0;
+static struct stat_stat_t *fork_depth_dist = NULL;
+static struct stat_stat_t *thread_life_dist = NULL;
+static struct stat_stat_t *lose_fetched_dist = NULL;
+static struct stat_stat_t *lose_dispatched_dist = NULL;
+static struct stat_stat_t *lose_issued_dist = NULL;
+
+/* runahead execution statistics */
+static counter_t ra_episodes = 0;
+static counter_t ra_cycles = 0;
+static counter_t ra_insts = 0;
+static counter_t ra_inv_insts = 0;
+static counter_t ra_path_stops = 0;
+static counter_t ra_loads = 0;
+static counter_t ra_prefetches = 0;
+static counter_t ra_useful_prefetches = 0;
+
+/* a forking branch, or a function's forking branches, in the fork report */
+struct frep_ent {
+  struct frep_ent *next;	/* hash chain, for branch entries */
+  md_addr_t addr;		/* branch or function address */
+  struct sym_sym_t *sym;	/* enclosing function, if known */
+  counter_t forks;		/* forks triggered */
+  counter_t won;		/* correct-path forks won */
+  counter_t wrong;		/* losing-path instructions fetched */
+  counter_t saved;		/* estimated cycles saved */
+};
+
+/* per-branch fork report totals, hashed by forking branch address; kept
+   out of the stats database, they are only printed in the fork report */
+#define FREP_HASH_SIZE		1024
+#define FREP_HASH(PC)		(((PC) >> MD_BR_SHIFT) & (FREP_HASH_SIZE - 1))
+static struct frep_ent *frep_table[FREP_HASH_SIZE];
+static int frep_nbranches = 0;
+
+/* CPI stack: each commit slot of each cycle is charged to one cause, filled
+   slots to the instructions they retired, empty ones to what kept the RUU
+   head from retiring (see cpi_account()) */
+enum cpi_cause_t {
+  cc_useful,		/* retired an instruction */
+  cc_icache,		/* RUU empty, refilling from an I-cache/I-TLB miss */
+  cc_bpred,		/* RUU empty after a mispredict, or head on its path */
+  cc_fork,		/* head on a wrong eager path, or window held by one */
+  cc_ruu_full,		/* head executing, RUU full */
+  cc_lsq_full,		/* head executing, LSQ full */
+  cc_dcache,		/* head is a load missing in the D-cache/D-TLB */
+  cc_fu,		/* head ready, waiting for a functional unit */
+  cc_squash,		/* head executing, window held by squashed entries */
+  cc_exec,		/* head executing or waiting on its operands */
+  cc_frontend,		/* RUU empty, fetch/dispatch bandwidth */
+  cc_NUM
+};
+static char *cpi_cause_name[cc_NUM] = {
+  "useful", "icache", "bpred", "fork", "ruu_full", "lsq_full", "dcache",
+  "fu", "squash_drain", "exec", "frontend"
+};
+static char *cpi_cause_desc[cc_NUM] = {
+  "retired instructions",
+  "RUU empty after an I-cache/I-TLB miss",
+  "RUU empty after a branch mispredict, or head on its wrong path",
+  "head on a wrong eager path, or window held by one",
+  "head not done, RUU full",
+  "head not done, LSQ full",
+  "head is a load missing in the D-cache/D-TLB",
+  "head ready, waiting for a functional unit or store port",
+  "head not done, window held by squashed entries",
+  "head executing or waiting on its operands",
+  "RUU empty, fetch/dispatch bandwidth"
+};
+static counter_t cpi_slots[cc_NUM];
+
+/* front-end event charged for an empty RUU, until the first instruction
+   fetched after it (ptrace sequence CPI_FE_SEQ and up) is dispatched */
+static enum cpi_cause_t cpi_fe_cause = cc_frontend;
+static unsigned int cpi_fe_seq = 0;
 
 /*
  * This file implements a very detailed out-of-order issue superscalar
@@ -126,6 +248,67 @@ static int fastfwd_count;
 static int ptrace_nelt = 0;
 static char *ptrace_opts[2];
 
+/* interval stats period and unit, output file and format */
+static int interval_nelt = 0;
+static char *interval_opts[2];
+static char *interval_fname;
+static int interval_binary;
+
+/* interval stats writer and output, interval length, unit and next end */
+static struct stat_interval_t *stat_interval = NULL;
+static FILE *interval_fd = NULL;
+static counter_t interval_size = 0;
+static int interval_by_cycles = FALSE;
+static counter_t interval_next = 0;
+
+/* host time self-profiling sample period in cycles, 0 if not profiling */
+static int prof_interval;
+
+/* progress heartbeat period in host seconds, 0 if no heartbeat */
+static int heartbeat_secs;
+
+/* check every committed instruction against a functional core? */
+static int lockstep_mode;
+
+/* rolling digest of the committed instruction stream, see lockstep.h */
+static qword_t commit_digest = ULL(0xcbf29ce484222325);
+
+/* self-profiled pipeline stages */
+enum prof_stage_t {
+  ps_commit,		/* ruu_commit() */
+  ps_writeback,		/* ruu_writeback() */
+  ps_lsq_refresh,	/* lsq_refresh() */
+  ps_issue,		/* ruu_issue() */
+  ps_dispatch,		/* ruu_dispatch() */
+  ps_fetch,		/* ruu_fetch() */
+  ps_NUM
+};
+static char *prof_stage_name[ps_NUM] = {
+  "ruu_commit", "ruu_writeback", "lsq_refresh", "ruu_issue", "ruu_dispatch",
+  "ruu_fetch"
+};
+
+/* self-profiling state, host ns spent per stage and in all sampled cycles */
+static double prof_nsecs[ps_NUM];
+static double prof_cycle_nsecs = 0.0;
+static counter_t prof_samples = 0;
+static int prof_countdown = 1;
+static int prof_sample = FALSE;
+static double prof_cycle_t0;
+
+/* run pipeline stage CALL, timing it as STAGE in sampled cycles */
+#define PROF_STAGE(STAGE, CALL)						\
+  do {									\
+    if (prof_sample)							\
+      {									\
+	double prof_t0 = host_nsecs();					\
+	CALL;								\
+	prof_nsecs[STAGE] += host_nsecs() - prof_t0;			\
+      }									\
+    else								\
+      CALL;								\
+  } while (0)
+
 /* instruction fetch queue size (in insts) */
 static int ruu_ifq_size;
 
@@ -135,6 +318,12 @@ static int ruu_branch_penalty;
 /* speed of front-end of machine relative to execution core */
 static int fetch_speed;
 
+/* maximum number of eager threads fetched from in one cycle */
+static int fetch_threads;
+
+/* number of I-cache banks, 0 if bank conflicts are not modeled */
+static int fetch_ibanks;
+
 /* branch predictor type {nottaken|taken|perfect|bimod|2lev} */
 static char *pred_type;
 
@@ -182,6 +371,82 @@ static int RUU_size = 8;
 /* load/store queue (LSQ) size */
 static int LSQ_size = 4;
 
+/* RUU/LSQ capacity sharing among eager threads */
+static char *window_share_opt;
+static enum {
+  ws_shared,			/* free for all, subject to per-thread caps */
+  ws_static,			/* equal fixed partition per thread */
+  ws_dcra			/* dynamic: speculative threads get 1/T share */
+} window_share;
+
+/* per-thread RUU and LSQ occupancy caps, 0 if uncapped */
+static int RUU_thread_max;
+static int LSQ_thread_max;
+
+/* memory dependence policy for loads behind stores of unknown address */
+static char *memdep_opt;
+static enum {
+  md_none,			/* ignore unknown store addresses, no checks */
+  md_conservative,		/* wait for all earlier store addresses */
+  md_blind,			/* always issue, recover on violations */
+  md_storeset			/* store-set predictor decides */
+} memdep_policy;
+
+/* store set identifier table (SSIT) and last fetched store table (LFST)
+   sizes */
+static int ssit_size;
+static int lfst_size;
+
+/* extra latency of store address generation, forces loads past unresolved
+   stores so the violation and store-set paths can be exercised */
+static int sta_delay;
+
+/* fork hint file (from sim-bpred -bpred:hints), forking is restricted to
+   the branches it lists as hard to predict */
+static char *fork_hints_fname;
+
+/* minimum profiled mis-prediction rate of a hinted fork branch */
+static double fork_hint_rate;
+
+/* maximum hammock size of a hinted fork branch, 0 for any */
+static int fork_hint_hammock;
+
+/* per-branch fork report, written to this file at exit (with a summary
+   table of the top fork_report_top branches and functions in the stats) */
+static char *fork_report_fname;
+static int fork_report_top;
+
+/* adaptive fork throttling: forks are refused while the RUU, LSQ or IFQ is
+   at least fork_throttle_occ percent full, beyond fork_throttle_depth
+   levels of the fork tree (0 for any), or at branches whose recent forks
+   the fork success table (FST) shows to have been wasted */
+static int fork_throttle;
+static int fork_throttle_occ;
+static int fork_throttle_depth;
+static int fst_size;
+
+/* runahead execution: while a load that missed in the L2 blocks commit with
+   the window full, run ahead of the window on a checkpoint of the register
+   state to turn the loads that follow into prefetches */
+static int runahead;
+static unsigned int ra_miss_lat;	/* load latency beyond an L2 hit */
+
+/* control independence: how the reconvergence point of a mis-predicted
+   branch is found, so that post-reconvergence work survives the squash */
+static char *reconv_opt;
+static enum {
+  rc_none,			/* no reconvergence, squash everything */
+  rc_static,			/* immediate post-dominator in the CFG */
+  rc_dynamic			/* learned per branch in the RCT */
+} reconv_policy;
+
+/* reconvergence table (RCT) entries, for dynamic reconvergence */
+static int rct_size;
+
+/* build a static CFG of the program text, and its sidecar cache file */
+static int cfg_enable;
+static char *cfg_cache_opt;
+
 /* l1 data cache config, i.e., {<config>|none} */
 static char *cache_dl1_opt;
 
@@ -249,6 +514,9 @@ static int res_fpmult;
 static int pcstat_nelt = 0;
 static char *pcstat_vars[MAX_PCSTAT_VARS];
 
+/* split cache, TLB and branch predictor stats by correct/wrong-path origin */
+static int wrongpath_stats;
+
 /* convert 64-bit inst text addresses to 32-bit inst equivalents */
 #ifdef TARGET_PISA
 #define IACOMPRESS(A)							\
@@ -355,6 +623,18 @@ static counter_t sim_total_branches = 0;
 /* cycle counter */
 static tick_t sim_cycle = 0;
 
+/* total number of instructions fetched */
+static counter_t fetch_total_insn = 0;
+
+/* total number of I-cache fetch block reads */
+static counter_t fetch_blocks = 0;
+
+/* total number of fetch blocks delayed by I-cache bank conflicts */
+static counter_t fetch_bank_conflicts = 0;
+
+/* distribution of eager threads fetched from per cycle */
+static struct stat_stat_t *fetch_threads_dist = NULL;
+
 /* occupancy counters */
 static counter_t IFQ_count;		/* cumulative IFQ occupancy */
 static counter_t IFQ_fcount;		/* cumulative IFQ full count */
@@ -363,6 +643,29 @@ static counter_t RUU_fcount;		/* cumulative RUU full count */
 static counter_t LSQ_count;		/* cumulative LSQ occupancy */
 static counter_t LSQ_fcount;		/* cumulative LSQ full count */
 
+/* eager thread window sharing counters */
+static counter_t window_thread_stalls;	/* dispatch stalls on thread limit */
+static counter_t window_fetch_gated;	/* fetches refused on thread limit */
+static counter_t RUU_squash_reclaimed;	/* RUU entries freed at squash */
+static counter_t IFQ_squash_reclaimed;	/* IFQ entries freed at squash */
+
+/* memory dependence speculation counters */
+static counter_t lsq_spec_loads;	/* loads issued past unknown STAs */
+static counter_t lsq_mem_violations;	/* memory ordering violations */
+static counter_t lsq_pred_deps;		/* loads held by the store sets */
+static counter_t lsq_false_deps;	/* ... for a store to another addr */
+
+/* control independence counters */
+static counter_t ci_captures;		/* squashes that kept the losing path */
+static counter_t ci_wrong_path_insn;	/* losing-path insts kept */
+static counter_t ci_reconv;		/* winners that reached reconvergence */
+static counter_t ci_no_reconv;		/* ... that never did */
+static counter_t ci_diverged;		/* ... that later left the kept path */
+static counter_t ci_reused_insn;	/* post-reconvergence results reused */
+static counter_t ci_reexec_insn;	/* ... that had to execute again */
+static counter_t rct_hits;		/* RCT lookups that hit */
+static counter_t rct_misses;		/* ... that missed */
+
 /* total non-speculative bogus addresses seen (debug var) */
 static counter_t sim_invalid_addrs;
 
@@ -615,6 +918,36 @@ sim_reg_options(struct opt_odb_t *odb)
 	      ptrace_opts, /* arr_sz */2, &ptrace_nelt, /* default */NULL,
 	      /* !print */FALSE, /* format */NULL, /* !accrue */FALSE);
 
+  opt_reg_flag(odb, "-ptrace:binary",
+	       "write the pipetrace in the binary format (see ptrace2txt)",
+	       &ptrace_binary, /* default */FALSE, /* print */TRUE, NULL);
+
+  opt_reg_string_list(odb, "-stats:interval",
+	      "write interval stats every <N> <insts|cycles>",
+	      interval_opts, /* arr_sz */2, &interval_nelt, /* default */NULL,
+	      /* !print */FALSE, /* format */NULL, /* !accrue */FALSE);
+  opt_reg_string(odb, "-stats:interval_out",
+		 "interval stats output file (default: stderr)",
+		 &interval_fname, /* default */NULL,
+		 /* print */TRUE, /* format */NULL);
+  opt_reg_flag(odb, "-stats:interval_binary",
+	       "write interval stats in the binary columnar format",
+	       &interval_binary, /* default */FALSE, /* print */TRUE, NULL);
+
+  opt_reg_int(odb, "-prof:interval",
+	      "sample host time per pipeline stage every <N> cycles (0 = off)",
+	      &prof_interval, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+  opt_reg_int(odb, "-heartbeat",
+	      "print progress to stderr every <N> host seconds (0 = off)",
+	      &heartbeat_secs, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_flag(odb, "-lockstep",
+	       "check each committed instruction against a functional core, "
+	       "stop at the first divergence",
+	       &lockstep_mode, /* default */FALSE, /* print */TRUE, NULL);
+
   opt_reg_note(odb,
 "  Pipetrace range arguments are formatted as follows:\n"
 "\n"
@@ -650,6 +983,24 @@ sim_reg_options(struct opt_odb_t *odb)
 	      &fetch_speed, /* default */1,
 	      /* print */TRUE, /* format */NULL);
 
+  opt_reg_int(odb, "-fetch:threads",
+	      "maximum number of eager threads fetched from per cycle",
+	      &fetch_threads, /* default */1,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fetch:ibanks",
+	      "number of I-cache banks (0 for no bank conflicts)",
+	      &fetch_ibanks, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_note(odb,
+"  With -fetch:threads greater than one, each cycle up to that many eager\n"
+"  threads fetch one I-cache block apiece, sharing the decode bandwidth.  An\n"
+"  I-cache miss blocks only the missing thread.  When -fetch:ibanks is set,\n"
+"  two different blocks from the same I-cache bank in one cycle conflict,\n"
+"  and the later thread retries in the next cycle.\n"
+	       );
+
   /* branch predictor options */
 
   opt_reg_note(odb,
@@ -752,6 +1103,77 @@ sim_reg_options(struct opt_odb_t *odb)
 	      &LSQ_size, /* default */8,
 	      /* print */TRUE, /* format */NULL);
 
+  /* memory dependence options */
+
+  opt_reg_string(odb, "-lsq:memdep",
+		 "load/store dependence policy {none|conservative|blind|storeset}",
+		 &memdep_opt, /* default */"none",
+		 /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-lsq:ssit",
+	      "store set identifier table (SSIT) entries",
+	      &ssit_size, /* default */1024,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-lsq:lfst",
+	      "last fetched store table (LFST) entries, i.e., store sets",
+	      &lfst_size, /* default */128,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-lsq:sta_delay",
+	      "extra store address generation cycles, forces violations (debug)",
+	      &sta_delay, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_note(odb,
+"  The -lsq:memdep policy decides when a load may issue past earlier stores\n"
+"  whose addresses are not yet computed:\n"
+"\n"
+"    none          - such stores are ignored and never cause a violation\n"
+"    conservative  - the load waits for every earlier store address\n"
+"    blind         - the load always issues; if one of those stores turns out\n"
+"                    to write the load's address, the violation is detected\n"
+"                    when the store address resolves and the load re-executes\n"
+"    storeset      - as blind, but a store-set predictor (SSIT/LFST, trained\n"
+"                    on violations) makes the load wait for its predicted store\n"
+"\n"
+"  Correct-path instructions execute functionally at dispatch, so a\n"
+"  violation re-issues the load (and stalls fetch for the branch penalty)\n"
+"  instead of squashing and refetching younger instructions.\n"
+"  -lsq:sta_delay delays store address generation, so loads issue past\n"
+"  unresolved stores and the violation path can be exercised.\n"
+	       );
+
+  /* eager thread window sharing options */
+
+  opt_reg_string(odb, "-ruu:share",
+		 "RUU/LSQ sharing among eager threads {shared|static|dcra}",
+		 &window_share_opt, /* default */"shared",
+		 /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-ruu:thread_max",
+	      "maximum RUU entries held by one thread (0 for no limit)",
+	      &RUU_thread_max, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-lsq:thread_max",
+	      "maximum LSQ entries held by one thread (0 for no limit)",
+	      &LSQ_thread_max, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_note(odb,
+"  The -ruu:share policy divides the RUU and LSQ among eager threads:\n"
+"\n"
+"    shared  - threads allocate freely, up to -ruu:thread_max/-lsq:thread_max\n"
+"    static  - each thread owns 1/max:threads of each queue\n"
+"    dcra    - the non-speculative thread may use the whole queue, each\n"
+"              speculative thread is held to 1/T of it, T = threads in use\n"
+"\n"
+"  A thread at its limit is not fetched from, and dispatch stalls when the\n"
+"  next instruction belongs to it.  Squashed entries stop counting against\n"
+"  their thread at once; those at the RUU/LSQ tail are freed immediately.\n"
+       );
+
   /* cache options */
 
   opt_reg_string(odb, "-cache:dl1",
@@ -888,14 +1310,27 @@ sim_reg_options(struct opt_odb_t *odb)
 		      pcstat_vars, MAX_PCSTAT_VARS, &pcstat_nelt, NULL,
 		      /* !print */FALSE, /* format */NULL, /* accrue */TRUE);
 
+  opt_reg_flag(odb, "-stats:wrongpath",
+	       "split cache and predictor stats by correct/wrong-path origin",
+	       &wrongpath_stats, /* default */FALSE,
+	       /* print */TRUE, /* format */NULL);
+
   opt_reg_flag(odb, "-bugcompat",
 	       "operate in backward-compatible bugs mode (for testing only)",
 	       &bugcompat_mode, /* default */FALSE, /* print */TRUE, NULL);
 
   opt_reg_int(odb, "-max:threads",
         "maximum number of threads at any given moment",
+#ifdef SIM_SINGLE_PATH
+        &max_threads_opt, /* default */1,
+#else /* !SIM_SINGLE_PATH */
         &max_threads, /* default */1,
+#endif /* SIM_SINGLE_PATH */
         /* print */TRUE, /* format */NULL);
+   opt_reg_int(odb, "-max:spec_levels",
+         "maximum nested mis-speculation levels per thread",
+         &max_spec_levels, /* default */128,
+         /* print */TRUE, /* format */NULL);
    opt_reg_int(odb, "-fork_penalty",
          "penalty to total cycles for forking a thread",
          &fork_penalty, /* default */0,
@@ -904,6 +1339,100 @@ sim_reg_options(struct opt_odb_t *odb)
          "maximum number of insns fetched for a single thread before switching",
          &max_fetches_before_switch, /* default */1,
          /* print */TRUE, /* format */NULL);
+
+  /* fork hint options */
+
+  opt_reg_string(odb, "-fork:hints",
+		 "fork only at branches hinted in this file (sim-bpred -bpred:hints)",
+		 &fork_hints_fname, /* default */NULL,
+		 /* print */TRUE, /* format */NULL);
+
+  opt_reg_double(odb, "-fork:hint_rate",
+		 "minimum profiled mis-prediction rate of a hinted branch",
+		 &fork_hint_rate, /* default */0.05,
+		 /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fork:hint_hammock",
+	      "maximum hammock size of a hinted branch (0 = any branch)",
+	      &fork_hint_hammock, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_flag(odb, "-fork:throttle",
+	       "throttle forking by window occupancy, depth and fork success",
+	       &fork_throttle, /* default */FALSE,
+	       /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fork:throttle_occ",
+	      "no forks while RUU, LSQ or IFQ is this percent full",
+	      &fork_throttle_occ, /* default */100,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fork:throttle_depth",
+	      "maximum fork-tree depth of a forked thread (0 = any)",
+	      &fork_throttle_depth, /* default */0,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fork:fst",
+	      "fork success table size (power of two)",
+	      &fst_size, /* default */1024,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_flag(odb, "-runahead",
+	       "run ahead past commit-blocking L2 misses to prefetch",
+	       &runahead, /* default */FALSE,
+	       /* print */TRUE, /* format */NULL);
+
+  opt_reg_string(odb, "-fork:report",
+		 "write a per-branch fork report to this file",
+		 &fork_report_fname, /* default */NULL,
+		 /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fork:report_top",
+	      "branches and functions listed in the fork report summary",
+	      &fork_report_top, /* default */20,
+	      /* print */TRUE, /* format */NULL);
+
+  /* control independence options */
+
+  opt_reg_string(odb, "-fork:reconv",
+		 "reconvergence detection for squashed paths {none|static|dynamic}",
+		 &reconv_opt, /* default */"none",
+		 /* print */TRUE, /* format */NULL);
+
+  opt_reg_int(odb, "-fork:rct",
+	      "reconvergence table (RCT) entries, for -fork:reconv dynamic",
+	      &rct_size, /* default */256,
+	      /* print */TRUE, /* format */NULL);
+
+  opt_reg_note(odb,
+"  When a mis-predicted (or forked) branch resolves, -fork:reconv keeps the\n"
+"  losing path's instructions past the point where both paths reconverge:\n"
+"\n"
+"    none     - the whole losing path is squashed and re-executed\n"
+"    static   - the branch's immediate post-dominator in the static CFG\n"
+"               of the text segment (implies -cfg)\n"
+"    dynamic  - the reconvergence point is learned per branch in the RCT,\n"
+"               found on a miss by matching the winning path against the\n"
+"               squashed one\n"
+"\n"
+"  After reconvergence, an instruction reading no register (or memory)\n"
+"  written on either path since the branch is control independent: if its\n"
+"  squashed copy had completed, the winning path reuses that result and\n"
+"  skips execution.  Data-dependent instructions execute again.  The\n"
+"  winning path is still fetched and dispatched, since correct-path\n"
+"  instructions execute functionally at dispatch.\n"
+	       );
+
+  /* static control flow analysis options */
+
+  opt_reg_flag(odb, "-cfg",
+	       "build a static CFG (blocks, post-dominators, loops) of the text",
+	       &cfg_enable, /* default */FALSE, /* print */TRUE, NULL);
+
+  opt_reg_string(odb, "-cfg:cache",
+		 "CFG cache file {none|auto|<file>}, auto is <program>.cfg",
+		 &cfg_cache_opt, /* default */"none",
+		 /* print */TRUE, /* format */NULL);
 }
 
 /* check simulator-specific option values */
@@ -917,6 +1446,29 @@ sim_check_options(struct opt_odb_t *odb,        /* options database */
   if (fastfwd_count < 0 || fastfwd_count >= 2147483647)
     fatal("bad fast forward count: %d", fastfwd_count);
 
+  if (interval_nelt > 0)
+    {
+      if (interval_nelt == 2 && !mystricmp(interval_opts[1], "cycles"))
+	interval_by_cycles = TRUE;
+      else if (interval_nelt == 2 && mystricmp(interval_opts[1], "insts"))
+	fatal("bad interval stats unit `%s', use: <N> <insts|cycles>",
+	      interval_opts[1]);
+      interval_size = (counter_t)atof(interval_opts[0]);
+      if (interval_size < 1)
+	fatal("bad interval stats period `%s', use: <N> <insts|cycles>",
+	      interval_opts[0]);
+      if (interval_binary && !interval_fname)
+	fatal("binary interval stats need an output file, "
+	      "see `-stats:interval_out'");
+    }
+  else if (interval_fname || interval_binary)
+    fatal("interval stats output options need `-stats:interval'");
+
+  if (prof_interval < 0)
+    fatal("bad self-profiling sample period: %d", prof_interval);
+  if (heartbeat_secs < 0)
+    fatal("bad heartbeat period: %d", heartbeat_secs);
+
   if (ruu_ifq_size < 1 || (ruu_ifq_size & (ruu_ifq_size - 1)) != 0)
     fatal("inst fetch queue size must be positive > 0 and a power of two");
 
@@ -926,6 +1478,12 @@ sim_check_options(struct opt_odb_t *odb,        /* options database */
   if (fetch_speed < 1)
     fatal("front-end speed must be positive and non-zero");
 
+  if (fetch_threads < 1)
+    fatal("fetch threads per cycle must be positive and non-zero");
+
+  if (fetch_ibanks < 0 || (fetch_ibanks & (fetch_ibanks - 1)) != 0)
+    fatal("number of I-cache banks must be zero or a power of two");
+
   if (!mystricmp(pred_type, "perfect"))
     {
       /* perfect predictor */
@@ -1031,6 +1589,94 @@ sim_check_options(struct opt_odb_t *odb,        /* options database */
   if (LSQ_size < 2 || (LSQ_size & (LSQ_size-1)) != 0)
     fatal("LSQ size must be a positive number > 1 and a power of two");
 
+  if (!mystricmp(window_share_opt, "shared"))
+    window_share = ws_shared;
+  else if (!mystricmp(window_share_opt, "static"))
+    window_share = ws_static;
+  else if (!mystricmp(window_share_opt, "dcra"))
+    window_share = ws_dcra;
+  else
+    fatal("bad RUU sharing policy `%s', use {shared|static|dcra}",
+	  window_share_opt);
+
+  if (!mystricmp(memdep_opt, "none"))
+    memdep_policy = md_none;
+  else if (!mystricmp(memdep_opt, "conservative"))
+    memdep_policy = md_conservative;
+  else if (!mystricmp(memdep_opt, "blind"))
+    memdep_policy = md_blind;
+  else if (!mystricmp(memdep_opt, "storeset"))
+    memdep_policy = md_storeset;
+  else
+    fatal("bad memory dependence policy `%s', "
+	  "use {none|conservative|blind|storeset}", memdep_opt);
+  if (sta_delay < 0)
+    fatal("store address delay must be non-negative");
+
+  if (!mystricmp(reconv_opt, "none"))
+    reconv_policy = rc_none;
+  else if (!mystricmp(reconv_opt, "static"))
+    reconv_policy = rc_static;
+  else if (!mystricmp(reconv_opt, "dynamic"))
+    reconv_policy = rc_dynamic;
+  else
+    fatal("bad reconvergence policy `%s', use {none|static|dynamic}",
+	  reconv_opt);
+
+  if (rct_size < 1 || (rct_size & (rct_size - 1)) != 0)
+    fatal("RCT size must be a positive number and a power of two");
+
+  if (fork_hint_rate < 0.0 || fork_hint_rate > 1.0)
+    fatal("fork hint mis-prediction rate must be between 0 and 1");
+
+  if (fork_hint_hammock < 0)
+    fatal("fork hint hammock size must be non-negative");
+
+  if (fork_hints_fname)
+    hint_load(fork_hints_fname);
+
+#ifdef SIM_SINGLE_PATH
+  if (max_threads_opt != 1)
+    fatal("this is a single-path build, -max:threads must be 1");
+#endif /* SIM_SINGLE_PATH */
+
+  if (max_threads < 1)
+    fatal("maximum thread count must be positive");
+
+  if (max_spec_levels < 1)
+    fatal("maximum mis-speculation levels must be positive");
+
+  if (fork_report_top < 0)
+    fatal("fork report length must be non-negative");
+
+  if (fork_throttle && max_threads == 1)
+    fatal("fork throttling needs forking, -max:threads must be above 1");
+
+  if (fork_throttle_occ < 1 || fork_throttle_occ > 100)
+    fatal("fork throttle occupancy must be between 1 and 100 percent");
+
+  if (fork_throttle_depth < 0)
+    fatal("fork throttle depth must be non-negative");
+
+  if (fst_size < 1 || (fst_size & (fst_size - 1)) != 0)
+    fatal("FST size must be a positive number and a power of two");
+
+  /* static reconvergence needs the post-dominators */
+  if (reconv_policy == rc_static)
+    cfg_enable = TRUE;
+
+  if (ssit_size < 1 || (ssit_size & (ssit_size - 1)) != 0)
+    fatal("SSIT size must be a positive number and a power of two");
+
+  if (lfst_size < 1 || (lfst_size & (lfst_size - 1)) != 0)
+    fatal("LFST size must be a positive number and a power of two");
+
+  if (RUU_thread_max < 0 || RUU_thread_max > RUU_size)
+    fatal("per-thread RUU limit must be between 0 and the RUU size");
+
+  if (LSQ_thread_max < 0 || LSQ_thread_max > LSQ_size)
+    fatal("per-thread LSQ limit must be between 0 and the LSQ size");
+
   /* use a level 1 D-cache? */
   if (!mystricmp(cache_dl1_opt, "none"))
     {
@@ -1155,6 +1801,37 @@ sim_check_options(struct opt_odb_t *odb,        /* options database */
 			  /* hit latency */1);
     }
 
+  if (fetch_ibanks && !cache_il1)
+    fatal("I-cache banks require an l1 instruction cache");
+
+  if (wrongpath_stats)
+    {
+      if (cache_il1)
+	cache_track_origin(cache_il1);
+      if (cache_il2)
+	cache_track_origin(cache_il2);
+      if (cache_dl1)
+	cache_track_origin(cache_dl1);
+      if (cache_dl2)
+	cache_track_origin(cache_dl2);
+      if (itlb)
+	cache_track_origin(itlb);
+      if (dtlb)
+	cache_track_origin(dtlb);
+      if (pred)
+	bpred_track_origin(pred);
+    }
+
+  if (runahead)
+    {
+      /* the runahead thread owns the (global) speculative memory state */
+      if (max_threads != 1)
+	fatal("runahead execution requires `-max:threads 1'");
+      if (!cache_dl1)
+	fatal("runahead execution requires an l1 data cache");
+      ra_miss_lat = cache_dl1_lat + (cache_dl2 ? cache_dl2_lat : 0);
+    }
+
   if (cache_dl1_lat < 1)
     fatal("l1 data cache latency must be greater than zero");
 
@@ -1225,6 +1902,9 @@ sim_reg_stats(struct stat_sdb_t *sdb)   /* stats database */
   stat_reg_counter(sdb, "sim_num_insn",
 		   "total number of instructions committed",
 		   &sim_num_insn, sim_num_insn, NULL);
+  stat_reg_qword(sdb, "sim_commit_digest",
+		 "digest of the committed PCs, results and store data",
+		 &commit_digest, commit_digest, "0x%016lx");
   stat_reg_counter(sdb, "sim_num_refs",
 		   "total number of loads and stores committed",
 		   &sim_num_refs, 0, NULL);
@@ -1240,6 +1920,191 @@ sim_reg_stats(struct stat_sdb_t *sdb)   /* stats database */
   stat_reg_counter(sdb, "sim_num_spec_forks",
   		   "total number of forks created",
   		   &sim_num_spec_forks, 0, NULL);
+  if (fork_hints_fname)
+    {
+      stat_reg_int(sdb, "fork_hints",
+		   "branches profiled in the fork hint file",
+		   &hint_nhints, hint_nhints, NULL);
+      stat_reg_counter(sdb, "sim_num_hint_skips",
+		       "forks not taken at branches the hints rule out",
+		       &sim_num_hint_skips, 0, NULL);
+    }
+  if (max_threads > 1)
+    {
+      stat_reg_counter(sdb, "fork_won",
+		       "correct-path forks resolved in favour of the forked path",
+		       &fork_won, 0, NULL);
+      stat_reg_counter(sdb, "fork_cycles_saved",
+		       "est. cycles saved over single-path mis-pred recovery",
+		       &fork_cycles_saved, 0, NULL);
+      stat_reg_formula(sdb, "fork_cycles_per_win",
+		       "est. cycles saved per winning fork",
+		       "fork_cycles_saved / fork_won", NULL);
+      fork_depth_dist =
+	stat_reg_dist(sdb, "fork_depth_dist",
+		      "fork-tree depth of forking threads (0 = root path)",
+		      /* initial value */0,
+		      /* array size */max_threads - 1,
+		      /* bucket size */1,
+		      /* print format */(PF_COUNT|PF_PDF),
+		      /* format */NULL,
+		      /* index map */NULL,
+		      /* print fn */NULL);
+      thread_life_dist =
+	stat_reg_dist(sdb, "thread_life_dist",
+		      "thread lifetime in cycles, fork to release",
+		      /* initial value */0,
+		      /* array size */32,
+		      /* bucket size */16,
+		      /* print format */(PF_COUNT|PF_PDF),
+		      /* format */NULL,
+		      /* index map */NULL,
+		      /* print fn */NULL);
+      lose_fetched_dist =
+	stat_reg_dist(sdb, "lose_fetched_dist",
+		      "instructions fetched per losing fork path",
+		      /* initial value */0,
+		      /* array size */32,
+		      /* bucket size */4,
+		      /* print format */(PF_COUNT|PF_PDF),
+		      /* format */NULL,
+		      /* index map */NULL,
+		      /* print fn */NULL);
+      lose_dispatched_dist =
+	stat_reg_dist(sdb, "lose_dispatched_dist",
+		      "instructions dispatched per losing fork path",
+		      /* initial value */0,
+		      /* array size */32,
+		      /* bucket size */4,
+		      /* print format */(PF_COUNT|PF_PDF),
+		      /* format */NULL,
+		      /* index map */NULL,
+		      /* print fn */NULL);
+      lose_issued_dist =
+	stat_reg_dist(sdb, "lose_issued_dist",
+		      "instructions issued per losing fork path",
+		      /* initial value */0,
+		      /* array size */32,
+		      /* bucket size */4,
+		      /* print format */(PF_COUNT|PF_PDF),
+		      /* format */NULL,
+		      /* index map */NULL,
+		      /* print fn */NULL);
+      for (i=0; i<max_threads; i++)
+	{
+	  char buf[128], buf1[128];
+
+	  sprintf(buf, "thread_%d.sim_num_insn", i);
+	  sprintf(buf1, "instructions committed by thread %d", i);
+	  stat_reg_counter(sdb, buf, buf1,
+			   &thread_states[i].num_insn, 0, NULL);
+	  sprintf(buf1, "thread_%d.sim_num_insn / sim_cycle", i);
+	  sprintf(buf, "thread_%d.sim_IPC", i);
+	  stat_reg_formula(sdb, buf, "per-thread instructions per cycle",
+			   buf1, NULL);
+	}
+    }
+  if (fork_throttle)
+    {
+      stat_reg_counter(sdb, "fork_throttle_occ_skips",
+		       "forks refused on RUU/LSQ/IFQ occupancy",
+		       &fork_throttle_occ_skips, 0, NULL);
+      stat_reg_counter(sdb, "fork_throttle_depth_skips",
+		       "forks refused on fork-tree depth",
+		       &fork_throttle_depth_skips, 0, NULL);
+      stat_reg_counter(sdb, "fork_throttle_fst_skips",
+		       "forks refused on the branch's fork success history",
+		       &fork_throttle_fst_skips, 0, NULL);
+      stat_reg_formula(sdb, "fork_throttle_rate",
+		       "fraction of fork opportunities refused by the throttle",
+		       "(fork_throttle_occ_skips + fork_throttle_depth_skips"
+		       " + fork_throttle_fst_skips) / (sim_num_forks"
+		       " + fork_throttle_occ_skips + fork_throttle_depth_skips"
+		       " + fork_throttle_fst_skips)", NULL);
+      stat_reg_counter(sdb, "fork_fst_useful",
+		       "forks resolved on the correct path (FST trained up)",
+		       &fork_fst_useful, 0, NULL);
+      stat_reg_counter(sdb, "fork_fst_wasted",
+		       "forks squashed before resolving (FST trained down)",
+		       &fork_fst_wasted, 0, NULL);
+    }
+  if (runahead)
+    {
+      stat_reg_counter(sdb, "ra_episodes",
+		       "runahead episodes (commit-blocking L2 misses)",
+		       &ra_episodes, 0, NULL);
+      stat_reg_counter(sdb, "ra_cycles",
+		       "cycles spent in runahead mode",
+		       &ra_cycles, 0, NULL);
+      stat_reg_formula(sdb, "ra_cycles_per_episode",
+		       "average runahead episode length",
+		       "ra_cycles / ra_episodes", NULL);
+      stat_reg_counter(sdb, "ra_insts",
+		       "insts executed in runahead mode (overhead)",
+		       &ra_insts, 0, NULL);
+      stat_reg_counter(sdb, "ra_inv_insts",
+		       "runahead insts with an unknown (INV) source",
+		       &ra_inv_insts, 0, NULL);
+      stat_reg_formula(sdb, "ra_inst_overhead",
+		       "runahead insts per committed inst",
+		       "ra_insts / sim_num_insn", NULL);
+      stat_reg_counter(sdb, "ra_path_stops",
+		       "episodes stopped early at a trap or INV indirect jump",
+		       &ra_path_stops, 0, NULL);
+      stat_reg_counter(sdb, "ra_loads",
+		       "runahead loads sent to the data cache",
+		       &ra_loads, 0, NULL);
+      stat_reg_counter(sdb, "ra_prefetches",
+		       "runahead loads that missed in the L1 (prefetches)",
+		       &ra_prefetches, 0, NULL);
+      stat_reg_counter(sdb, "ra_useful_prefetches",
+		       "correct-path loads to a block runahead prefetched",
+		       &ra_useful_prefetches, 0, NULL);
+      stat_reg_formula(sdb, "ra_prefetch_accuracy",
+		       "fraction of runahead prefetches used",
+		       "ra_useful_prefetches / ra_prefetches", NULL);
+    }
+  if (prof_interval)
+    {
+      char buf[512], buf1[512], buf2[512], other[1024];
+
+      stat_reg_counter(sdb, "host_prof.samples",
+		       "cycles sampled for host time self-profiling",
+		       &prof_samples, 0, NULL);
+      stat_reg_double(sdb, "host_prof.cycle_ns",
+		      "host ns spent in sampled cycles",
+		      &prof_cycle_nsecs, 0.0, "%12.0f");
+      stat_reg_formula(sdb, "host_prof.ns_per_cycle",
+		       "host ns per simulated cycle",
+		       "host_prof.cycle_ns / host_prof.samples", NULL);
+      strcpy(other, "1 - (0");
+      for (i=0; i<ps_NUM; i++)
+	{
+	  sprintf(buf, "host_prof.%s_ns", prof_stage_name[i]);
+	  sprintf(buf1, "host ns spent in %s() in sampled cycles",
+		  prof_stage_name[i]);
+	  stat_reg_double(sdb, buf, buf1, &prof_nsecs[i], 0.0, "%12.0f");
+	  sprintf(buf, "host_prof.%s_frac", prof_stage_name[i]);
+	  sprintf(buf1, "fraction of sampled host time in %s()",
+		  prof_stage_name[i]);
+	  sprintf(buf2, "host_prof.%s_ns / host_prof.cycle_ns",
+		  prof_stage_name[i]);
+	  stat_reg_formula(sdb, buf, buf1, buf2, NULL);
+	  sprintf(other + strlen(other), " + host_prof.%s_ns",
+		  prof_stage_name[i]);
+	}
+      strcat(other, ") / host_prof.cycle_ns");
+      stat_reg_formula(sdb, "host_prof.other_frac",
+		       "fraction of sampled host time outside the stages above",
+		       other, NULL);
+      stat_reg_double(sdb, "host_prof.cache_access_ns",
+		      "host ns spent in cache_access() in sampled cycles "
+		      "(part of the stages)",
+		      &cache_prof_nsecs, 0.0, "%12.0f");
+      stat_reg_formula(sdb, "host_prof.cache_access_frac",
+		       "fraction of sampled host time in cache_access()",
+		       "host_prof.cache_access_ns / host_prof.cycle_ns", NULL);
+    }
   stat_reg_formula(sdb, "sim_num_stores",
 		   "total number of stores committed",
 		   "sim_num_refs - sim_num_loads", NULL);
@@ -1279,6 +2144,26 @@ sim_reg_stats(struct stat_sdb_t *sdb)   /* stats database */
   stat_reg_formula(sdb, "sim_CPI",
 		   "cycles per instruction",
 		   "sim_cycle / sim_num_insn", /* format */NULL);
+
+  /* CPI stack, the cpi.* components add up to sim_CPI */
+  for (i=0; i<cc_NUM; i++)
+    {
+      char buf[128], buf1[128];
+
+      sprintf(buf, "cpi_slots.%s", cpi_cause_name[i]);
+      sprintf(buf1, "commit slots: %s", cpi_cause_desc[i]);
+      stat_reg_counter(sdb, buf, buf1, &cpi_slots[i], 0, NULL);
+    }
+  for (i=0; i<cc_NUM; i++)
+    {
+      char buf[128], buf1[128], buf2[128];
+
+      sprintf(buf, "cpi.%s", cpi_cause_name[i]);
+      sprintf(buf1, "CPI component: %s", cpi_cause_desc[i]);
+      sprintf(buf2, "cpi_slots.%s / (%d * sim_num_insn)",
+	      cpi_cause_name[i], ruu_commit_width);
+      stat_reg_formula(sdb, buf, buf1, buf2, NULL);
+    }
   stat_reg_formula(sdb, "sim_exec_BW",
 		   "total instructions (mis-spec + committed) per cycle",
 		   "sim_total_insn / sim_cycle", /* format */NULL);
@@ -1286,6 +2171,31 @@ sim_reg_stats(struct stat_sdb_t *sdb)   /* stats database */
 		   "instruction per branch",
 		   "sim_num_insn / sim_num_branches", /* format */NULL);
 
+  /* fetch stats */
+  stat_reg_counter(sdb, "fetch_total_insn",
+		   "total number of instructions fetched",
+		   &fetch_total_insn, /* initial value */0, /* format */NULL);
+  stat_reg_counter(sdb, "fetch_blocks",
+		   "total number of I-cache fetch block reads",
+		   &fetch_blocks, /* initial value */0, /* format */NULL);
+  stat_reg_formula(sdb, "fetch_block_size",
+		   "avg instructions fetched per fetch block read",
+		   "fetch_total_insn / fetch_blocks", /* format */NULL);
+  stat_reg_counter(sdb, "fetch_bank_conflicts",
+		   "total number of I-cache bank conflicts at fetch",
+		   &fetch_bank_conflicts, /* initial value */0, /* format */NULL);
+  if (fetch_threads > 1)
+    fetch_threads_dist =
+      stat_reg_dist(sdb, "fetch_threads_dist",
+		    "eager threads fetched from per cycle",
+		    /* initial value */0,
+		    /* array size */fetch_threads + 1,
+		    /* bucket size */1,
+		    /* print format */(PF_COUNT|PF_PDF),
+		    /* format */NULL,
+		    /* index map */NULL,
+		    /* print fn */NULL);
+
   /* occupancy stats */
   stat_reg_counter(sdb, "IFQ_count", "cumulative IFQ occupancy",
                    &IFQ_count, /* initial value */0, /* format */NULL);
@@ -1326,6 +2236,85 @@ sim_reg_stats(struct stat_sdb_t *sdb)   /* stats database */
   stat_reg_formula(sdb, "lsq_full", "fraction of time (cycle's) LSQ was full",
                    "LSQ_fcount / sim_cycle", /* format */NULL);
 
+  stat_reg_counter(sdb, "window_thread_stalls",
+		   "dispatch stalls on a per-thread RUU/LSQ limit",
+		   &window_thread_stalls, /* initial value */0, /* format */NULL);
+  stat_reg_counter(sdb, "window_fetch_gated",
+		   "fetches refused to threads at their RUU/LSQ limit",
+		   &window_fetch_gated, /* initial value */0, /* format */NULL);
+  stat_reg_counter(sdb, "RUU_squash_reclaimed",
+		   "squashed RUU entries freed without draining to commit",
+		   &RUU_squash_reclaimed, /* initial value */0, /* format */NULL);
+  stat_reg_counter(sdb, "IFQ_squash_reclaimed",
+		   "squashed IFQ entries freed without reaching dispatch",
+		   &IFQ_squash_reclaimed, /* initial value */0, /* format */NULL);
+
+  /* memory dependence speculation stats */
+  if (memdep_policy != md_none)
+    {
+      stat_reg_counter(sdb, "lsq_spec_loads",
+		       "loads issued before all earlier store addresses",
+		       &lsq_spec_loads, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "lsq_mem_violations",
+		       "memory ordering violations (load re-executed)",
+		       &lsq_mem_violations, /* initial value */0,
+		       /* format */NULL);
+      stat_reg_formula(sdb, "lsq_violation_rate",
+		       "memory ordering violations per load",
+		       "lsq_mem_violations / sim_total_loads", /* format */NULL);
+    }
+  if (memdep_policy == md_storeset)
+    {
+      stat_reg_counter(sdb, "lsq_pred_deps",
+		       "loads made to wait by the store-set predictor",
+		       &lsq_pred_deps, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "lsq_false_deps",
+		       "predicted dependences on a store to another address",
+		       &lsq_false_deps, /* initial value */0, /* format */NULL);
+      stat_reg_formula(sdb, "lsq_false_dep_rate",
+		       "false predicted dependences per load",
+		       "lsq_false_deps / sim_total_loads", /* format */NULL);
+    }
+
+  /* control independence stats */
+  if (reconv_policy != rc_none)
+    {
+      stat_reg_counter(sdb, "ci_captures",
+		       "mis-predicted branches whose losing path was kept",
+		       &ci_captures, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "ci_wrong_path_insn",
+		       "losing-path instructions kept at those squashes",
+		       &ci_wrong_path_insn, /* initial value */0,
+		       /* format */NULL);
+      stat_reg_counter(sdb, "ci_reconv",
+		       "winning paths that reached the reconvergence point",
+		       &ci_reconv, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "ci_no_reconv",
+		       "winning paths that never reconverged",
+		       &ci_no_reconv, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "ci_diverged",
+		       "winning paths that left the kept path after reconverging",
+		       &ci_diverged, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "ci_reused_insn",
+		       "control-independent results reused from the losing path",
+		       &ci_reused_insn, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "ci_reexec_insn",
+		       "post-reconvergence instructions executed again",
+		       &ci_reexec_insn, /* initial value */0, /* format */NULL);
+      stat_reg_formula(sdb, "ci_reuse_rate",
+		       "fraction of kept losing-path instructions reused",
+		       "ci_reused_insn / ci_wrong_path_insn", /* format */NULL);
+    }
+  if (reconv_policy == rc_dynamic)
+    {
+      stat_reg_counter(sdb, "rct_hits",
+		       "reconvergence table hits",
+		       &rct_hits, /* initial value */0, /* format */NULL);
+      stat_reg_counter(sdb, "rct_misses",
+		       "reconvergence table misses",
+		       &rct_misses, /* initial value */0, /* format */NULL);
+    }
+
   stat_reg_counter(sdb, "sim_slip",
                    "total number of slip cycles",
                    &sim_slip, 0, NULL);
@@ -1390,6 +2379,8 @@ sim_reg_stats(struct stat_sdb_t *sdb)   /* stats database */
 					/* print fn */NULL);
     }
   ld_reg_stats(sdb);
+  if (cfg_enable)
+    cfg_reg_stats(sdb);
   mem_reg_stats(mem, sdb);
 }
 
@@ -1403,6 +2394,9 @@ static void cv_init(void);
 static void tracer_init(void);
 static void fetch_init(void);
 static void thread_states_init(void);
+static void ci_init(void);
+static void fst_init(void);
+static void ra_prefetch_used(md_addr_t addr, unsigned int lat);
 
 /* initialize the simulator */
 void
@@ -1453,6 +2447,32 @@ sim_load_prog(char *fname,		/* program to load */
   /* load program text and data, set up environment, memory, and regs */
   ld_load_prog(fname, argc, argv, envp, &regs, mem, TRUE);
 
+  /* fork hints must come from a profile of this program */
+  if (fork_hints_fname)
+    hint_check(mem, pred_type);
+
+  /* the fork report names branches by the function they are in */
+  if (fork_report_fname)
+    sym_loadsyms(ld_prog_fname, /* !locals */FALSE);
+
+  /* analyze the control flow of the loaded text */
+  if (cfg_enable)
+    {
+      char *cache_fname = NULL;
+
+      if (!mystricmp(cfg_cache_opt, "auto"))
+	{
+	  cache_fname = malloc(strlen(ld_prog_fname) + sizeof(".cfg"));
+	  if (!cache_fname)
+	    fatal("out of virtual memory");
+	  sprintf(cache_fname, "%s.cfg", ld_prog_fname);
+	}
+      else if (mystricmp(cfg_cache_opt, "none"))
+	cache_fname = cfg_cache_opt;
+
+      cfg_init(mem, cache_fname);
+    }
+
   /* initialize here, so symbols can be loaded */
   if (ptrace_nelt == 2)
     {
@@ -1477,16 +2497,185 @@ sim_load_prog(char *fname,		/* program to load */
   ruu_init();
   lsq_init();
   thread_states_init();
+  ci_init();
+  fst_init();
 
   /* initialize the DLite debugger */
   dlite_init(simoo_reg_obj, simoo_mem_obj, simoo_mstate_obj);
 }
 
+/* return the fork report entry of the forking branch at PC, creating it if
+   needed */
+static struct frep_ent *
+frep_branch(md_addr_t PC)
+{
+  struct frep_ent *e;
+
+  for (e = frep_table[FREP_HASH(PC)]; e; e = e->next)
+    if (e->addr == PC)
+      return e;
+
+  e = (struct frep_ent *)calloc(1, sizeof(struct frep_ent));
+  if (!e)
+    fatal("out of virtual memory");
+  e->addr = PC;
+  e->next = frep_table[FREP_HASH(PC)];
+  frep_table[FREP_HASH(PC)] = e;
+  frep_nbranches++;
+  return e;
+}
+
+/* order fork report entries by forks, most first, then by address */
+static int
+frep_cmp(const void *a, const void *b)
+{
+  const struct frep_ent *x = a, *y = b;
+
+  if (x->forks != y->forks)
+    return (x->forks > y->forks) ? -1 : 1;
+  if (x->addr != y->addr)
+    return (x->addr < y->addr) ? -1 : 1;
+  return 0;
+}
+
+/* collect the fork report, by branch (BY_FUNC == FALSE) or by function,
+   sorted with frep_cmp(), the number of entries is returned in *PNENT */
+static struct frep_ent *
+frep_collect(int by_func, int *pnent)
+{
+  struct frep_ent *ents, *e, *br;
+  int i, j, nent;
+
+  ents = (struct frep_ent *)calloc(frep_nbranches + 1,
+				   sizeof(struct frep_ent));
+  if (!ents)
+    fatal("out of virtual memory");
+
+  nent = 0;
+  for (i=0; i<FREP_HASH_SIZE; i++)
+    for (br = frep_table[i]; br != NULL; br = br->next)
+      {
+	md_addr_t PC = br->addr;
+	struct sym_sym_t *sym = sym_bind_addr(PC, NULL, /* !exact */FALSE,
+					      sdb_text);
+
+	if (by_func)
+	  {
+	    /* find this function's entry, linear but run once at exit */
+	    for (j=0; j<nent; j++)
+	      if (ents[j].sym == sym)
+		break;
+	    e = &ents[j];
+	    if (j == nent)
+	      {
+		e->addr = sym ? sym->addr : 0;
+		e->sym = sym;
+		nent++;
+	      }
+	  }
+	else
+	  {
+	    e = &ents[nent++];
+	    e->addr = PC;
+	    e->sym = sym;
+	  }
+	e->forks += br->forks;
+	e->won += br->won;
+	e->wrong += br->wrong;
+	e->saved += br->saved;
+      }
+
+  qsort(ents, nent, sizeof(struct frep_ent), frep_cmp);
+  *pnent = nent;
+  return ents;
+}
+
+/* format the name of fork report entry E into BUF, as a function name, or
+   as function+offset for a branch */
+static char *
+frep_name(struct frep_ent *e, int by_func, char *buf)
+{
+  if (!e->sym)
+    mysprintf(buf, by_func ? "<unknown>" : "0x%08p", e->addr);
+  else if (by_func || e->addr == e->sym->addr)
+    mysprintf(buf, "%s", e->sym->name);
+  else
+    mysprintf(buf, "%s+0x%x", e->sym->name, (int)(e->addr - e->sym->addr));
+  return buf;
+}
+
+/* print the top fork_report_top fork report entries, by branch or by
+   function, to STREAM */
+static void
+frep_print(FILE *stream, int by_func)
+{
+  struct frep_ent *ents;
+  int i, nent;
+  char buf[512];
+
+  ents = frep_collect(by_func, &nent);
+
+  fprintf(stream, "\nfork report: top %d of %d forking %s\n",
+	  MIN(fork_report_top, nent), nent, by_func ? "functions" : "branches");
+  fprintf(stream, "%-18s %-32s %10s %10s %7s %10s %10s\n",
+	  "address", by_func ? "function" : "branch", "forks", "won", "won%",
+	  "wrong/fork", "saved/won");
+  for (i=0; i<nent && i<fork_report_top; i++)
+    {
+      struct frep_ent *e = &ents[i];
+
+      myfprintf(stream, "0x%016p ", e->addr);
+      fprintf(stream, "%-32s ", frep_name(e, by_func, buf));
+      myfprintf(stream, "%10n %10n ", e->forks, e->won);
+      fprintf(stream, "%7.2f %10.2f %10.2f\n",
+	      100.0 * (double)e->won / (double)e->forks,
+	      (double)e->wrong / (double)e->forks,
+	      e->won ? (double)e->saved / (double)e->won : 0.0);
+    }
+  free(ents);
+}
+
+/* write the complete fork report, by branch and by function, to FNAME,
+   one whitespace-separated record per line */
+static void
+frep_write(char *fname)
+{
+  FILE *fd;
+  struct frep_ent *ents;
+  int by_func, i, nent;
+  char buf[512];
+
+  fd = fopen(fname, "w");
+  if (!fd)
+    fatal("cannot open fork report file `%s'", fname);
+
+  fprintf(fd, "# sim-outorder fork report for `%s'\n", ld_prog_fname);
+  fprintf(fd, "# kind address name forks won wrong_insn cycles_saved\n");
+  for (by_func=FALSE; by_func<=TRUE; by_func++)
+    {
+      ents = frep_collect(by_func, &nent);
+      for (i=0; i<nent; i++)
+	{
+	  struct frep_ent *e = &ents[i];
+
+	  myfprintf(fd, "%s 0x%08p ", by_func ? "func" : "branch", e->addr);
+	  fprintf(fd, "%s ", frep_name(e, by_func, buf));
+	  myfprintf(fd, "%n %n %n %n\n", e->forks, e->won, e->wrong, e->saved);
+	}
+      free(ents);
+    }
+  fclose(fd);
+}
+
 /* dump simulator-specific auxiliary simulator statistics */
 void
 sim_aux_stats(FILE *stream)             /* output stream */
 {
-  /* nada */
+  if (fork_report_fname && fork_report_top > 0)
+    {
+      frep_print(stream, /* !by_func */FALSE);
+      frep_print(stream, /* by_func */TRUE);
+    }
 }
 
 /* un-initialize the simulator */
@@ -1495,6 +2684,18 @@ sim_uninit(void)
 {
   if (ptrace_nelt > 0)
     ptrace_close();
+  if (fork_report_fname)
+    frep_write(fork_report_fname);
+  if (stat_interval)
+    {
+      /* the partial interval since the last row */
+      if ((interval_by_cycles ? sim_cycle : sim_num_insn)
+	  > interval_next - interval_size)
+	stat_interval_row(stat_interval);
+      stat_interval_delete(stat_interval);
+      if (interval_fd != stderr)
+	fclose(interval_fd);
+    }
 }
 
 
@@ -1542,6 +2743,7 @@ struct RUU_station {
   struct bpred_update_t dir_update;	/* bpred direction update info */
   int spec_mode;			/* non-zero if issued in spec_mode */
   md_addr_t addr;			/* effective address for ld/st's */
+  unsigned int mem_lat;			/* load access latency, at issue */
   INST_TAG_TYPE tag;			/* RUU slot tag, increment to
 					   squash operation */
   INST_SEQ_TYPE seq;			/* instruction sequence, used to
@@ -1571,6 +2773,19 @@ struct RUU_station {
   int fork_counter; /* counter of number of forks this thread has spun off */
   int triggers_fork; /* does this instruction trigger a fork? */
   int fork_id; /* what is the id of the forked thread? */
+
+  /* memory dependence speculation (loads only) */
+  struct RUU_station *ssdep;		/* store predicted to feed this load */
+  INST_SEQ_TYPE ssdep_seq;		/* seq of that store, if still valid */
+  struct RUU_station *viol_st;		/* unresolved store this load passed */
+  INST_SEQ_TYPE viol_seq;		/* seq of that store, if still valid */
+  int ldwait;				/* on the waiting load list? */
+  struct RUU_station *ldwait_prev;	/* ... its neighbours there */
+  struct RUU_station *ldwait_next;
+
+  /* architected results of a non-speculative instruction, for the commit
+     digest and lockstep checking */
+  struct lockstep_rec_t cmt;
 };
 
 /* non-zero if all register operands are ready, update with MAX_IDEPS */
@@ -1603,6 +2818,9 @@ thread_states_init(void) {
   if (!thread_states)
     fatal("out of virtual memory");
   for (int i=0; i < max_threads; i++) {
+    thread_states[i].parent_fork_counters = calloc(max_threads, sizeof(int));
+    if (!thread_states[i].parent_fork_counters)
+      fatal("out of virtual memory");
     thread_states[i].in_use = FALSE;
     thread_states[i].spec_mode = FALSE;
     thread_states[i].spec_level = -1;
@@ -1615,6 +2833,16 @@ thread_states_init(void) {
   thread_states[0].in_use = TRUE;
 }
 
+/* release THREAD, recording how long it lived for the eager stats */
+static void
+thread_release(int thread)
+{
+  if (thread_states[thread].in_use && thread_life_dist)
+    stat_add_sample(thread_life_dist,
+		    (int)(sim_cycle - thread_states[thread].start_cycle));
+  thread_states[thread].in_use = FALSE;
+}
+
 /* dump the contents of the RUU */
 static void
 ruu_dumpent(struct RUU_station *rs,		/* ptr to RUU station */
@@ -1706,6 +2934,9 @@ ruu_dump(FILE *stream)				/* output stream */
  */
 static struct RUU_station *LSQ;         /* load/store queue */
 static int LSQ_head, LSQ_tail;          /* LSQ head and tail pointers */
+static counter_t LSQ_allocs;		/* LSQ entries allocated, less those
+					   reclaimed at squash; LSQ_tail is
+					   this modulo LSQ_size */
 static int LSQ_num;                     /* num entries currently in LSQ */
 
 /*
@@ -1719,35 +2950,417 @@ static int LSQ_num;                     /* num entries currently in LSQ */
 #define STORE_OP_READY(RS)              ((RS)->idep_ready[STORE_OP_INDEX])
 #define STORE_ADDR_READY(RS)            ((RS)->idep_ready[STORE_ADDR_INDEX])
 
-/* allocate and initialize the load/store queue (LSQ) */
+/*
+ * store address table: every store in the LSQ, hashed by its (functionally
+ * known) address; lsq_refresh() consults it to find the store a load would
+ * forward from, instead of rebuilding per-thread unknown-STD lists each cycle
+ */
+
+/* store address table entry */
+struct sta_ent {
+  struct sta_ent *next;			/* next entry in the bucket */
+  struct RUU_station *rs;		/* LSQ station of the store */
+};
+
+#define STA_HASH_ADDR(ADDR)						\
+  ((((ADDR) >> 12) ^ ((ADDR) >> 3)) & (sta_nbuckets - 1))
+
+static struct sta_ent **sta_table;	/* hash buckets */
+static int sta_nbuckets;		/* number of buckets, a power of two */
+static struct sta_ent *sta_free_list;	/* free entries, one per LSQ slot */
+
+/* allocate the store address table, it never holds more than LSQ_size
+   entries so it is sized once and never overflows */
 static void
-lsq_init(void)
+sta_init(void)
 {
-  LSQ = calloc(LSQ_size, sizeof(struct RUU_station));
-  if (!LSQ)
+  int i;
+  struct sta_ent *ents;
+
+  sta_nbuckets = 2 * LSQ_size;
+  sta_table = calloc(sta_nbuckets, sizeof(struct sta_ent *));
+  ents = calloc(LSQ_size, sizeof(struct sta_ent));
+  if (!sta_table || !ents)
     fatal("out of virtual memory");
 
-  LSQ_num = 0;
-  LSQ_head = LSQ_tail = 0;
-  LSQ_count = 0;
-  LSQ_fcount = 0;
+  sta_free_list = NULL;
+  for (i=0; i < LSQ_size; i++)
+    {
+      ents[i].next = sta_free_list;
+      sta_free_list = &ents[i];
+    }
 }
 
-/* dump the contents of the RUU */
+/* enter the store at LSQ station RS, called at dispatch */
 static void
-lsq_dump(FILE *stream)				/* output stream */
+sta_insert(struct RUU_station *rs)
 {
-  int num, head;
-  struct RUU_station *rs;
+  struct sta_ent *ent;
+  int bucket = STA_HASH_ADDR(rs->addr);
 
-  if (!stream)
-    stream = stderr;
+  if (!sta_free_list)
+    panic("store address table out of sync with the LSQ");
+  ent = sta_free_list;
+  sta_free_list = ent->next;
 
-  fprintf(stream, "** LSQ state **\n");
-  fprintf(stream, "LSQ_head: %d, LSQ_tail: %d\n", LSQ_head, LSQ_tail);
-  fprintf(stream, "LSQ_num: %d\n", LSQ_num);
+  ent->rs = rs;
+  ent->next = sta_table[bucket];
+  sta_table[bucket] = ent;
+}
 
-  num = LSQ_num;
+/* remove the store at LSQ station RS, called when it commits or is squashed */
+static void
+sta_remove(struct RUU_station *rs)
+{
+  struct sta_ent *ent, **prev;
+
+  for (prev = &sta_table[STA_HASH_ADDR(rs->addr)]; (ent = *prev); prev = &ent->next)
+    {
+      if (ent->rs == rs)
+	{
+	  *prev = ent->next;
+	  ent->next = sta_free_list;
+	  sta_free_list = ent;
+	  return;
+	}
+    }
+  panic("store not in store address table");
+}
+
+/* non-zero if the store at RS is on the execution path of THREAD, that is,
+   it belongs to THREAD or to an ancestor before THREAD was forked off */
+static int
+sta_visible(struct RUU_station *rs, int thread)
+{
+  return (max_threads == 1
+	  || rs->thread_id == thread
+	  || thread_states[thread].parent_fork_counters[rs->thread_id]
+	     >= rs->fork_counter);
+}
+
+/* non-zero if load LD must wait for store data: the youngest earlier store
+   on its path to the same address has a known address but unknown data */
+static int
+sta_load_blocked(struct RUU_station *ld)
+{
+  struct sta_ent *ent;
+  struct RUU_station *st = NULL;
+
+  for (ent = sta_table[STA_HASH_ADDR(ld->addr)]; ent; ent = ent->next)
+    {
+      if (ent->rs->addr == ld->addr
+	  && ent->rs->seq < ld->seq
+	  && (!st || ent->rs->seq > st->seq)
+	  && STORE_ADDR_READY(ent->rs)
+	  && sta_visible(ent->rs, ld->thread_id))
+	st = ent->rs;
+    }
+  return (st && !OPERANDS_READY(st));
+}
+
+/* youngest earlier store on the path of load LD that writes the load's
+   address, whether or not its address has been computed yet; this is the
+   store the load must get its value from */
+static struct RUU_station *
+sta_producer(struct RUU_station *ld)
+{
+  struct sta_ent *ent;
+  struct RUU_station *st = NULL;
+
+  for (ent = sta_table[STA_HASH_ADDR(ld->addr)]; ent; ent = ent->next)
+    {
+      if (ent->rs->addr == ld->addr
+	  && ent->rs->seq < ld->seq
+	  && (!st || ent->rs->seq > st->seq)
+	  && sta_visible(ent->rs, ld->thread_id))
+	st = ent->rs;
+    }
+  return st;
+}
+
+/* oldest live store of THREAD whose address is not computed yet, or NULL;
+   a store's address only ever becomes known and squashed entries stay
+   squashed, so the per-thread cursor only moves forward (it is pulled back
+   only when squashed entries are reclaimed at the LSQ tail) */
+static struct RUU_station *
+sta_unknown_oldest(int thread)
+{
+  struct thread_state *ts = &thread_states[thread];
+  struct RUU_station *st;
+
+  if (ts->sta_unknown < LSQ_allocs - LSQ_num)
+    ts->sta_unknown = LSQ_allocs - LSQ_num;
+  for (; ts->sta_unknown < LSQ_allocs; ts->sta_unknown++)
+    {
+      st = &LSQ[ts->sta_unknown % LSQ_size];
+      if (st->thread_id == thread
+	  && !st->squashed
+	  && (MD_OP_FLAGS(st->op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE)
+	  && !STORE_ADDR_READY(st))
+	return st;
+    }
+  return NULL;
+}
+
+/* non-zero if an earlier store on the path of load LD has not computed its
+   address yet; a thread's later stores carry later fork counters, so only
+   the oldest unresolved store of each thread needs checking */
+static int
+sta_unknown_before(struct RUU_station *ld)
+{
+  int t;
+  struct RUU_station *st;
+
+  for (t=0; t < max_threads; t++)
+    {
+      st = sta_unknown_oldest(t);
+      if (st && st->seq < ld->seq && sta_visible(st, ld->thread_id))
+	return TRUE;
+    }
+  return FALSE;
+}
+
+/*
+ * store-set memory dependence predictor (Chrysos and Emer): the SSIT maps
+ * load and store PCs to a store set, the LFST holds the last dispatched store
+ * of each set, a load waits for the LFST store of its set and a store waits
+ * for the one before it, so the stores of a set execute in order
+ */
+
+#define SSID_INVALID		(-1)
+#define SSIT_INDEX(PC)		(((PC) >> MD_BR_SHIFT) & (ssit_size - 1))
+
+/* cycles between clearings of the SSIT, bounds false dependences */
+#define SSIT_CLEAR_INTERVAL	1000000
+
+static int *ssit;			/* store set identifier table */
+static struct {
+  struct RUU_station *rs;		/* last dispatched store of the set */
+  INST_SEQ_TYPE seq;			/* its seq, stale if the slot moved on */
+} *lfst;				/* last fetched store table */
+
+/* allocate the store-set predictor tables */
+static void
+storeset_init(void)
+{
+  int i;
+
+  ssit = calloc(ssit_size, sizeof(int));
+  lfst = calloc(lfst_size, sizeof(*lfst));
+  if (!ssit || !lfst)
+    fatal("out of virtual memory");
+  for (i=0; i < ssit_size; i++)
+    ssit[i] = SSID_INVALID;
+}
+
+/* make load or store RS, at dispatch, wait for the last dispatched store of
+   its set (if still in flight on its path), a store then takes its place */
+static void
+storeset_dispatch(struct RUU_station *rs)
+{
+  struct RUU_station *dep;
+  int ssid;
+
+  ssid = ssit[SSIT_INDEX(rs->PC)];
+  if (ssid == SSID_INVALID)
+    return;
+
+  dep = lfst[ssid].rs;
+  if (dep && dep->seq == lfst[ssid].seq && !dep->squashed && !dep->completed
+      && sta_visible(dep, rs->thread_id))
+    {
+      rs->ssdep = dep;
+      rs->ssdep_seq = dep->seq;
+      if ((MD_OP_FLAGS(rs->op) & (F_MEM|F_LOAD)) == (F_MEM|F_LOAD))
+	{
+	  lsq_pred_deps++;
+	  if (dep->addr != rs->addr)
+	    lsq_false_deps++;
+	}
+    }
+
+  if ((MD_OP_FLAGS(rs->op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+    {
+      lfst[ssid].rs = rs;
+      lfst[ssid].seq = rs->seq;
+    }
+}
+
+/* non-zero if RS still waits for the store its store set made it depend on */
+static int
+storeset_waiting(struct RUU_station *rs)
+{
+  if (rs->ssdep)
+    {
+      if (rs->ssdep->seq == rs->ssdep_seq
+	  && !rs->ssdep->squashed && !rs->ssdep->completed)
+	return TRUE;
+      rs->ssdep = NULL;
+    }
+  return FALSE;
+}
+
+/* train the predictor on a violation between load LD and store ST */
+static void
+storeset_violation(struct RUU_station *ld, struct RUU_station *st)
+{
+  int *ld_ssid = &ssit[SSIT_INDEX(ld->PC)];
+  int *st_ssid = &ssit[SSIT_INDEX(st->PC)];
+
+  if (*ld_ssid == SSID_INVALID && *st_ssid == SSID_INVALID)
+    *ld_ssid = *st_ssid = SSIT_INDEX(st->PC) & (lfst_size - 1);
+  else if (*ld_ssid == SSID_INVALID)
+    *ld_ssid = *st_ssid;
+  else if (*st_ssid == SSID_INVALID)
+    *st_ssid = *ld_ssid;
+  else if (*ld_ssid != *st_ssid)
+    {
+      /* merge the two sets, the smaller identifier wins */
+      *ld_ssid = *st_ssid = MIN(*ld_ssid, *st_ssid);
+    }
+}
+
+/* allocate and initialize the load/store queue (LSQ) */
+static void
+lsq_init(void)
+{
+  LSQ = calloc(LSQ_size, sizeof(struct RUU_station));
+  if (!LSQ)
+    fatal("out of virtual memory");
+
+  LSQ_num = 0;
+  LSQ_head = LSQ_tail = 0;
+  LSQ_allocs = 0;
+  LSQ_count = 0;
+  LSQ_fcount = 0;
+
+  sta_init();
+  if (memdep_policy == md_storeset)
+    storeset_init();
+}
+
+/* loads in the LSQ whose address is known but that have not issued yet, or
+   that issued past a store of unknown address, in program order; these are
+   the only loads lsq_refresh() needs to look at */
+static struct RUU_station *ldwait_head = NULL, *ldwait_tail = NULL;
+
+/* put load LD on the waiting load list, new loads are usually the youngest
+   so the insertion point is searched for from the tail */
+static void
+ldwait_insert(struct RUU_station *ld)
+{
+  struct RUU_station *prev;
+
+  if (ld->ldwait)
+    return;
+
+  for (prev = ldwait_tail; prev && prev->seq > ld->seq; prev = prev->ldwait_prev)
+    /* nada */;
+
+  ld->ldwait_prev = prev;
+  ld->ldwait_next = prev ? prev->ldwait_next : ldwait_head;
+  if (ld->ldwait_next)
+    ld->ldwait_next->ldwait_prev = ld;
+  else
+    ldwait_tail = ld;
+  if (prev)
+    prev->ldwait_next = ld;
+  else
+    ldwait_head = ld;
+  ld->ldwait = TRUE;
+}
+
+/* take load LD off the waiting load list, if it is on it */
+static void
+ldwait_remove(struct RUU_station *ld)
+{
+  if (!ld->ldwait)
+    return;
+
+  if (ld->ldwait_prev)
+    ld->ldwait_prev->ldwait_next = ld->ldwait_next;
+  else
+    ldwait_head = ld->ldwait_next;
+  if (ld->ldwait_next)
+    ld->ldwait_next->ldwait_prev = ld->ldwait_prev;
+  else
+    ldwait_tail = ld->ldwait_prev;
+  ld->ldwait = FALSE;
+}
+
+/* number of RUU or LSQ entries (out of SIZE) that THREAD may hold under the
+   current sharing policy, CAP is the user's per-thread limit (0 if none) */
+static int
+window_thread_limit(int thread, int size, int cap)
+{
+  int t, n_active, limit = size;
+
+  switch (window_share)
+    {
+    case ws_shared:
+      break;
+    case ws_static:
+      limit = MAX(size / max_threads, 1);
+      break;
+    case ws_dcra:
+      /* the correct path borrows whatever speculative threads leave */
+      if (!thread_states[thread].spec_mode)
+	break;
+      for (t=0, n_active=0; t < max_threads; t++)
+	if (thread_states[t].in_use)
+	  n_active++;
+      limit = MAX(size / MAX(n_active, 1), 1);
+      break;
+    default:
+      panic("bogus RUU sharing policy");
+    }
+
+  if (cap && cap < limit)
+    limit = cap;
+  return limit;
+}
+
+/* non-zero if THREAD holds all the RUU entries (or, if NEED_LSQ, all the LSQ
+   entries) it is allowed under the sharing policy; a thread never counts as
+   full merely because the shared queue is full */
+static int
+window_thread_full(int thread, int need_lsq)
+{
+  int limit;
+
+  /* a lone thread is limited only by an explicit cap */
+  if (max_threads == 1 && !RUU_thread_max && !LSQ_thread_max)
+    return FALSE;
+
+  limit = window_thread_limit(thread, RUU_size, RUU_thread_max);
+  if (limit < RUU_size && thread_states[thread].RUU_num >= limit)
+    return TRUE;
+
+  if (need_lsq)
+    {
+      limit = window_thread_limit(thread, LSQ_size, LSQ_thread_max);
+      if (limit < LSQ_size && thread_states[thread].LSQ_num >= limit)
+	return TRUE;
+    }
+  return FALSE;
+}
+
+
+/* dump the contents of the RUU */
+static void
+lsq_dump(FILE *stream)				/* output stream */
+{
+  int num, head;
+  struct RUU_station *rs;
+
+  if (!stream)
+    stream = stderr;
+
+  fprintf(stream, "** LSQ state **\n");
+  fprintf(stream, "LSQ_head: %d, LSQ_tail: %d\n", LSQ_head, LSQ_tail);
+  fprintf(stream, "LSQ_num: %d\n", LSQ_num);
+
+  num = LSQ_num;
   head = LSQ_head;
   while (num)
     {
@@ -2118,15 +3731,17 @@ static struct CV_link CVLINK_NULL = { NULL, 0 };
 
 /* the create vector, NOTE: speculative copy on write storage provided
    for fast recovery during wrong path execute (see tracer_recover() for
-   details on this process */
+   details on this process; the speculative copies are indexed by thread
+   and mis-speculation level, levels are allocated by spec_levels_reserve()
+   as a thread first reaches them */
 static BITMAP_TYPE(MD_TOTAL_REGS, use_spec_cv);
 static struct CV_link create_vector[MD_TOTAL_REGS];
-static struct CV_link spec_create_vector[MAX_THREADS][MAX_SPEC_LEVELS][MD_TOTAL_REGS];
+static struct CV_link (**spec_create_vector)[MD_TOTAL_REGS];
 
 /* these arrays shadow the create vector an indicate when a register was
    last created */
 static tick_t create_vector_rt[MD_TOTAL_REGS];
-static tick_t spec_create_vector_rt[MAX_THREADS][MAX_SPEC_LEVELS][MD_TOTAL_REGS];
+static tick_t (**spec_create_vector_rt)[MD_TOTAL_REGS];
 
 /* read a create vector entry */
 #define CREATE_VECTOR(THREAD, N)        (spec_mode\
@@ -2149,8 +3764,6 @@ static void
 cv_init(void)
 {
   int i;
-  int j;
-  int k;
 
   /* initially all registers are valid in the architected register file,
      i.e., the create vector entry is CVLINK_NULL */
@@ -2159,14 +3772,11 @@ cv_init(void)
     create_vector_rt[i] = 0;
   }
 
-  for (i=0; i < MAX_THREADS; i++) {
-    for (j=0; j < MAX_SPEC_LEVELS; j++) {
-      for (k=0; k < MD_TOTAL_REGS; k++) {
-        spec_create_vector[i][j][k] = CVLINK_NULL;
-        spec_create_vector_rt[i][j][k] = 0;
-      }
-    }
-  }
+  /* no thread has any mis-speculation levels yet */
+  spec_create_vector = calloc(max_threads, sizeof(*spec_create_vector));
+  spec_create_vector_rt = calloc(max_threads, sizeof(*spec_create_vector_rt));
+  if (!spec_create_vector || !spec_create_vector_rt)
+    fatal("out of virtual memory");
 
   /* all create vector entries are non-speculative */
   BITMAP_CLEAR_MAP(use_spec_cv, CV_BMAP_SZ);
@@ -2226,13 +3836,99 @@ verify_ruu_entries_squashed(int branch_index, int thread_id, int fork_counter)
  *  RUU_COMMIT() - instruction retirement pipeline stage
  */
 
+/* non-zero if wrong-path entry RS is eager execution work: its thread was
+   forked, or had forked before RS was dispatched; other wrong-path entries
+   follow an ordinary mispredict */
+static int
+cpi_fork_path(struct RUU_station *rs)
+{
+  int t;
+
+  if (max_threads == 1)
+    return FALSE;
+  if (rs->fork_counter > 0)
+    return TRUE;
+  for (t=0; t < max_threads; t++)
+    if (thread_states[rs->thread_id].parent_fork_counters[t] != -1)
+      return TRUE;
+  return FALSE;
+}
+
+/* charge this cycle's commit slots to the CPI stack, COMMITTED slots retired
+   instructions and the rest go to the cause holding the RUU head, PORT_STALL
+   is set if commit stopped at a store that got no store port */
+static void
+cpi_account(int committed, int port_stall)
+{
+  struct RUU_station *rs, *ls;
+  enum cpi_cause_t cause;
+
+  cpi_slots[cc_useful] += committed;
+  if (committed == ruu_commit_width)
+    return;
+
+  rs = &RUU[RUU_head];
+  ls = &LSQ[LSQ_head];
+  if (RUU_num == 0)
+    cause = cpi_fe_cause;
+  else if (rs->spec_mode)
+    cause = cpi_fork_path(rs) ? cc_fork : cc_bpred;
+  else if (port_stall
+	   || (!rs->completed && rs->queued && !rs->issued)
+	   || (rs->completed && rs->ea_comp && ls->queued && !ls->issued))
+    cause = cc_fu;
+  else if (rs->completed && rs->ea_comp && ls->issued
+	   && (MD_OP_FLAGS(ls->op) & F_LOAD) && ls->mem_lat > cache_dl1_lat)
+    cause = cc_dcache;
+  else if (RUU_num == RUU_size || LSQ_num == LSQ_size)
+    {
+      int i, index, squashed = 0, wrong_path = 0, fork_path = 0;
+
+      /* a full window, charge whatever holds it */
+      for (i=0, index=RUU_head; i<RUU_num; i++, index=(index+1) % RUU_size)
+	{
+	  if (RUU[index].squashed)
+	    squashed++;
+	  else if (RUU[index].spec_mode)
+	    {
+	      wrong_path++;
+	      if (cpi_fork_path(&RUU[index]))
+		fork_path++;
+	    }
+	}
+      if (squashed)
+	cause = cc_squash;
+      else if (fork_path)
+	cause = cc_fork;
+      else if (wrong_path)
+	cause = cc_bpred;
+      else if (RUU_num == RUU_size)
+	cause = cc_ruu_full;
+      else
+	cause = cc_lsq_full;
+    }
+  else
+    cause = cc_exec;
+
+  cpi_slots[cause] += ruu_commit_width - committed;
+}
+
+/* a front-end event of kind CAUSE on the correct path, the RUU refills from
+   the instructions fetched after it */
+static void
+cpi_fe_event(enum cpi_cause_t cause)
+{
+  cpi_fe_cause = cause;
+  cpi_fe_seq = ptrace_seq;
+}
+
 /* this function commits the results of the oldest completed entries from the
    RUU and LSQ to the architected reg file, stores in the LSQ will commit
    their store data to the data cache at this point as well */
 static void
 ruu_commit(void)
 {
-  int i, lat, events, committed = 0;
+  int i, lat, events, committed = 0, port_stall = FALSE;
   static counter_t sim_ret_insn = 0;
 
   /* all values must be retired to the architected reg file in program order */
@@ -2247,22 +3943,17 @@ ruu_commit(void)
               }
               LSQ[LSQ_head].tag++;
                   sim_slip += (sim_cycle - LSQ[LSQ_head].slip);
-         	  /* indicate to pipeline trace that this instruction retired */
-        	  ptrace_newstage(LSQ[LSQ_head].ptrace_seq, PST_COMMIT, events);
-        	  ptrace_endinst(LSQ[LSQ_head].ptrace_seq);
          	  /* commit head of LSQ as well */
         	  LSQ_head = (LSQ_head + 1) % LSQ_size;
         	  LSQ_num--;
           }
           RUU[RUU_head].tag++;
           sim_slip += (sim_cycle - RUU[RUU_head].slip);
-          ptrace_newstage(RUU[RUU_head].ptrace_seq, PST_COMMIT, events);
-          ptrace_endinst(RUU[RUU_head].ptrace_seq);
-           /* commit head entry of RUU */
+           /* release head entry of RUU, squashed entries were already
+              discounted from their thread, ended in the pipetrace when
+              squashed, and use no commit bandwidth */
           RUU_head = (RUU_head + 1) % RUU_size;
           RUU_num--;
-           /* one more instruction committed to architected state */
-          committed++;
           continue;
       }
 
@@ -2285,7 +3976,7 @@ ruu_commit(void)
       // The forked thread off this is the correct one, so this can retire now
       if (rs->triggers_fork && (rs->pred_PC != rs->next_PC)) {
         //fprintf(stderr, "Finished cleaning up thread (%d) after mispred fork\n", rs->thread_id);
-        thread_states[rs->thread_id].in_use = FALSE;
+        thread_release(rs->thread_id);
         for (int n=0; n<max_threads; n++) {
           thread_states[n].parent_fork_counters[rs->thread_id] = -1;
         }
@@ -2352,6 +4043,7 @@ ruu_commit(void)
 	      else
 		{
 		  /* no store ports left, cannot continue to commit insts */
+		  port_stall = TRUE;
 		  break;
 		}
 	    }
@@ -2362,9 +4054,15 @@ ruu_commit(void)
 
 	  /* indicate to pipeline trace that this instruction retired */
 	  ptrace_newstage(LSQ[LSQ_head].ptrace_seq, PST_COMMIT, events);
-	  ptrace_endinst(LSQ[LSQ_head].ptrace_seq);
+	  ptrace_endinst(LSQ[LSQ_head].ptrace_seq, PEND_RETIRE);
 
 	  /* commit head of LSQ as well */
+	  if ((MD_OP_FLAGS(LSQ[LSQ_head].op) & (F_MEM|F_STORE))
+	      == (F_MEM|F_STORE))
+	    sta_remove(&LSQ[LSQ_head]);
+	  else
+	    ldwait_remove(&LSQ[LSQ_head]);
+	  thread_states[LSQ[LSQ_head].thread_id].LSQ_num--;
 	  LSQ_head = (LSQ_head + 1) % LSQ_size;
 	  LSQ_num--;
 	}
@@ -2385,6 +4083,11 @@ ruu_commit(void)
                        /* dir predictor update pointer */&rs->dir_update);
 	}
 
+      /* fold the instruction into the commit digest, and check it */
+      commit_digest = lockstep_digest(commit_digest, &rs->cmt);
+      if (lockstep_mode)
+	lockstep_check(&rs->cmt, sim_cycle);
+
       /* invalidate RUU operation instance */
       RUU[RUU_head].tag++;
       sim_slip += (sim_cycle - RUU[RUU_head].slip);
@@ -2402,9 +4105,11 @@ ruu_commit(void)
 
       /* indicate to pipeline trace that this instruction retired */
       ptrace_newstage(RUU[RUU_head].ptrace_seq, PST_COMMIT, events);
-      ptrace_endinst(RUU[RUU_head].ptrace_seq);
+      ptrace_endinst(RUU[RUU_head].ptrace_seq, PEND_RETIRE);
 
       /* commit head entry of RUU */
+      thread_states[THREAD_ID(RUU[RUU_head].thread_id)].num_insn++;
+      thread_states[THREAD_ID(RUU[RUU_head].thread_id)].RUU_num--;
       RUU_head = (RUU_head + 1) % RUU_size;
       RUU_num--;
 
@@ -2417,6 +4122,8 @@ ruu_commit(void)
 	    panic ("retired instruction has odeps\n");
         }
     }
+
+  cpi_account(committed, port_stall);
 }
 
 
@@ -2424,14 +4131,61 @@ ruu_commit(void)
  *  RUU_RECOVER() - squash mispredicted microarchitecture state
  */
 
+/* fork success table, 2-bit saturating counters indexed by branch address,
+   forking is allowed at counter values of 2 and up */
+static unsigned char *fst = NULL;
+#define FST_INDEX(PC)		(((PC) >> MD_BR_SHIFT) & (fst_size - 1))
+
+/* allocate the FST, initially allowing a fork at every branch */
+static void
+fst_init(void)
+{
+  if (!fork_throttle)
+    return;
+
+  fst = malloc(fst_size);
+  if (!fst)
+    fatal("out of virtual memory");
+  memset(fst, 2, fst_size);
+}
+
+/* train the FST at PC towards forking if a fork there was (or would have
+   been) USEFUL, away from it otherwise */
+static void
+fst_update(md_addr_t PC, int useful)
+{
+  unsigned char *ctr;
+
+  if (!fst)
+    return;
+
+  ctr = &fst[FST_INDEX(PC)];
+  if (useful && *ctr < 3)
+    ++*ctr;
+  else if (!useful && *ctr > 0)
+    --*ctr;
+}
+
+/* instructions squashed by the last ruu_recover(), and how many of those
+   had already issued */
+static int recover_squashed;
+static int recover_squashed_issued;
+
+/* IFQ entries squashed by the last squash_fetchq_invalids() */
+static int fetchq_squashed;
+
 /* recover processor microarchitecture state back to point of the
-   mis-predicted branch at RUU[BRANCH_INDEX] */
+   mis-predicted branch at RUU[BRANCH_INDEX], REASON (PEND_*) is why the
+   squashed instructions ended, for the pipetrace */
  static void
- ruu_recover(int branch_index, int thread_id, int fork_counter)			/* index of mis-pred branch */
+ ruu_recover(int branch_index, int thread_id, int fork_counter,			/* index of mis-pred branch */
+	     int reason)
  {
    int i, RUU_index = RUU_tail, LSQ_index = LSQ_tail;
    int RUU_prev_tail = RUU_tail, LSQ_prev_tail = LSQ_tail;
 
+   recover_squashed = recover_squashed_issued = 0;
+
    /* recover from the tail of the RUU towards the head until the branch index
       is reached, this direction ensures that the LSQ can be synchronized with
       the RUU */
@@ -2443,8 +4197,8 @@ ruu_commit(void)
    /* traverse to older insts until the mispredicted branch is encountered */
    while (RUU_index != branch_index)
      {
-       /* If this instruction does not need to be squashed */
-       if (thread_states[RUU[RUU_index].thread_id].parent_fork_counters[thread_id] < fork_counter && RUU[RUU_index].thread_id != thread_id) {
+       /* If this instruction does not need to be squashed (or already is) */
+       if (RUU[RUU_index].squashed || (thread_states[RUU[RUU_index].thread_id].parent_fork_counters[thread_id] < fork_counter && RUU[RUU_index].thread_id != thread_id)) {
          if (RUU[RUU_index].ea_comp) {
            /* go to next earlier LSQ slot */
         	  LSQ_index = (LSQ_index + (LSQ_size-1)) % LSQ_size;
@@ -2489,9 +4243,14 @@ ruu_commit(void)
  	  /* squash this LSQ entry */
  	  LSQ[LSQ_index].tag++;
      LSQ[LSQ_index].squashed = TRUE;
+     thread_states[LSQ[LSQ_index].thread_id].LSQ_num--;
+     if ((MD_OP_FLAGS(LSQ[LSQ_index].op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+       sta_remove(&LSQ[LSQ_index]);
+     else
+       ldwait_remove(&LSQ[LSQ_index]);
 
  	  /* indicate in pipetrace that this instruction was squashed */
- 	  ptrace_endinst(LSQ[LSQ_index].ptrace_seq);
+ 	  ptrace_endinst(LSQ[LSQ_index].ptrace_seq, reason);
 
  	  /* go to next earlier LSQ slot */
  	  LSQ_index = (LSQ_index + (LSQ_size-1)) % LSQ_size;
@@ -2508,18 +4267,55 @@ ruu_commit(void)
        /* squash this RUU entry */
        RUU[RUU_index].tag++;
        RUU[RUU_index].squashed = TRUE;
+       recover_squashed++;
+       if (RUU[RUU_index].issued)
+         recover_squashed_issued++;
+       if (RUU[RUU_index].triggers_fork && fst)
+         {
+           fork_fst_wasted++;
+           fst_update(RUU[RUU_index].PC, /* !useful */FALSE);
+         }
+       thread_states[RUU[RUU_index].thread_id].RUU_num--;
 
        /* indicate in pipetrace that this instruction was squashed */
-       ptrace_endinst(RUU[RUU_index].ptrace_seq);
+       ptrace_endinst(RUU[RUU_index].ptrace_seq, reason);
 
        /* go to next earlier slot in the RUU */
        RUU_index = (RUU_index + (RUU_size-1)) % RUU_size;
      }
 
+   /* free the squashed entries at the tail of the RUU and LSQ right away,
+      squashed entries behind live ones of other threads wait for the head */
+   while (RUU_num > 0)
+     {
+       RUU_index = (RUU_tail + (RUU_size-1)) % RUU_size;
+       if (!RUU[RUU_index].squashed)
+	 break;
+
+       if (RUU[RUU_index].ea_comp)
+	 {
+	   LSQ_index = (LSQ_tail + (LSQ_size-1)) % LSQ_size;
+	   if (!LSQ_num || !LSQ[LSQ_index].squashed)
+	     panic("ruu and lsq squashing out of sync");
+	   LSQ_tail = LSQ_index;
+	   LSQ_num--;
+	   LSQ_allocs--;
+	 }
+       RUU_tail = RUU_index;
+       RUU_num--;
+       RUU_squash_reclaimed++;
+     }
+
+   /* the reclaimed LSQ slots will be reused, pull back the unknown store
+      address cursors that passed them */
+   for (i=0; i < max_threads; i++)
+     if (thread_states[i].sta_unknown > LSQ_allocs)
+       thread_states[i].sta_unknown = LSQ_allocs;
  }
 
 
- static void squash_fetchq_invalids(int thread_id, int fork_counter);
+ static void squash_fetchq_invalids(int thread_id, int fork_counter,
+				    int reason);
 
 
 
@@ -2529,6 +4325,7 @@ ruu_commit(void)
 
 /* forward declarations */
 static void tracer_recover(struct RUU_station *rs_branch);
+static void ci_capture(int branch_index, int winner);
 
 /* writeback completed operation results from the functional units to RUU,
    at this point, the output dependency chains of completing instructions
@@ -2558,9 +4355,47 @@ ruu_writeback(void)
       if (rs->triggers_fork) {
         if (rs->in_LSQ) panic("load or store should not be triggering fork");
         if (rs->pred_PC != rs->next_PC) {
-          ruu_recover(rs - RUU, rs->thread_id, rs->fork_counter);
-          squash_fetchq_invalids(rs->thread_id, rs->fork_counter);
+          ci_capture(rs - RUU, rs->fork_id);
+          ruu_recover(rs - RUU, rs->thread_id, rs->fork_counter,
+		      PEND_FORKLOSS);
+          squash_fetchq_invalids(rs->thread_id, rs->fork_counter,
+				 PEND_FORKLOSS);
+          if (!rs->spec_mode)
+            cpi_fe_event(cc_fork);
           thread_states[rs->thread_id].keep_fetching = FALSE;
+
+          /* the parent's path lost: account for the work it wasted and
+             for the head start the winning path got over a redirect */
+          if (lose_fetched_dist)
+            {
+              stat_add_sample(lose_fetched_dist,
+                              recover_squashed + fetchq_squashed);
+              stat_add_sample(lose_dispatched_dist, recover_squashed);
+              stat_add_sample(lose_issued_dist, recover_squashed_issued);
+            }
+          if (fork_report_fname)
+            frep_branch(rs->PC)->wrong += recover_squashed + fetchq_squashed;
+          if (!rs->spec_mode)
+            {
+              tick_t saved = (sim_cycle
+                              - thread_states[rs->fork_id].start_cycle)
+                             + ruu_branch_penalty;
+
+              fork_won++;
+              fork_cycles_saved += saved;
+              if (fst)
+                {
+                  fork_fst_useful++;
+                  fst_update(rs->PC, /* useful */TRUE);
+                }
+              if (fork_report_fname)
+                {
+                  struct frep_ent *e = frep_branch(rs->PC);
+
+                  e->won++;
+                  e->saved += saved;
+                }
+            }
           //fprintf(stderr, "Mispredicted forking branch on thread (%d)\n", rs->thread_id);
           int test_thread;
           for (test_thread = 0; test_thread < max_threads; test_thread++) {
@@ -2568,7 +4403,7 @@ ruu_writeback(void)
             if (thread_states[test_thread].parent_fork_counters[rs->thread_id] >= rs->fork_counter && test_thread != rs->thread_id) {
               //fprintf(stderr, "Entirely wiping out thread (%d)\n", test_thread);
               // Free these threads and reset their parent fork pointers
-              thread_states[test_thread].in_use = FALSE;
+              thread_release(test_thread);
               for (int n = 0; n < max_threads; n++) {
                 thread_states[test_thread].parent_fork_counters[n] = -1;
               }
@@ -2578,9 +4413,10 @@ ruu_writeback(void)
           // TODO: tracer recovery - we should be squashing IFQ instructions with this thread id
         } else {
           panic("This should not be called at the moment");
-          ruu_recover(rs-RUU, rs->fork_id, 0);
-          squash_fetchq_invalids(rs->thread_id, rs->fork_counter);
-          thread_states[rs->fork_id].in_use = FALSE;
+          ruu_recover(rs-RUU, rs->fork_id, 0, PEND_FORKLOSS);
+          squash_fetchq_invalids(rs->thread_id, rs->fork_counter,
+				 PEND_FORKLOSS);
+          thread_release(rs->fork_id);
           for (int n = 0; n < max_threads; n++) {
             thread_states[rs->fork_id].parent_fork_counters[n] = -1;
           }
@@ -2588,7 +4424,7 @@ ruu_writeback(void)
           for (test_thread = 0; test_thread < max_threads; test_thread++) {
             if (thread_states[test_thread].parent_fork_counters[rs->fork_id] >= rs->fork_counter) {
               // Free these threads and reset their parent fork pointers
-              thread_states[test_thread].in_use = FALSE;
+              thread_release(test_thread);
               for (int n = 0; n < max_threads; n++) {
                 thread_states[test_thread].parent_fork_counters[n] = -1;
               }
@@ -2603,17 +4439,24 @@ ruu_writeback(void)
 
 	  /* recover processor state and reinit fetch to correct path */
 
-	  ruu_recover(rs - RUU, rs->thread_id, rs->fork_counter);
+	  ci_capture(rs - RUU, rs->thread_id);
+	  ruu_recover(rs - RUU, rs->thread_id, rs->fork_counter, PEND_MISPRED);
 	  tracer_recover(rs);
+	  if (!rs->spec_mode)
+	    cpi_fe_event(cc_bpred);
 	  bpred_recover(pred, rs->PC, rs->stack_recover_idx);
 
+	  /* a fork here would have won, let the FST allow the next one */
+	  if (!rs->spec_mode)
+	    fst_update(rs->PC, /* useful */TRUE);
+
     int test_thread;
     for (test_thread = 0; test_thread < max_threads; test_thread++) {
       // really might need another check here
       if (thread_states[test_thread].parent_fork_counters[rs->thread_id] >= rs->fork_counter && test_thread!=rs->thread_id) {
         //fprintf(stderr, "Entirely wiping out thread (%d)\n", test_thread);
         // Free these threads and reset their parent fork pointers
-        thread_states[test_thread].in_use = FALSE;
+        thread_release(test_thread);
         for (int n = 0; n < max_threads; n++) {
           thread_states[test_thread].parent_fork_counters[n] = -1;
         }
@@ -2633,6 +4476,7 @@ ruu_writeback(void)
 	  && !rs->in_LSQ
 	  && (MD_OP_FLAGS(rs->op) & F_CTRL))
 	{
+	  bpred_wrong_path = rs->spec_mode;
 	  bpred_update(pred,
 		       /* branch address */rs->PC,
 		       /* actual target address */rs->next_PC,
@@ -2643,6 +4487,7 @@ ruu_writeback(void)
 		       /* correct pred? */rs->pred_PC == rs->next_PC,
 		       /* opcode */rs->op,
 		       /* dir predictor update pointer */&rs->dir_update);
+	  bpred_wrong_path = FALSE;
 	}
 
       /* entered writeback stage, indicate in pipe trace */
@@ -2661,7 +4506,7 @@ ruu_writeback(void)
 
         /* have to go through every thread's spec create vector looking for a pointer to this ruu ruu_entry
            and set it to null if it matches */
-        for (int t=0; t <= max_threads; t++) {
+        for (int t=0; t < max_threads; t++) {
           int curr_thread_max_spec = thread_states[t].spec_level;
           for (int s=0; s<=curr_thread_max_spec; s++) {
             link = spec_create_vector[t][s][rs->onames[i]];
@@ -2713,7 +4558,12 @@ ruu_writeback(void)
 			      || ((MD_OP_FLAGS(olink->rs->op)&(F_MEM|F_STORE))
 				  == (F_MEM|F_STORE)))
 			    readyq_enqueue(olink->rs);
-			  /* else, ld op, issued when no mem conflict */
+			  else
+			    {
+			      /* ld op, issued by lsq_refresh() when no mem
+				 conflict */
+			      ldwait_insert(olink->rs);
+			    }
 			}
 		    }
 
@@ -2739,117 +4589,91 @@ ruu_writeback(void)
  *  LSQ_REFRESH() - memory access dependence checker/scheduler
  */
 
+/* non-zero if load LD must not issue yet under the memory dependence
+   policy */
+static int
+lsq_load_blocked(struct RUU_station *ld)
+{
+  struct RUU_station *st;
+
+  if (memdep_policy == md_none)
+    return sta_load_blocked(ld);
+
+  /* wait for the store predicted by the store sets to execute */
+  if (storeset_waiting(ld))
+    return TRUE;
+
+  if (memdep_policy == md_conservative && sta_unknown_before(ld))
+    return TRUE;
+
+  /* the forwarding store is known, but its data is not */
+  st = sta_producer(ld);
+  return (st && STORE_ADDR_READY(st) && !OPERANDS_READY(st));
+}
+
 /* this function locates ready instructions whose memory dependencies have
-   been satisfied, this is accomplished by walking the LSQ for loads, looking
-   for blocking memory dependency condition (e.g., earlier store with an
-   unknown address) */
-#define MAX_STD_UNKNOWNS		64
+   been satisfied, this is accomplished by walking the waiting load list
+   (loads with a known address that have not issued, in program order), and
+   looking up the store each one would forward from in the store address
+   table; a load waits while that store's data is unknown; loads that
+   issued ahead of a store to their address stay on the list, and are
+   checked for an ordering violation once that store's address is known */
 static void
 lsq_refresh(void)
 {
-  int i, j, index;
-  md_addr_t std_unknowns[max_threads][MAX_STD_UNKNOWNS];
-  int n_std_unknowns[max_threads];
-  for (i=0; i < max_threads; i++) {
-    n_std_unknowns[i] = 0;
-  }
-  int still_valid[max_threads];
-  for (i=0 ; i < max_threads; i++) {
-      still_valid[i] = TRUE;
-  }
+  int i;
+  struct RUU_station *ld, *ld_next;
+
+  /* periodically forget the store sets, bounds false dependences */
+  if (memdep_policy == md_storeset && sim_cycle % SSIT_CLEAR_INTERVAL == 0)
+    for (i=0; i < ssit_size; i++)
+      ssit[i] = SSID_INVALID;
 
-  /* scan entire queue for ready loads: scan from oldest instruction
-     (head) until we reach the tail or an unresolved store, after which no
-     other instruction will become ready */
-  for (i=0, index=LSQ_head;
-       i < LSQ_num;
-       i++, index=(index + 1) % LSQ_size)
+  /* scan the waiting loads for ready ones */
+  for (ld = ldwait_head; ld != NULL; ld = ld_next)
     {
+      ld_next = ld->ldwait_next;
+
       /* no deps should be created from a squashed insn */
-      if (LSQ[index].squashed) {
-        continue;
-      }
-      int curr_thread_id = LSQ[index].thread_id;
-      int curr_fork_counter = LSQ[index].fork_counter;
-      /* terminate search for ready loads after first unresolved store,
-	 as no later load could be resolved in its presence */
-      if (/* store? */
-	  (MD_OP_FLAGS(LSQ[index].op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+      if (ld->squashed)
 	{
-	  if (!STORE_ADDR_READY(&LSQ[index]))
-	    {
-        int test_thread;
-        still_valid[curr_thread_id] = FALSE;
-        for (test_thread = 0; test_thread < max_threads; test_thread++) {
-          if (thread_states[test_thread].in_use == TRUE &&
-            (thread_states[test_thread].parent_fork_counters[curr_thread_id] != -1) &&
-            (thread_states[test_thread].parent_fork_counters[curr_thread_id] >= curr_fork_counter)) {
-              still_valid[test_thread] = FALSE;
-            }
-        }
-	      /* FIXME: a later STD + STD known could hide the STA unknown */
-	      /* sta unknown, blocks all later loads, stop search */
-	      //break;
-	    }
-	  else if (!OPERANDS_READY(&LSQ[index]))
-	    {
-	      /* sta known, but std unknown, may block a later store, record
-		 this address for later referral, we use an array here because
-		 for most simulations the number of entries to search will be
-		 very small */
-
-        int test_thread;
-        std_unknowns[curr_thread_id][n_std_unknowns[curr_thread_id]++] = LSQ[index].addr;
-        // Also must check all of the children of this branch, assuming they are upstream from this
-        for (test_thread = 0; test_thread < max_threads; test_thread++) {
-          if (thread_states[test_thread].in_use == TRUE &&
-            (thread_states[test_thread].parent_fork_counters[curr_thread_id] != -1) &&
-            (thread_states[test_thread].parent_fork_counters[curr_thread_id] >= curr_fork_counter)) {
-              if (n_std_unknowns[test_thread] == MAX_STD_UNKNOWNS)
-      		      fatal("STD unknown array overflow, increase MAX_STD_UNKNOWNS");
-              std_unknowns[test_thread][n_std_unknowns[test_thread]++] = LSQ[index].addr;
-            }
-        }
-	    }
-	  else /* STORE_ADDR_READY() && OPERANDS_READY() */
-	    {
-        int test_thread;
-        for (j=0; j < n_std_unknowns[curr_thread_id]; j++) {
-          if (std_unknowns[curr_thread_id][j] == LSQ[index].addr) {
-            std_unknowns[curr_thread_id][j] = 0;
-          }
-        }
+	  ldwait_remove(ld);
+	  continue;
+	}
 
-        for (test_thread = 0; test_thread < max_threads; test_thread++) {
-          if (thread_states[test_thread].in_use == TRUE &&
-            (thread_states[test_thread].parent_fork_counters[curr_thread_id] != -1) &&
-            (thread_states[test_thread].parent_fork_counters[curr_thread_id] >= curr_fork_counter)) {
-            for (j=0; j < n_std_unknowns[test_thread]; j++) {
-              if (std_unknowns[test_thread][j] == LSQ[index].addr) {
-                std_unknowns[test_thread][j] = 0;
-              }
-            }
-          }
-        }
+      /* load waiting on an earlier store to resolve its address? */
+      if (ld->viol_st
+	  && (ld->viol_st->seq != ld->viol_seq
+	      || STORE_ADDR_READY(ld->viol_st)))
+	{
+	  if (ld->viol_st->seq == ld->viol_seq)
+	    {
+	      /* the store writes this load's address: ordering violation,
+		 re-execute the load and charge the front-end refill */
+	      lsq_mem_violations++;
+	      if (memdep_policy == md_storeset)
+		storeset_violation(ld, ld->viol_st);
+	      ruu_fetch_issue_delay = MAX(ruu_fetch_issue_delay,
+					  ruu_branch_penalty);
 	    }
+	  ld->viol_st = NULL;
+	  ld->issued = FALSE;
 	}
 
       if (/* load? */
-	  ((MD_OP_FLAGS(LSQ[index].op) & (F_MEM|F_LOAD)) == (F_MEM|F_LOAD))
-	  && /* queued? */!LSQ[index].queued
-	  && /* waiting? */!LSQ[index].issued
-	  && /* completed? */!LSQ[index].completed
-	  && /* regs ready? */OPERANDS_READY(&LSQ[index]))
+	  ((MD_OP_FLAGS(ld->op) & (F_MEM|F_LOAD)) == (F_MEM|F_LOAD))
+	  && /* queued? */!ld->queued
+	  && /* waiting? */!ld->issued
+	  && /* completed? */!ld->completed
+	  && /* regs ready? */OPERANDS_READY(ld)
+	  && /* memory deps ready? */!lsq_load_blocked(ld))
 	{
-    for (j=0; j < n_std_unknowns[curr_thread_id]; j++) {
-      if (std_unknowns[curr_thread_id][j] == LSQ[index].addr) {
-        break;
-      }
-    }
-    if (j == n_std_unknowns[curr_thread_id]) {
-      readyq_enqueue(&LSQ[index]);
-    }
+	  readyq_enqueue(ld);
 	}
+
+      /* done waiting once issued and clear of earlier stores */
+      if (!ld->viol_st && (ld->queued || ld->issued || ld->completed))
+	ldwait_remove(ld);
     }
 }
 
@@ -2906,6 +4730,13 @@ ruu_issue(void)
 	  rs->queued = FALSE;
 
 	  if (rs->in_LSQ
+	      && ((MD_OP_FLAGS(rs->op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+	      && storeset_waiting(rs))
+	    {
+	      /* a store waits for the previous store of its store set */
+	      readyq_enqueue(rs);
+	    }
+	  else if (rs->in_LSQ
 	      && ((MD_OP_FLAGS(rs->op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE)))
 	    {
 	      /* stores complete in effectively zero time, result is
@@ -2950,11 +4781,28 @@ ruu_issue(void)
 			{
 			  int events = 0;
 
-			  /* for loads, determine cache access latency:
-			     first scan LSQ to see if a store forward is
-			     possible, if not, access the data cache */
-			  load_lat = 0;
-			  i = (rs - LSQ);
+			  /* a load that passes an earlier store to its address
+			     whose address is not known yet reads stale data, its
+			     result is held until the store address resolves */
+			  if (memdep_policy != md_none)
+			    {
+			      struct RUU_station *st = sta_producer(rs);
+
+			      if (sta_unknown_before(rs))
+				lsq_spec_loads++;
+			      if (st && !STORE_ADDR_READY(st))
+				{
+				  rs->viol_st = st;
+				  rs->viol_seq = st->seq;
+				  ldwait_insert(rs);
+				}
+			    }
+
+			  /* for loads, determine cache access latency:
+			     first scan LSQ to see if a store forward is
+			     possible, if not, access the data cache */
+			  load_lat = 0;
+			  i = (rs - LSQ);
 			  if (i != LSQ_head)
 			    {
 			      for (;;)
@@ -2978,6 +4826,7 @@ ruu_issue(void)
 			    }
 
 			  /* was the value store forwared from the LSQ? */
+			  cache_wrong_path = rs->spec_mode;
 			  if (!load_lat)
 			    {
 			      int valid_addr = MD_VALID_ADDR(rs->addr);
@@ -3017,9 +4866,15 @@ ruu_issue(void)
 			      /* D-cache/D-TLB accesses occur in parallel */
 			      load_lat = MAX(tlb_lat, load_lat);
 			    }
+			  cache_wrong_path = FALSE;
+
+			  if (runahead && !rs->spec_mode)
+			    ra_prefetch_used(rs->addr, load_lat);
 
 			  /* use computed cache access latency */
-			  eventq_queue_event(rs, sim_cycle + load_lat);
+			  rs->mem_lat = load_lat;
+			  if (!rs->viol_st)
+			    eventq_queue_event(rs, sim_cycle + load_lat);
 
 			  /* entered execute stage, indicate in pipe trace */
 			  ptrace_newstage(rs->ptrace_seq, PST_EXECUTE,
@@ -3028,8 +4883,21 @@ ruu_issue(void)
 			}
 		      else /* !load && !store */
 			{
+			  int lat = fu->oplat;
+
+			  /* a store's address can be held back to force
+			     memory ordering violations (-lsq:sta_delay) */
+			  if (sta_delay && rs->ea_comp)
+			    {
+			      enum md_opcode op;
+
+			      MD_SET_OPCODE(op, rs->IR);
+			      if (MD_OP_FLAGS(op) & F_STORE)
+				lat += sta_delay;
+			    }
+
 			  /* use deterministic functional unit latency */
-			  eventq_queue_event(rs, sim_cycle + fu->oplat);
+			  eventq_queue_event(rs, sim_cycle + lat);
 
 			  /* entered execute stage, indicate in pipe trace */
 			  ptrace_newstage(rs->ptrace_seq, PST_EXECUTE,
@@ -3112,17 +4980,20 @@ ruu_issue(void)
 /* integer register file */
 #define R_BMAP_SZ       (BITMAP_SIZE(MD_NUM_IREGS))
 static BITMAP_TYPE(MD_NUM_IREGS, use_spec_R);
-static md_gpr_t spec_regs_R[MAX_THREADS][MAX_SPEC_LEVELS];
+static md_gpr_t **spec_regs_R;
 
 /* floating point register file */
 #define F_BMAP_SZ       (BITMAP_SIZE(MD_NUM_FREGS))
 static BITMAP_TYPE(MD_NUM_FREGS, use_spec_F);
-static md_fpr_t spec_regs_F[MAX_THREADS][MAX_SPEC_LEVELS];
+static md_fpr_t **spec_regs_F;
 
 /* miscellaneous registers */
 #define C_BMAP_SZ       (BITMAP_SIZE(MD_NUM_CREGS))
 static BITMAP_TYPE(MD_NUM_FREGS, use_spec_C);
-static md_ctrl_t spec_regs_C[MAX_THREADS][MAX_SPEC_LEVELS];
+static md_ctrl_t **spec_regs_C;
+
+/* mis-speculation levels allocated to each thread */
+static int *spec_levels_alloc;
 
 /* dump speculative register state */
 static void
@@ -3188,8 +5059,8 @@ static struct spec_mem_ent *store_htable[STORE_HASH_SIZE];
 static struct spec_mem_ent *bucket_free_list = NULL;
 
 
-/* program counter */
-static md_addr_t pred_PC[MAX_THREADS];
+/* program counter, predicted next PC of each thread */
+static md_addr_t *pred_PC;
 static md_addr_t recover_PC;
 
 
@@ -3201,32 +5072,21 @@ struct fetch_rec {
   int stack_recover_idx;		/* branch predictor RSB index */
   unsigned int ptrace_seq;		/* print trace sequence id */
   int thread_id; /* thread id of the fetched instruction */
-  int squashed; /* is this instruction squashed? */
+  int squashed; /* squashed, awaiting removal by fetchq_compact() */
 };
 static struct fetch_rec *fetch_data;	/* IFETCH -> DISPATCH inst queue */
 static int fetch_num;			/* num entries in IF -> DIS queue */
 static int fetch_tail, fetch_head;	/* head and tail pointers of queue */
 
-/* recover instruction trace generator state to precise state state immediately
-   before the first mis-predicted branch; this is accomplished by resetting
-   all register value copied-on-write bitmasks are reset, and the speculative
-   memory hash table is cleared */
+/* throw away all speculative register and memory state: the register value
+   copied-on-write bitmasks are reset, and the speculative memory hash table
+   is cleared */
 static void
-tracer_recover(struct RUU_station *rs_branch)
+tracer_reset_spec(void)
 {
   int i;
   struct spec_mem_ent *ent, *ent_next;
 
-  /* better be in mis-speculative trace generation mode */
-  if (!thread_states[rs_branch->thread_id].spec_mode)
-    panic("cannot recover unless in speculative mode");
-
-  /* reset to non-speculative trace generation mode */
-  thread_states[rs_branch->thread_id].spec_level = rs_branch->spec_level;
-  if (rs_branch->spec_level == -1) {
-    thread_states[rs_branch->thread_id].spec_mode = FALSE;
-  }
-
   /* reset copied-on-write register bitmasks back to non-speculative state */
   BITMAP_CLEAR_MAP(use_spec_R, R_BMAP_SZ);
   BITMAP_CLEAR_MAP(use_spec_F, F_BMAP_SZ);
@@ -3245,45 +5105,117 @@ tracer_recover(struct RUU_station *rs_branch)
 	}
       store_htable[i] = NULL;
     }
+}
 
-  /* Don't clear the entire fetch queue - just clear the entries associated with this thread */
-  int fetch_index = fetch_head;
-  int visited = 0;
-  while (visited != fetch_num) {
-    int fetch_thread_id = fetch_data[fetch_index].thread_id;
-    if (fetch_thread_id == rs_branch->thread_id || thread_states[fetch_thread_id].parent_fork_counters[rs_branch->thread_id] >= rs_branch->fork_counter) {
-      fetch_data[fetch_index].squashed = TRUE;
-      if (ptrace_active) {
-        ptrace_endinst(fetch_data[fetch_index].ptrace_seq);
-      }
-    }
-    fetch_index = (fetch_index + 1) & (ruu_ifq_size - 1);
-    visited++;
+/* redirect THREAD's fetch to PC, dropping any I-cache stall or fetch buffer
+   left over from the path it was fetching before */
+static void
+fetch_redirect(int thread, md_addr_t pc)
+{
+  struct thread_state *ts = &thread_states[thread];
+
+  ts->fetch_pred_PC = ts->fetch_regs_PC = pc;
+  ts->fetch_blk = 0;
+  ts->fetch_blk_cycle = 0;
+  ts->fetch_resume = 0;
+}
+
+/* recover instruction trace generator state to precise state state immediately
+   before the first mis-predicted branch; this is accomplished by resetting
+   all register value copied-on-write bitmasks are reset, and the speculative
+   memory hash table is cleared */
+static void
+tracer_recover(struct RUU_station *rs_branch)
+{
+  /* better be in mis-speculative trace generation mode */
+  if (!thread_states[rs_branch->thread_id].spec_mode)
+    panic("cannot recover unless in speculative mode");
+
+  /* reset to non-speculative trace generation mode */
+  thread_states[rs_branch->thread_id].spec_level = rs_branch->spec_level;
+  if (rs_branch->spec_level == -1) {
+    thread_states[rs_branch->thread_id].spec_mode = FALSE;
   }
 
-  /* if pipetracing, indicate squash of instructions in the inst fetch queue */
+  tracer_reset_spec();
+
+  /* Don't clear the entire fetch queue - just clear the entries associated with this thread */
+  squash_fetchq_invalids(rs_branch->thread_id, rs_branch->fork_counter,
+			 PEND_MISPRED);
 
   //fprintf(stderr, "Recovery from non-fork in thread (%d)\n", rs_branch->thread_id);
-  thread_states[rs_branch->thread_id].fetch_pred_PC = thread_states[rs_branch->thread_id].fetch_regs_PC = rs_branch->next_PC;
+  fetch_redirect(rs_branch->thread_id, rs_branch->next_PC);
+}
+
+/* remove the squashed instructions from the IFQ, sliding the surviving
+   entries toward the head so the freed slots can be refilled by fetch right
+   away; the first KEEP entries at the head are left in place */
+static void
+fetchq_compact(int keep)
+{
+  int src, dst, kept, visited;
+
+  src = dst = (fetch_head + keep) & (ruu_ifq_size - 1);
+  for (visited = kept = keep; visited < fetch_num; visited++)
+    {
+      if (fetch_data[src].squashed)
+	IFQ_squash_reclaimed++;
+      else
+	{
+	  if (dst != src)
+	    fetch_data[dst] = fetch_data[src];
+	  dst = (dst + 1) & (ruu_ifq_size - 1);
+	  kept++;
+	}
+      src = (src + 1) & (ruu_ifq_size - 1);
+    }
+  fetch_num = kept;
+  fetch_tail = dst;
 }
 
 static void
-squash_fetchq_invalids(int thread_id, int fork_counter)
+squash_fetchq_invalids(int thread_id, int fork_counter, int reason)
 {
 
   int fetch_index = fetch_head;
   int visited = 0;
+  fetchq_squashed = 0;
   while (visited != fetch_num) {
     int fetch_thread_id = fetch_data[fetch_index].thread_id;
     if (fetch_thread_id == thread_id || thread_states[fetch_thread_id].parent_fork_counters[thread_id] >= fork_counter) {
+      if (!fetch_data[fetch_index].squashed)
+        fetchq_squashed++;
       fetch_data[fetch_index].squashed = TRUE;
       if (ptrace_active) {
-        ptrace_endinst(fetch_data[fetch_index].ptrace_seq);
+        ptrace_endinst(fetch_data[fetch_index].ptrace_seq, reason);
       }
     }
     fetch_index = (fetch_index + 1) & (ruu_ifq_size - 1);
     visited++;
   }
+  fetchq_compact(0);
+}
+
+/* drop every instruction younger than the IFQ head that was fetched by
+   THREAD_ID; used on a mis-fetch, which must not discard the fetched (and
+   already PC-advanced) instructions of other threads */
+static void
+fetchq_flush_thread(int thread_id)
+{
+  int fetch_index, visited;
+
+  fetch_index = (fetch_head + 1) & (ruu_ifq_size - 1);
+  for (visited = 1; visited < fetch_num; visited++)
+    {
+      if (fetch_data[fetch_index].thread_id == thread_id)
+	{
+	  fetch_data[fetch_index].squashed = TRUE;
+	  if (ptrace_active)
+	    ptrace_endinst(fetch_data[fetch_index].ptrace_seq, PEND_MISFETCH);
+	}
+      fetch_index = (fetch_index + 1) & (ruu_ifq_size - 1);
+    }
+  fetchq_compact(1);
 }
 
 /* initialize the speculative instruction state generator state */
@@ -3300,6 +5232,54 @@ tracer_init(void)
   /* memory state is from non-speculative memory pages */
   for (i=0; i<STORE_HASH_SIZE; i++)
     store_htable[i] = NULL;
+
+  /* per-thread state, mis-speculation levels are added on demand */
+  pred_PC = calloc(max_threads, sizeof(md_addr_t));
+  spec_regs_R = calloc(max_threads, sizeof(md_gpr_t *));
+  spec_regs_F = calloc(max_threads, sizeof(md_fpr_t *));
+  spec_regs_C = calloc(max_threads, sizeof(md_ctrl_t *));
+  spec_levels_alloc = calloc(max_threads, sizeof(int));
+  if (!pred_PC || !spec_regs_R || !spec_regs_F || !spec_regs_C
+      || !spec_levels_alloc)
+    fatal("out of virtual memory");
+}
+
+/* make sure THREAD has mis-speculation state for LEVEL, levels are
+   allocated in doubling steps up to -max:spec_levels */
+static void
+spec_levels_reserve(int thread, int level)
+{
+  int old_nlevels = spec_levels_alloc[thread], nlevels;
+
+  if (level < old_nlevels)
+    return;
+  if (level >= max_spec_levels)
+    fatal("thread %d mis-speculation depth exceeds -max:spec_levels (%d)",
+	  thread, max_spec_levels);
+
+  nlevels = old_nlevels ? old_nlevels : 4;
+  while (nlevels <= level)
+    nlevels *= 2;
+  nlevels = MIN(nlevels, max_spec_levels);
+
+#define SPEC_GROW(ARR)							\
+  do {									\
+    (ARR)[thread] = realloc((ARR)[thread], nlevels * sizeof(*(ARR)[thread]));\
+    if (!(ARR)[thread])							\
+      fatal("out of virtual memory");					\
+    memset(&(ARR)[thread][old_nlevels], 0,				\
+	   (nlevels - old_nlevels) * sizeof(*(ARR)[thread]));		\
+  } while (0)
+
+  /* NOTE: a zeroed create vector entry is CVLINK_NULL */
+  SPEC_GROW(spec_create_vector);
+  SPEC_GROW(spec_create_vector_rt);
+  SPEC_GROW(spec_regs_R);
+  SPEC_GROW(spec_regs_F);
+  SPEC_GROW(spec_regs_C);
+#undef SPEC_GROW
+
+  spec_levels_alloc[thread] = nlevels;
 }
 
 
@@ -3851,11 +5831,13 @@ ruu_install_odep(struct RUU_station *rs,	/* creating RUU station */
   __WRITE_SPECMEM(MD_SWAPQ(SRC), (DST), temp_qword, (FAULT))
 #endif /* HOST_HAS_QWORD */
 
-/* system call handler macro */
+/* system call handler macro, the lockstep checker takes the call's results */
 #define SYSCALL(INST)							\
   (/* only execute system calls in non-speculative mode */		\
    (spec_mode ? panic("speculative syscall") : (void) 0),		\
-   sys_syscall(&regs, mem_access, mem, INST, TRUE))
+   sys_syscall(&regs, lockstep_mode ? lockstep_mem_access : mem_access,	\
+	       mem, INST, TRUE),					\
+   (lockstep_mode ? lockstep_syscall(&regs) : (void) 0))
 
 /* default register state accessor, used by DLite */
 static char *					/* err str, NULL for no err */
@@ -3977,13 +5959,395 @@ simoo_reg_obj(struct regs_t *xregs,		/* registers to access */
   return NULL;
 }
 
+/*
+ *  CONTROL INDEPENDENCE - reuse of post-reconvergence work across squashes
+ */
+
+/* a losing-path instruction kept at a squash */
+struct ci_ent {
+  md_addr_t PC;				/* inst PC */
+  enum md_opcode op;			/* opcode (ld/st, not the addr comp) */
+  int in[MAX_IDEPS];			/* input logical names */
+  int out[MAX_ODEPS];			/* output logical names */
+  int done;				/* completed before the squash */
+};
+
+/* per-thread control independence context, the thread is the winning path
+   of a mis-predicted branch; it poisons every register it writes until it
+   reaches an instruction kept from the losing path (reconvergence), from
+   there on both instruction streams are followed in lockstep */
+struct ci_ctx {
+  enum {
+    ci_idle,				/* nothing to reuse */
+    ci_track,				/* before reconvergence */
+    ci_follow				/* past reconvergence */
+  } state;
+  INST_SEQ_TYPE br_seq;			/* seq of the mis-predicted branch */
+  md_addr_t br_PC;			/* PC of the mis-predicted branch */
+  struct ci_ent *ent;			/* kept losing-path insts, in order */
+  int nent;				/* number of kept insts */
+  int lo;				/* first entry reconvergence may hit */
+  int pos;				/* next entry to match, ci_follow */
+  int search_left;			/* insts left to find reconvergence */
+  BITMAP_TYPE(MD_TOTAL_REGS, poison);	/* regs written on either path */
+  int mem_poison;			/* memory written on either path */
+};
+static struct ci_ctx *ci_ctxs;
+
+/* reconvergence table, last reconvergence PC seen per branch */
+struct rct_ent {
+  md_addr_t br_PC;			/* branch PC, 0 if unused */
+  md_addr_t reconv_PC;			/* where both paths met last time */
+};
+static struct rct_ent *rct;
+
+#define RCT_INDEX(PC)		(((PC) >> MD_BR_SHIFT) & (rct_size - 1))
+
+/* non-zero if logical register name N is poisoned in CTX */
+#define CI_POISONED(CTX, N)						\
+  ((N) != NA && BITMAP_SET_P((CTX)->poison, BITMAP_SIZE(MD_TOTAL_REGS), (N)))
+
+/* initialize the control independence contexts */
+static void
+ci_init(void)
+{
+  int i;
+
+  ci_ctxs = calloc(max_threads, sizeof(struct ci_ctx));
+  if (!ci_ctxs)
+    fatal("out of virtual memory");
+
+  if (reconv_policy == rc_none)
+    return;
+
+  for (i=0; i < max_threads; i++)
+    {
+      ci_ctxs[i].ent = calloc(RUU_size, sizeof(struct ci_ent));
+      if (!ci_ctxs[i].ent)
+	fatal("out of virtual memory");
+    }
+
+  if (reconv_policy == rc_dynamic)
+    {
+      rct = calloc(rct_size, sizeof(struct rct_ent));
+      if (!rct)
+	fatal("out of virtual memory");
+    }
+}
+
+/* decode the logical input and output register names of INST */
+static void
+ci_inst_deps(md_inst_t inst, int *in, int *out)
+{
+  enum md_opcode op;
+
+  MD_SET_OPCODE(op, inst);
+  switch (op)
+    {
+#define DEFINST(OP,MSK,NAME,OPFORM,RES,CLASS,O1,O2,I1,I2,I3)		\
+    case OP:								\
+      out[0] = O1; out[1] = O2;						\
+      in[0] = I1; in[1] = I2; in[2] = I3;				\
+      break;
+#define DEFLINK(OP,MSK,NAME,MASK,SHIFT)					\
+    case OP:								\
+      out[0] = NA; out[1] = NA;						\
+      in[0] = NA; in[1] = NA; in[2] = NA;				\
+      break;
+#define CONNECT(OP)
+#include "machine.def"
+    default:
+      out[0] = NA; out[1] = NA;
+      in[0] = NA; in[1] = NA; in[2] = NA;
+    }
+}
+
+/* start a new winning path on THREAD for the branch RS_BR, called when
+   the thread is forked off for the branch's other path, or when it is
+   redirected there after the branch resolved */
+static void
+ci_start(int thread, struct RUU_station *rs_br)
+{
+  struct ci_ctx *ctx = &ci_ctxs[thread];
+
+  if (reconv_policy == rc_none)
+    return;
+
+  ctx->state = ci_track;
+  ctx->br_seq = rs_br->seq;
+  ctx->br_PC = rs_br->PC;
+  ctx->nent = 0;
+  BITMAP_CLEAR_MAP(ctx->poison, BITMAP_SIZE(MD_TOTAL_REGS));
+  ctx->mem_poison = FALSE;
+}
+
+/* keep the losing path of the mis-predicted branch RS_BR (at BRANCH_INDEX
+   in the RUU) for the winning path on thread WINNER, call before the
+   losing path is squashed by ruu_recover() */
+static void
+ci_capture(int branch_index, int winner)
+{
+  struct RUU_station *rs_br = &RUU[branch_index];
+  struct ci_ctx *ctx = &ci_ctxs[winner];
+  int RUU_index, LSQ_index, n, k;
+  md_addr_t reconv_PC = 0;
+
+  if (reconv_policy == rc_none)
+    return;
+
+  /* the losing thread's own positions past the branch are squashed */
+  if (winner != rs_br->thread_id)
+    ci_ctxs[rs_br->thread_id].state = ci_idle;
+
+  /* a forked winner is already tracking this branch, a redirected one
+     starts over */
+  if (winner == rs_br->thread_id)
+    ci_start(winner, rs_br);
+  else if (ctx->state != ci_track || ctx->br_seq != rs_br->seq)
+    return;
+
+  /* collect the losing thread's instructions, youngest first */
+  n = 0;
+  RUU_index = (RUU_tail + (RUU_size-1)) % RUU_size;
+  LSQ_index = (LSQ_tail + (LSQ_size-1)) % LSQ_size;
+  while (RUU_index != branch_index)
+    {
+      struct RUU_station *rs = &RUU[RUU_index];
+
+      if (!rs->squashed && rs->thread_id == rs_br->thread_id)
+	{
+	  struct ci_ent *e = &ctx->ent[n++];
+
+	  e->PC = rs->PC;
+	  e->op = rs->ea_comp ? LSQ[LSQ_index].op : rs->op;
+	  e->done = rs->completed;
+	  ci_inst_deps(rs->IR, e->in, e->out);
+	}
+      if (rs->ea_comp)
+	LSQ_index = (LSQ_index + (LSQ_size-1)) % LSQ_size;
+      RUU_index = (RUU_index + (RUU_size-1)) % RUU_size;
+    }
+
+  /* ... and put them in program order */
+  for (k=0; k < n/2; k++)
+    {
+      struct ci_ent tmp = ctx->ent[k];
+
+      ctx->ent[k] = ctx->ent[n-1-k];
+      ctx->ent[n-1-k] = tmp;
+    }
+
+  /* predict the reconvergence point */
+  if (reconv_policy == rc_static)
+    reconv_PC = cfg_ipdom(rs_br->PC);
+  else /* rc_dynamic */
+    {
+      struct rct_ent *r = &rct[RCT_INDEX(rs_br->PC)];
+
+      if (r->br_PC == rs_br->PC)
+	{
+	  rct_hits++;
+	  reconv_PC = r->reconv_PC;
+	}
+      else
+	rct_misses++;
+    }
+
+  ctx->lo = 0;
+  if (reconv_PC)
+    {
+      for (k=0; k < n && ctx->ent[k].PC != reconv_PC; k++)
+	/* nada */;
+      ctx->lo = k;
+    }
+  if (reconv_policy == rc_static && ctx->lo == n)
+    {
+      /* no static point, or the losing path never got there */
+      ctx->state = ci_idle;
+      return;
+    }
+  if (reconv_policy == rc_dynamic && ctx->lo == n)
+    ctx->lo = 0;
+
+  if (n == 0)
+    {
+      ctx->state = ci_idle;
+      return;
+    }
+
+  ctx->nent = n;
+  ctx->search_left = RUU_size;
+  ci_captures++;
+  ci_wrong_path_insn += n;
+}
+
+/* the winning path on THREAD dispatches PC, with opcode OP and register
+   names IN and OUT; returns non-zero if its result can be reused from the
+   kept losing path (control independent and completed there) */
+static int
+ci_dispatch(int thread, md_addr_t PC, enum md_opcode op, int *in, int *out)
+{
+  struct ci_ctx *ctx = &ci_ctxs[thread];
+  struct ci_ent *e;
+  int i, k, dep, reuse;
+
+  if (ctx->state == ci_idle)
+    return FALSE;
+
+  if (ctx->state == ci_track)
+    {
+      /* look for the reconvergence point in the kept losing path */
+      for (k=ctx->lo; k < ctx->nent && ctx->ent[k].PC != PC; k++)
+	/* nada */;
+      if (k == ctx->nent)
+	{
+	  /* still on the winning path's own (control dependent) code */
+	  for (i=0; i < MAX_ODEPS; i++)
+	    if (out[i] != NA)
+	      BITMAP_SET(ctx->poison, BITMAP_SIZE(MD_TOTAL_REGS), out[i]);
+	  if ((MD_OP_FLAGS(op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+	    ctx->mem_poison = TRUE;
+
+	  if (ctx->nent && --ctx->search_left == 0)
+	    {
+	      ci_no_reconv++;
+	      ctx->state = ci_idle;
+	    }
+	  return FALSE;
+	}
+
+      /* reconverged, everything the losing path wrote before is poisoned */
+      for (i=0; i < k; i++)
+	{
+	  int j;
+
+	  for (j=0; j < MAX_ODEPS; j++)
+	    if (ctx->ent[i].out[j] != NA)
+	      BITMAP_SET(ctx->poison, BITMAP_SIZE(MD_TOTAL_REGS),
+			 ctx->ent[i].out[j]);
+	  if ((MD_OP_FLAGS(ctx->ent[i].op) & (F_MEM|F_STORE))
+	      == (F_MEM|F_STORE))
+	    ctx->mem_poison = TRUE;
+	}
+
+      if (reconv_policy == rc_dynamic)
+	{
+	  rct[RCT_INDEX(ctx->br_PC)].br_PC = ctx->br_PC;
+	  rct[RCT_INDEX(ctx->br_PC)].reconv_PC = PC;
+	}
+
+      ci_reconv++;
+      ctx->state = ci_follow;
+      ctx->pos = k;
+    }
+
+  /* past reconvergence, both paths must execute the same instructions */
+  e = &ctx->ent[ctx->pos];
+  if (e->PC != PC)
+    {
+      ci_diverged++;
+      ctx->state = ci_idle;
+      return FALSE;
+    }
+
+  dep = (CI_POISONED(ctx, in[0]) || CI_POISONED(ctx, in[1])
+	 || CI_POISONED(ctx, in[2])
+	 || ((MD_OP_FLAGS(op) & (F_MEM|F_LOAD)) == (F_MEM|F_LOAD)
+	     && ctx->mem_poison));
+
+  /* outputs of control-independent insts hold the same value on both
+     paths again */
+  for (i=0; i < MAX_ODEPS; i++)
+    if (out[i] != NA)
+      {
+	if (dep)
+	  BITMAP_SET(ctx->poison, BITMAP_SIZE(MD_TOTAL_REGS), out[i]);
+	else
+	  BITMAP_CLEAR(ctx->poison, BITMAP_SIZE(MD_TOTAL_REGS), out[i]);
+      }
+  if (dep && (MD_OP_FLAGS(op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+    ctx->mem_poison = TRUE;
+
+  /* loads, stores and control transfers always go through the pipeline */
+  reuse = (!dep && e->done && !(MD_OP_FLAGS(op) & (F_MEM|F_CTRL|F_TRAP)));
+  if (reuse)
+    ci_reused_insn++;
+  else
+    ci_reexec_insn++;
+
+  if (++ctx->pos == ctx->nent)
+    ctx->state = ci_idle;
+
+  return reuse;
+}
+
+
 /* the last operation that ruu_dispatch() attempted to dispatch, for
    implementing in-order issue */
 static struct RS_link last_op = RSLINK_NULL_DATA;
 
+/* non-zero if the fork hints mark the branch at PC as worth forking: it
+   was mis-predicted often enough in the profile and, if requested, guards
+   a short enough hammock */
+static int
+fork_hinted(md_addr_t PC)
+{
+  struct hint_t *h = hint_lookup(PC);
+
+  if (!h || !h->count)
+    return FALSE;
+  if ((double)h->misses / (double)h->count < fork_hint_rate)
+    return FALSE;
+  if (fork_hint_hammock
+      && (h->hammock < 0 || h->hammock > fork_hint_hammock))
+    return FALSE;
+  return TRUE;
+}
+
+/* should the fork of branch RS_BRANCH be refused by the adaptive throttle,
+   counts the reason for a refusal */
+static int
+fork_throttled(struct RUU_station *rs_branch)
+{
+  int i, depth;
+
+  if (RUU_num * 100 >= RUU_size * fork_throttle_occ
+      || LSQ_num * 100 >= LSQ_size * fork_throttle_occ
+      || fetch_num * 100 >= ruu_ifq_size * fork_throttle_occ)
+    {
+      fork_throttle_occ_skips++;
+      return TRUE;
+    }
+
+  if (fork_throttle_depth)
+    {
+      /* the new thread sits one level below the forking thread */
+      depth = 1;
+      for (i=0; i < max_threads; i++)
+	if (thread_states[rs_branch->thread_id].parent_fork_counters[i] != -1)
+	  depth++;
+      if (depth > fork_throttle_depth)
+	{
+	  fork_throttle_depth_skips++;
+	  return TRUE;
+	}
+    }
+
+  if (fst[FST_INDEX(rs_branch->PC)] < 2)
+    {
+      fork_throttle_fst_skips++;
+      return TRUE;
+    }
+  return FALSE;
+}
+
 /* Checks to see if there's an available thread in order to fork */
 static int
 try_to_fork(md_addr_t fork_pc, struct RUU_station *rs_branch) {
+#ifdef SIM_SINGLE_PATH
+  /* no thread to fork to, ever */
+  return FALSE;
+#endif /* SIM_SINGLE_PATH */
   int forking_thread = rs_branch->thread_id;
   int forking_thread_counter = rs_branch->fork_counter;
   int fork_spec_level = rs_branch->spec_level;
@@ -4012,7 +6376,19 @@ try_to_fork(md_addr_t fork_pc, struct RUU_station *rs_branch) {
     return FALSE;
   }
 
+  /* with hints, only fork at branches known to be hard to predict */
+  if (fork_hints_fname && !fork_hinted(rs_branch->PC)) {
+    sim_num_hint_skips++;
+    return FALSE;
+  }
+
+  /* fall back to single-path speculation when forking does not pay */
+  if (fork_throttle && fork_throttled(rs_branch))
+    return FALSE;
+
   sim_num_forks++;
+  if (fork_report_fname)
+    frep_branch(rs_branch->PC)->forks++;
 
  // OHHH! There's an issue here
   thread_states[fork_thread_candidate].in_use = TRUE;
@@ -4021,9 +6397,19 @@ try_to_fork(md_addr_t fork_pc, struct RUU_station *rs_branch) {
     thread_states[fork_thread_candidate].parent_fork_counters[i] = thread_states[rs_branch->thread_id].parent_fork_counters[i];
   }
   thread_states[fork_thread_candidate].parent_fork_counters[forking_thread] = forking_thread_counter;
-  thread_states[fork_thread_candidate].fetch_pred_PC = fork_pc;
+  if (fork_depth_dist)
+    {
+      /* the new thread's ancestors, less the forking thread itself */
+      int depth = -1;
+      for (int i=0; i < max_threads; i++)
+        if (thread_states[fork_thread_candidate].parent_fork_counters[i] != -1)
+          depth++;
+      stat_add_sample(fork_depth_dist, depth);
+    }
+  fetch_redirect(fork_thread_candidate, fork_pc);
   thread_states[fork_thread_candidate].fetch_regs_PC = fork_pc - sizeof(md_inst_t);
   thread_states[fork_thread_candidate].keep_fetching = TRUE;
+  thread_states[fork_thread_candidate].start_cycle = sim_cycle;
 
   // TODO: fix for later implementation
 
@@ -4035,6 +6421,7 @@ try_to_fork(md_addr_t fork_pc, struct RUU_station *rs_branch) {
   if (rs_branch->spec_mode) {
     thread_states[fork_thread_candidate].spec_mode = TRUE;
     thread_states[fork_thread_candidate].spec_level = 0;
+    spec_levels_reserve(fork_thread_candidate, 0);
     memcpy(spec_create_vector[fork_thread_candidate][0], spec_create_vector[forking_thread][fork_spec_level],
      MD_TOTAL_REGS * sizeof(struct CV_link));
     memcpy(spec_create_vector_rt[fork_thread_candidate][0],
@@ -4051,32 +6438,333 @@ try_to_fork(md_addr_t fork_pc, struct RUU_station *rs_branch) {
   rs_branch->triggers_fork = TRUE;
   rs_branch->fork_id = fork_thread_candidate;
 
+  /* the new thread is the branch's winning path */
+  ci_start(fork_thread_candidate, rs_branch);
+
   return TRUE;
 }
 
 
-/* dispatch instructions from the IFETCH -> DISPATCH queue: instructions are
-   first decoded, then they allocated RUU (and LSQ for load/stores) resources
-   and input and output dependence chains are updated accordingly */
+/*
+ *  RUNAHEAD EXECUTION - pre-execution past a commit-blocking L2 miss
+ */
+
+/* an episode starts when the load at the head of the LSQ blocks commit with
+   the window full after missing in the L2 (or D-TLB); the dispatch slots the
+   stalled window leaves idle are then used to execute the insts that follow
+   the window, on a checkpoint of the register state in the speculative
+   register and memory state of thread 0 (see tracer_recover()), the episode
+   ends when the load completes and its state is thrown away, the only
+   lasting effect are the cache and TLB fills started by its loads; NOTE:
+   insts are executed at dispatch in this simulator, so the architected state
+   is that of the window tail and the window is kept across an episode, there
+   is no refetch of the insts after the blocking load */
+
+/* runahead prefetch table size, a direct-mapped record of the D-cache blocks
+   runahead loads missed on, used to count the prefetches demand loads use */
+#define RA_PFT_SIZE		1024
+
+static struct RUU_station *ra_load = NULL;	/* blocking load, if running */
+static INST_SEQ_TYPE ra_load_seq;		/* seq of the blocking load */
+static md_addr_t ra_next_PC;		/* next non-speculative inst to run */
+static md_addr_t ra_PC;			/* next runahead inst */
+static int ra_stopped;			/* off a path runahead can follow */
+static char ra_inv[MD_TOTAL_REGS];	/* registers with unknown (INV) value */
+static md_addr_t ra_pft[RA_PFT_SIZE];	/* blocks prefetched by runahead */
+
+#define RA_PFT_INDEX(BLK)						\
+  (((BLK) >> cache_dl1->set_shift) & (RA_PFT_SIZE - 1))
+
+/* a demand load accessed ADDR with latency LAT, count it as a useful
+   prefetch if runahead brought the block in and the load was spared the
+   L2 miss */
 static void
-ruu_dispatch(void)
+ra_prefetch_used(md_addr_t addr, unsigned int lat)
 {
-  int i;
-  int n_dispatched;			/* total insts dispatched */
-  md_inst_t inst;			/* actual instruction bits */
-  enum md_opcode op;			/* decoded opcode enum */
-  int out1, out2, in1, in2, in3;	/* output/input register names */
-  md_addr_t target_PC;			/* actual next/target PC address */
-  md_addr_t addr;			/* effective address, if load/store */
-  struct RUU_station *rs;		/* RUU station being allocated */
-  struct RUU_station *lsq;		/* LSQ station for ld/st's */
-  struct bpred_update_t *dir_update_ptr;/* branch predictor dir update ptr */
-  int stack_recover_idx;		/* bpred retstack recovery index */
-  unsigned int pseq;			/* pipetrace sequence number */
-  int is_write;				/* store? */
-  int made_check;			/* used to ensure DLite entry */
+  md_addr_t blk = addr & ~cache_dl1->blk_mask;
+  md_addr_t *ent = &ra_pft[RA_PFT_INDEX(blk)];
+
+  if (*ent == blk)
+    {
+      if (lat <= ra_miss_lat)
+	ra_useful_prefetches++;
+      *ent = 0;
+    }
+}
+
+/* the load blocking commit with the window full after an L2 miss, or NULL */
+static struct RUU_station *
+ra_blocking_load(void)
+{
+  struct RUU_station *rs;
+
+  if (LSQ_num == 0
+      || (RUU_num < RUU_size && LSQ_num < LSQ_size)
+      || !RUU[RUU_head].ea_comp)
+    return NULL;
+
+  rs = &LSQ[LSQ_head];
+  if (!(MD_OP_FLAGS(rs->op) & F_LOAD)
+      || !rs->issued || rs->completed || rs->mem_lat <= ra_miss_lat)
+    return NULL;
+  return rs;
+}
+
+/* mark the results of the NUM insts from HEAD of queue Q (of SIZE entries)
+   that are still in flight as INV */
+static void
+ra_mark_inflight(struct RUU_station *q, int head, int num, int size)
+{
+  int i, j;
+
+  for (i = head; num > 0; i = (i + 1) % size, num--)
+    {
+      if (q[i].completed)
+	continue;
+      for (j = 0; j < MAX_ODEPS; j++)
+	if (q[i].onames[j] != NA && q[i].onames[j] < MD_TOTAL_REGS)
+	  ra_inv[q[i].onames[j]] = TRUE;
+    }
+}
+
+/* checkpoint the register state and start running ahead of load RS */
+static void
+runahead_enter(struct RUU_station *rs)
+{
+  ra_load = rs;
+  ra_load_seq = rs->seq;
+  ra_PC = ra_next_PC;
+  ra_stopped = FALSE;
+  ra_episodes++;
+
+  spec_levels_reserve(0, 0);
+  memcpy(&spec_regs_R[0][0], &regs.regs_R, sizeof(md_gpr_t));
+  memcpy(&spec_regs_F[0][0], &regs.regs_F, sizeof(md_fpr_t));
+  memcpy(&spec_regs_C[0][0], &regs.regs_C, sizeof(md_ctrl_t));
+
+  /* values still being computed in the window are unknown to runahead,
+     this covers the blocking load and everything waiting on it */
+  memset(ra_inv, 0, sizeof(ra_inv));
+  ra_mark_inflight(RUU, RUU_head, RUU_num, RUU_size);
+  ra_mark_inflight(LSQ, LSQ_head, LSQ_num, LSQ_size);
+}
+
+/* end the episode, restoring the checkpointed (non-speculative) state */
+static void
+runahead_exit(void)
+{
+  ra_load = NULL;
+  tracer_reset_spec();
+}
+
+/* execute up to a decode width of runahead insts */
+static void
+runahead_step(void)
+{
+  int n, i, inv;
+  int ra_in[MAX_IDEPS], ra_out[MAX_ODEPS];
+  md_inst_t inst;			/* actual instruction bits */
+  enum md_opcode op;			/* decoded opcode enum */
+  md_addr_t target_PC;			/* actual next/target PC address */
+  md_addr_t addr;			/* effective address, if load/store */
+  md_addr_t save_PC, save_NPC;		/* dispatch's PC scratch state */
+  md_addr_t blk;
+  unsigned int lat;
+  byte_t temp_byte = 0;			/* temp variable for spec mem access */
+  half_t temp_half = 0;			/* " ditto " */
+  word_t temp_word = 0;			/* " ditto " */
+#ifdef HOST_HAS_QWORD
+  qword_t temp_qword = 0;		/* " ditto " */
+#endif /* HOST_HAS_QWORD */
+  enum md_fault_type fault;
+  int spec_mode = TRUE;
+  int spec_level = 0;
+  int curr_thread_id = 0;
+
+  save_PC = regs.regs_PC;
+  save_NPC = regs.regs_NPC;
+  cache_wrong_path = TRUE;
+  for (n = 0; n < ruu_decode_width && !ra_stopped; n++)
+    {
+      if (ra_PC < ld_text_base || ra_PC >= ld_text_base + ld_text_size
+	  || (ra_PC & (sizeof(md_inst_t) - 1)) != 0)
+	{
+	  ra_stopped = TRUE;
+	  ra_path_stops++;
+	  break;
+	}
+
+      /* runahead insts are fetched through the I-cache */
+      if (cache_il1)
+	cache_access(cache_il1, Read, IACOMPRESS(ra_PC),
+		     NULL, ISCOMPRESS(sizeof(md_inst_t)), sim_cycle,
+		     NULL, NULL);
+      MD_FETCH_INST(inst, mem, ra_PC);
+      MD_SET_OPCODE(op, inst);
+
+      /* traps and system calls end the runahead path */
+      if (MD_OP_FLAGS(op) & F_TRAP)
+	{
+	  ra_stopped = TRUE;
+	  ra_path_stops++;
+	  break;
+	}
+
+      ci_inst_deps(inst, ra_in, ra_out);
+      for (inv = FALSE, i = 0; i < MAX_IDEPS; i++)
+	if (ra_in[i] != NA && ra_inv[ra_in[i]])
+	  inv = TRUE;
+
+      /* an INV indirect jump leaves runahead without a path */
+      if (inv && (MD_OP_FLAGS(op) & F_INDIRJMP))
+	{
+	  ra_stopped = TRUE;
+	  ra_path_stops++;
+	  break;
+	}
+
+      ra_insts++;
+      regs.regs_PC = ra_PC;
+      regs.regs_NPC = ra_PC + sizeof(md_inst_t);
+
+      /* INV sources give INV results, memory ops with INV sources are
+	 dropped */
+      if (inv && !(MD_OP_FLAGS(op) & F_CTRL))
+	{
+	  ra_inv_insts++;
+	  for (i = 0; i < MAX_ODEPS; i++)
+	    if (ra_out[i] != NA)
+	      ra_inv[ra_out[i]] = TRUE;
+	  ra_PC = regs.regs_NPC;
+	  continue;
+	}
+
+      /* maintain $r0 semantics */
+      spec_regs_R[0][0][MD_REG_ZERO] = 0;
+#ifdef TARGET_ALPHA
+      spec_regs_F[0][0].d[MD_REG_ZERO] = 0.0;
+#endif /* TARGET_ALPHA */
+
+      addr = 0;
+      target_PC = regs.regs_NPC;
+      fault = md_fault_none;
+
+      switch (op)
+	{
+#define DEFINST(OP,MSK,NAME,OPFORM,RES,CLASS,O1,O2,I1,I2,I3)		\
+	case OP:							\
+	  SYMCAT(OP,_IMPL);						\
+	  break;
+#define DEFLINK(OP,MSK,NAME,MASK,SHIFT)					\
+	case OP:							\
+	  op = MD_NOP_OP;						\
+	  break;
+#define CONNECT(OP)
+#undef DECLARE_FAULT
+#define DECLARE_FAULT(FAULT)						\
+	  { fault = (FAULT); break; }
+#include "machine.def"
+#undef DECLARE_FAULT
+	default:
+	  op = MD_NOP_OP;
+	}
+      /* faults are masked on the runahead path, as on any spec path */
+      (void)fault;
+
+      if (inv)
+	{
+	  /* INV conditional branch: backward taken, forward not taken */
+	  ra_inv_insts++;
+	  regs.regs_NPC = (target_PC < regs.regs_PC
+			   ? target_PC : regs.regs_PC + sizeof(md_inst_t));
+	}
+      else
+	{
+	  for (i = 0; i < MAX_ODEPS; i++)
+	    if (ra_out[i] != NA)
+	      ra_inv[ra_out[i]] = FALSE;
+	}
+
+      /* loads prefetch into the data cache, values of loads that miss in
+	 the L2 would not return in time and are INV */
+      if ((MD_OP_FLAGS(op) & F_LOAD) && MD_VALID_ADDR(addr))
+	{
+	  ra_loads++;
+	  lat = cache_access(cache_dl1, Read, (addr & ~3), NULL, 4,
+			     sim_cycle, NULL, NULL);
+	  if (dtlb)
+	    lat = MAX(lat, cache_access(dtlb, Read, (addr & ~3), NULL, 4,
+					sim_cycle, NULL, NULL));
+	  if (lat > cache_dl1_lat)
+	    {
+	      ra_prefetches++;
+	      blk = addr & ~cache_dl1->blk_mask;
+	      ra_pft[RA_PFT_INDEX(blk)] = blk;
+	    }
+	  if (lat > ra_miss_lat)
+	    for (i = 0; i < MAX_ODEPS; i++)
+	      if (ra_out[i] != NA)
+		ra_inv[ra_out[i]] = TRUE;
+	}
+
+      ra_PC = regs.regs_NPC;
+    }
+  cache_wrong_path = FALSE;
+  regs.regs_PC = save_PC;
+  regs.regs_NPC = save_NPC;
+}
+
+/* runahead mode, called each cycle before dispatch: starts, advances and
+   ends runahead episodes */
+static void
+runahead_cycle(void)
+{
+  struct RUU_station *rs;
+
+  if (ra_load)
+    {
+      if (!ra_load->completed && ra_load->seq == ra_load_seq)
+	{
+	  ra_cycles++;
+	  runahead_step();
+	  return;
+	}
+      runahead_exit();
+    }
+
+  if (!thread_states[0].spec_mode && (rs = ra_blocking_load()) != NULL)
+    {
+      runahead_enter(rs);
+      ra_cycles++;
+      runahead_step();
+    }
+}
+
+
+/* dispatch instructions from the IFETCH -> DISPATCH queue: instructions are
+   first decoded, then they allocated RUU (and LSQ for load/stores) resources
+   and input and output dependence chains are updated accordingly */
+static void
+ruu_dispatch(void)
+{
+  int i;
+  int n_dispatched;			/* total insts dispatched */
+  md_inst_t inst;			/* actual instruction bits */
+  enum md_opcode op;			/* decoded opcode enum */
+  int out1, out2, in1, in2, in3;	/* output/input register names */
+  md_addr_t target_PC;			/* actual next/target PC address */
+  md_addr_t addr;			/* effective address, if load/store */
+  struct RUU_station *rs;		/* RUU station being allocated */
+  struct RUU_station *lsq;		/* LSQ station for ld/st's */
+  struct bpred_update_t *dir_update_ptr;/* branch predictor dir update ptr */
+  int stack_recover_idx;		/* bpred retstack recovery index */
+  unsigned int pseq;			/* pipetrace sequence number */
+  int is_write;				/* store? */
+  int made_check;			/* used to ensure DLite entry */
   int br_taken, br_pred_taken;		/* if br, taken?  predicted taken? */
-  int fetch_redirected = FALSE;
+  int fetch_redirected;
+  int ci_in[MAX_IDEPS], ci_out[MAX_ODEPS];/* register names, for ci_dispatch() */
+  int ci_reuse;				/* result reused past reconvergence? */
   byte_t temp_byte = 0;			/* temp variable for spec mem access */
   half_t temp_half = 0;			/* " ditto " */
   word_t temp_word = 0;			/* " ditto " */
@@ -4104,16 +6792,14 @@ ruu_dispatch(void)
 	  /* stall until last operation is ready to issue */
 	  break;
 	}
-      if (fetch_data[fetch_head].squashed == TRUE) {
-        fetch_head = (fetch_head+1) & (ruu_ifq_size - 1);
-        fetch_num--;
-        continue;
-      }
-
-      int curr_thread_id = fetch_data[fetch_head].thread_id;
+      int curr_thread_id = THREAD_ID(fetch_data[fetch_head].thread_id);
       int spec_mode = thread_states[curr_thread_id].spec_mode;
       int spec_level = thread_states[curr_thread_id].spec_level;
 
+      /* a mis-fetch only excuses the instruction that caused it, later
+	 instructions in the IFQ may belong to other eager threads */
+      fetch_redirected = FALSE;
+
       /* get the next instruction from the IFETCH -> DISPATCH queue */
       inst = fetch_data[fetch_head].IR;
       regs.regs_PC = fetch_data[fetch_head].regs_PC;
@@ -4129,6 +6815,14 @@ ruu_dispatch(void)
       /* compute default next PC */
       regs.regs_NPC = regs.regs_PC + sizeof(md_inst_t);
 
+      /* stall while the thread holds its full share of the RUU/LSQ */
+      if (op != MD_NOP_OP
+	  && window_thread_full(curr_thread_id, (MD_OP_FLAGS(op) & F_MEM)))
+	{
+	  window_thread_stalls++;
+	  break;
+	}
+
       /* drain RUU for TRAPs and system calls */
       if (MD_OP_FLAGS(op) & F_TRAP)
 	{
@@ -4142,9 +6836,11 @@ ruu_dispatch(void)
 	}
 
       /* maintain $r0 semantics (in spec and non-spec space) */
-      regs.regs_R[MD_REG_ZERO] = 0; spec_regs_R[curr_thread_id][spec_level][MD_REG_ZERO] = 0;
+      regs.regs_R[MD_REG_ZERO] = 0;
+      if (spec_mode) spec_regs_R[curr_thread_id][spec_level][MD_REG_ZERO] = 0;
 #ifdef TARGET_ALPHA
-      regs.regs_F.d[MD_REG_ZERO] = 0.0; spec_regs_F[curr_thread_id][spec_level].d[MD_REG_ZERO] = 0.0;
+      regs.regs_F.d[MD_REG_ZERO] = 0.0;
+      if (spec_mode) spec_regs_F[curr_thread_id][spec_level].d[MD_REG_ZERO] = 0.0;
 #endif /* TARGET_ALPHA */
 
       if (!spec_mode)
@@ -4218,6 +6914,10 @@ ruu_dispatch(void)
 	fatal("Num insn (%d) non-speculative fault (%d) for thread (%d) detected @ 0x%08p",
 	      sim_num_insn, fault, curr_thread_id, regs.regs_PC);
 
+      /* runahead picks up after the last non-speculative inst */
+      if (!spec_mode)
+	ra_next_PC = regs.regs_NPC;
+
         if (sim_num_insn == 384) {
           //fatal("Breaking for testing purposed");
         }
@@ -4254,14 +6954,14 @@ ruu_dispatch(void)
              This is just like calling fetch_squash() except we pre-anticipate
              the updates to the fetch values at the end of this function.  If
              case #2, also charge a mispredict penalty for redirecting fetch */
-	  thread_states[curr_thread_id].fetch_pred_PC = thread_states[curr_thread_id].fetch_regs_PC = regs.regs_NPC;
+	  fetch_redirect(curr_thread_id, regs.regs_NPC);
 	  /* was: if (pred_perfect) */
 	  if (pred_perfect)
 	    pred_PC[curr_thread_id] = regs.regs_NPC;
 
-	  fetch_head = (ruu_ifq_size-1);
-	  fetch_num = 1;
-	  fetch_tail = 0;
+	  fetchq_flush_thread(curr_thread_id);
+	  if (!spec_mode)
+	    cpi_fe_event(cc_bpred);
 
 	  if (!pred_perfect)
 	    ruu_fetch_issue_delay = ruu_branch_penalty;
@@ -4309,11 +7009,26 @@ ruu_dispatch(void)
 	  rs->seq = ++inst_seq;
 	  rs->queued = rs->issued = rs->completed = FALSE;
 	  rs->ptrace_seq = pseq;
+	  rs->mem_lat = 0;
     rs->thread_id = curr_thread_id;
     rs->squashed = FALSE;
     rs->fork_counter = thread_states[curr_thread_id].fork_counter;
     rs->triggers_fork = FALSE;
 
+	  /* non-speculative results are final, record them for commit */
+	  if (!spec_mode)
+	    lockstep_rec_fill(&rs->cmt, &regs, mem, out1, out2,
+			      (MD_OP_FLAGS(op) & F_MEM) ? addr : 0, is_write);
+
+	  /* the RUU has refilled past the last front-end event */
+	  if (!spec_mode && (int)(pseq - cpi_fe_seq) >= 0)
+	    cpi_fe_cause = cc_frontend;
+
+	  /* control-independent work kept from a squashed path? */
+	  ci_in[0] = in1; ci_in[1] = in2; ci_in[2] = in3;
+	  ci_out[0] = out1; ci_out[1] = out2;
+	  ci_reuse = ci_dispatch(curr_thread_id, rs->PC, op, ci_in, ci_out);
+
 	  /* split ld/st's into two operations: eff addr comp + mem access */
 	  if (MD_OP_FLAGS(op) & F_MEM)
 	    {
@@ -4341,13 +7056,17 @@ ruu_dispatch(void)
 	      lsq->seq = ++inst_seq;
 	      lsq->queued = lsq->issued = lsq->completed = FALSE;
 	      lsq->ptrace_seq = ptrace_seq++;
+	      lsq->mem_lat = 0;
         lsq->thread_id = curr_thread_id;
         lsq->squashed = FALSE;
         lsq->fork_counter = thread_states[curr_thread_id].fork_counter;
         lsq->triggers_fork = FALSE;
+	      lsq->ssdep = lsq->viol_st = NULL;
+	      lsq->ldwait = FALSE;
 
 	      /* pipetrace this uop */
-	      ptrace_newuop(lsq->ptrace_seq, "internal ld/st", lsq->PC, 0);
+	      ptrace_newuop(lsq->ptrace_seq, "internal ld/st", lsq->PC, 0,
+			    lsq->thread_id, lsq->fork_counter, lsq->spec_level);
 	      ptrace_newstage(lsq->ptrace_seq, PST_DISPATCH, 0);
 
 	      /* link eff addr computation onto operand's output chains */
@@ -4378,6 +7097,17 @@ ruu_dispatch(void)
 	      RUU_num++;
 	      LSQ_tail = (LSQ_tail + 1) % LSQ_size;
 	      LSQ_num++;
+	      LSQ_allocs++;
+	      thread_states[curr_thread_id].RUU_num++;
+	      thread_states[curr_thread_id].LSQ_num++;
+
+	      /* stores are visible to later loads through the STA table */
+	      if ((MD_OP_FLAGS(op) & (F_MEM|F_STORE)) == (F_MEM|F_STORE))
+		sta_insert(lsq);
+
+	      /* consult/update the store sets */
+	      if (memdep_policy == md_storeset)
+		storeset_dispatch(lsq);
 
 	      if (OPERANDS_READY(rs))
 		{
@@ -4395,13 +7125,15 @@ ruu_dispatch(void)
 		  /* put operation on ready list, ruu_issue() issue it later */
 		  readyq_enqueue(lsq);
 		}
+	      else if (OPERANDS_READY(lsq))
+		ldwait_insert(lsq);
 	    }
 	  else /* !(MD_OP_FLAGS(op) & F_MEM) */
 	    {
-	      /* link onto producing operation */
-	      ruu_link_idep(rs, /* idep_ready[] index */0, in1);
-	      ruu_link_idep(rs, /* idep_ready[] index */1, in2);
-	      ruu_link_idep(rs, /* idep_ready[] index */2, in3);
+	      /* link onto producing operation, a reused result needs none */
+	      ruu_link_idep(rs, /* idep_ready[] index */0, ci_reuse ? NA : in1);
+	      ruu_link_idep(rs, /* idep_ready[] index */1, ci_reuse ? NA : in2);
+	      ruu_link_idep(rs, /* idep_ready[] index */2, ci_reuse ? NA : in3);
 
 	      /* install output after inputs to prevent self reference */
 	      ruu_install_odep(rs, /* odep_list[] index */0, out1);
@@ -4411,9 +7143,18 @@ ruu_dispatch(void)
 	      n_dispatched++;
 	      RUU_tail = (RUU_tail + 1) % RUU_size;
 	      RUU_num++;
+	      thread_states[curr_thread_id].RUU_num++;
 
+	      if (ci_reuse)
+		{
+		  /* result kept from the squashed path, write it back next
+		     cycle without using a functional unit */
+		  rs->issued = TRUE;
+		  eventq_queue_event(rs, sim_cycle + 1);
+		  last_op = RSLINK_NULL;
+		}
 	      /* issue op if all its reg operands are ready (no mem input) */
-	      if (OPERANDS_READY(rs))
+	      else if (OPERANDS_READY(rs))
 		{
 		  /* put operation on ready list, ruu_issue() issue it later */
 		  readyq_enqueue(rs);
@@ -4472,6 +7213,7 @@ ruu_dispatch(void)
         thread_states[curr_thread_id].spec_mode = TRUE;
         thread_states[curr_thread_id].spec_level = 0;
         spec_level = 0;
+        spec_levels_reserve(curr_thread_id, spec_level);
         memcpy(spec_create_vector[curr_thread_id][spec_level], create_vector,
   			 MD_TOTAL_REGS * sizeof(struct CV_link));
   		  memcpy(spec_create_vector_rt[curr_thread_id][spec_level],
@@ -4490,6 +7232,7 @@ ruu_dispatch(void)
 	      /* entering mis-speculation mode, indicate this and save PC */
         spec_level++;
         thread_states[curr_thread_id].spec_level = spec_level;
+        spec_levels_reserve(curr_thread_id, spec_level);
         memcpy(spec_create_vector[curr_thread_id][spec_level], spec_create_vector[curr_thread_id][spec_level-1],
   			 MD_TOTAL_REGS * sizeof(struct CV_link));
   		  memcpy(spec_create_vector_rt[curr_thread_id][spec_level],
@@ -4520,7 +7263,7 @@ ruu_dispatch(void)
       if (op == MD_NOP_OP)
 	{
 	  /* end of the line */
-	  ptrace_endinst(pseq);
+	  ptrace_endinst(pseq, PEND_NOP);
 	}
 
       /* update any stats tracked by PC */
@@ -4566,6 +7309,11 @@ ruu_dispatch(void)
  *  RUU_FETCH() - instruction fetch pipeline stage(s)
  */
 
+/* I-cache bank state, records the block each bank delivered this cycle, a
+   second (different) block mapping to the same bank is a bank conflict */
+static md_addr_t *ifetch_bank_blk = NULL;
+static tick_t *ifetch_bank_cycle = NULL;
+
 /* initialize the instruction fetch pipeline stage */
 static void
 fetch_init(void)
@@ -4580,6 +7328,14 @@ fetch_init(void)
   fetch_tail = fetch_head = 0;
   IFQ_count = 0;
   IFQ_fcount = 0;
+
+  if (fetch_ibanks)
+    {
+      ifetch_bank_blk = calloc(fetch_ibanks, sizeof(md_addr_t));
+      ifetch_bank_cycle = calloc(fetch_ibanks, sizeof(tick_t));
+      if (!ifetch_bank_blk || !ifetch_bank_cycle)
+	fatal("out of virtual memory");
+    }
 }
 
 /* dump contents of fetch stage registers and fetch queue */
@@ -4622,15 +7378,304 @@ fetch_dump(FILE *stream)			/* output stream */
 static int last_inst_missed = FALSE;
 static int last_inst_tmissed = FALSE;
 
+/* fetch outcomes for a single instruction */
+enum fetch_result_t {
+  fr_fetched,			/* instruction is in the IFQ */
+  fr_taken,			/* instruction is in the IFQ, pred taken */
+  fr_stalled			/* I-cache/I-TLB miss or I-cache bank conflict */
+};
+
+/* read the fetch block containing PC on behalf of THREAD, one I-cache (and
+   I-TLB) access is made per fetch block per cycle, later instructions from the
+   same block are delivered from the fetch buffer; returns the access latency,
+   or zero if the block's I-cache bank is busy with another block this cycle */
+static unsigned int
+fetch_block_access(int thread,			/* fetching thread */
+		   md_addr_t pc)		/* fetch address */
+{
+  struct thread_state *ts = &thread_states[thread];
+  md_addr_t blk;
+  unsigned int lat, tlb_lat;
+
+  blk = IACOMPRESS(pc);
+  if (cache_il1)
+    blk &= ~cache_il1->blk_mask;
+
+  /* remainder of a block read this cycle comes out of the fetch buffer */
+  if (ts->fetch_blk_cycle == sim_cycle && ts->fetch_blk == blk)
+    return cache_il1_lat;
+
+  if (fetch_ibanks)
+    {
+      int bank = (blk >> cache_il1->set_shift) & (fetch_ibanks - 1);
+
+      if (ifetch_bank_cycle[bank] == sim_cycle && ifetch_bank_blk[bank] != blk)
+	{
+	  /* bank is delivering a different block this cycle */
+	  fetch_bank_conflicts++;
+	  return 0;
+	}
+      ifetch_bank_cycle[bank] = sim_cycle;
+      ifetch_bank_blk[bank] = blk;
+    }
+
+  /* fetch only knows a thread is off the correct path once the thread's
+     mis-predicted branch has been dispatched */
+  cache_wrong_path = ts->spec_mode;
+
+  lat = cache_il1_lat;
+  if (cache_il1)
+    {
+      /* access the I-cache */
+      lat =
+	cache_access(cache_il1, Read, IACOMPRESS(pc),
+		     NULL, ISCOMPRESS(sizeof(md_inst_t)), sim_cycle,
+		     NULL, NULL);
+      if (lat > cache_il1_lat)
+	last_inst_missed = TRUE;
+    }
+
+  if (itlb)
+    {
+      /* access the I-TLB, NOTE: this code will initiate
+	 speculative TLB misses */
+      tlb_lat =
+	cache_access(itlb, Read, IACOMPRESS(pc),
+		     NULL, ISCOMPRESS(sizeof(md_inst_t)), sim_cycle,
+		     NULL, NULL);
+      if (tlb_lat > 1)
+	last_inst_tmissed = TRUE;
+
+      /* I-cache/I-TLB accesses occur in parallel */
+      lat = MAX(tlb_lat, lat);
+    }
+  cache_wrong_path = FALSE;
+  fetch_blocks++;
+
+  /* only a hit leaves the block in the fetch buffer */
+  if (lat == cache_il1_lat)
+    {
+      ts->fetch_blk = blk;
+      ts->fetch_blk_cycle = sim_cycle;
+    }
+  return lat;
+}
+
+/* fetch the next instruction of THREAD into the IFETCH -> DISPATCH queue */
+static enum fetch_result_t
+fetch_one_inst(int thread)			/* fetching thread */
+{
+  struct thread_state *ts = &thread_states[thread];
+  enum fetch_result_t res = fr_fetched;
+  unsigned int lat;
+  md_inst_t inst;
+  int stack_recover_idx;
+
+  /* fetch an instruction at the next predicted fetch address */
+  ts->fetch_regs_PC = ts->fetch_pred_PC;
+
+  /* is this a bogus text address? (can happen on mis-spec path) */
+  if (ld_text_base <= ts->fetch_regs_PC
+      && ts->fetch_regs_PC < (ld_text_base+ld_text_size)
+      && !(ts->fetch_regs_PC & (sizeof(md_inst_t)-1)))
+    {
+      /* read instruction from memory */
+      MD_FETCH_INST(inst, mem, ts->fetch_regs_PC);
+
+      /* address is within program text, read instruction from memory */
+      lat = fetch_block_access(thread, ts->fetch_regs_PC);
+      if (!lat)
+	{
+	  /* I-cache bank conflict, retry next cycle */
+	  return fr_stalled;
+	}
+
+      /* I-cache/I-TLB miss? assumes I-cache hit >= I-TLB hit */
+      if (lat != cache_il1_lat)
+	{
+	  /* I-cache miss, block fetch until it is resolved, only the missing
+	     thread blocks when several threads fetch each cycle */
+	  if (!ts->spec_mode)
+	    cpi_fe_event(cc_icache);
+	  if (fetch_threads > 1)
+	    ts->fetch_resume = sim_cycle + lat;
+	  else
+	    ruu_fetch_issue_delay += lat - 1;
+	  return fr_stalled;
+	}
+      /* else, I-cache/I-TLB hit */
+    }
+  else
+    {
+      /* fetch PC is bogus, send a NOP down the pipeline */
+      inst = MD_NOP_INST;
+    }
+
+  /* have a valid inst, here */
+
+  /* possibly use the BTB target */
+  if (pred)
+    {
+      enum md_opcode op;
+
+      /* pre-decode instruction, used for bpred stats recording */
+      MD_SET_OPCODE(op, inst);
+
+      /* get the next predicted fetch address; only use branch predictor
+	 result for branches (assumes pre-decode bits); NOTE: returned
+	 value may be 1 if bpred can only predict a direction */
+      bpred_wrong_path = ts->spec_mode;
+      if (MD_OP_FLAGS(op) & F_CTRL)
+	ts->fetch_pred_PC =
+	  bpred_lookup(pred,
+		       /* branch address */ts->fetch_regs_PC,
+		       /* target address *//* FIXME: not computed */0,
+		       /* opcode */op,
+		       /* call? */MD_IS_CALL(op),
+		       /* return? */MD_IS_RETURN(op),
+		       /* updt */&(fetch_data[fetch_tail].dir_update),
+		       /* RSB index */&stack_recover_idx);
+      else
+	ts->fetch_pred_PC = 0;
+      bpred_wrong_path = FALSE;
+
+      /* valid address returned from branch predictor? */
+      if (!ts->fetch_pred_PC)
+	{
+	  /* no predicted taken target, attempt not taken target */
+	  ts->fetch_pred_PC = ts->fetch_regs_PC + sizeof(md_inst_t);
+	}
+      else
+	{
+	  /* go with target, NOTE: discontinuous fetch */
+	  res = fr_taken;
+	}
+    }
+  else
+    {
+      /* no predictor, just default to predict not taken, and
+	 continue fetching instructions linearly */
+      ts->fetch_pred_PC = ts->fetch_regs_PC + sizeof(md_inst_t);
+    }
+
+  /* commit this instruction to the IFETCH -> DISPATCH queue */
+  fetch_data[fetch_tail].IR = inst;
+  fetch_data[fetch_tail].regs_PC = ts->fetch_regs_PC;
+  fetch_data[fetch_tail].pred_PC = ts->fetch_pred_PC;
+  fetch_data[fetch_tail].stack_recover_idx = stack_recover_idx;
+  fetch_data[fetch_tail].ptrace_seq = ptrace_seq++;
+  fetch_data[fetch_tail].squashed = FALSE;
+  fetch_data[fetch_tail].thread_id = thread;
+
+  /* for pipe trace */
+  ptrace_newinst(fetch_data[fetch_tail].ptrace_seq,
+		 inst, fetch_data[fetch_tail].regs_PC,
+		 0, thread, ts->fork_counter, ts->spec_level);
+  ptrace_newstage(fetch_data[fetch_tail].ptrace_seq,
+		  PST_IFETCH,
+		  ((last_inst_missed ? PEV_CACHEMISS : 0)
+		   | (last_inst_tmissed ? PEV_TLBMISS : 0)));
+  last_inst_missed = FALSE;
+  last_inst_tmissed = FALSE;
+
+  /* adjust instruction fetch queue */
+  fetch_tail = (fetch_tail + 1) & (ruu_ifq_size - 1);
+  fetch_num++;
+  fetch_total_insn++;
+
+  return res;
+}
+
+/* fetch one fetch block from each of up to FETCH_THREADS eager threads, the
+   threads are visited round-robin and share the fetch bandwidth; each thread
+   stops at the end of its fetch block, at a predicted taken branch, or when
+   its block cannot be read this cycle */
+static void
+ruu_fetch_multi(void)
+{
+  int i, t, n_fetched, n_threads, n_active, branch_cnt, thread_start;
+  md_addr_t blk;
+  enum fetch_result_t res;
+
+  n_fetched = 0;
+  n_threads = 0;
+  n_active = 0;
+  for (i=1;
+       i <= max_threads
+       && n_threads < fetch_threads
+       && n_fetched < (ruu_decode_width * fetch_speed)
+       && fetch_num < ruu_ifq_size;
+       i++)
+    {
+      t = (current_fetching_thread + i) % max_threads;
+      if (!thread_states[t].in_use
+	  || !thread_states[t].keep_fetching
+	  || thread_states[t].fetch_resume > sim_cycle)
+	continue;
+      if (window_thread_full(t, TRUE))
+	{
+	  /* thread holds its share of the window, fetch others */
+	  window_fetch_gated++;
+	  continue;
+	}
+
+      blk = IACOMPRESS(thread_states[t].fetch_pred_PC);
+      if (cache_il1)
+	blk &= ~cache_il1->blk_mask;
+
+      thread_start = n_fetched;
+      for (branch_cnt=0;
+	   n_fetched < (ruu_decode_width * fetch_speed)
+	   && fetch_num < ruu_ifq_size;
+	   n_fetched++)
+	{
+	  res = fetch_one_inst(t);
+	  if (res == fr_stalled)
+	    break;
+	  if (res == fr_taken && ++branch_cnt >= fetch_speed)
+	    {
+	      n_fetched++;
+	      break;
+	    }
+
+	  /* fetch block ends at the I-cache block boundary */
+	  if (cache_il1
+	      && ((IACOMPRESS(thread_states[t].fetch_pred_PC)
+		   & ~cache_il1->blk_mask) != blk))
+	    {
+	      n_fetched++;
+	      break;
+	    }
+	}
+
+      /* a thread that stalled on its first instruction took a fetch slot,
+	 but is not one of the threads that fetched this cycle */
+      n_threads++;
+      if (n_fetched > thread_start)
+	n_active++;
+    }
+
+  /* rotate fetch priority for the next cycle */
+  current_fetching_thread = (current_fetching_thread + 1) % max_threads;
+
+  stat_add_sample(fetch_threads_dist, n_active);
+}
+
 /* fetch up as many instruction as one branch prediction and one cache line
    acess will support without overflowing the IFETCH -> DISPATCH QUEUE */
 static void
 ruu_fetch(void)
 {
-  int i, lat, tlb_lat, done = FALSE;
-  md_inst_t inst;
-  int stack_recover_idx;
-  int branch_cnt;
+  int i, done = FALSE;
+  int branch_cnt, n_gated = 0;
+  enum fetch_result_t res;
+
+  if (fetch_threads > 1)
+    {
+      /* several eager paths fetch each cycle */
+      ruu_fetch_multi();
+      return;
+    }
 
   for (i=0, branch_cnt=0;
        /* fetch up to as many instruction as the DISPATCH stage can decode */
@@ -4639,10 +7684,10 @@ ruu_fetch(void)
        && fetch_num < ruu_ifq_size
        /* and no IFETCH blocking condition encountered */
        && !done;
-       i++)
+       /* i is advanced per fetched instruction, below */)
     {
       // If we've reached our quota of fetches for this thread, find the next thread to run
-      if (fetches_left_for_thread == 0 || thread_states[current_fetching_thread].in_use == FALSE || thread_states[current_fetching_thread].keep_fetching == FALSE) {
+      if (max_threads > 1 && (fetches_left_for_thread == 0 || thread_states[current_fetching_thread].in_use == FALSE || thread_states[current_fetching_thread].keep_fetching == FALSE)) {
         int has_found_new_thread = FALSE;
         current_fetching_thread++;
         while ((has_found_new_thread == FALSE) && (current_fetching_thread < max_threads)) {
@@ -4667,132 +7712,29 @@ ruu_fetch(void)
         //fprintf(stderr, "current fetching thread: %d\n", current_fetching_thread);
         fetches_left_for_thread = max_fetches_before_switch;
       }
-      fetches_left_for_thread--;
-
-      /* fetch an instruction at the next predicted fetch address */
-      thread_states[current_fetching_thread].fetch_regs_PC = thread_states[current_fetching_thread].fetch_pred_PC;
-
-      /* is this a bogus text address? (can happen on mis-spec path) */
-      if (ld_text_base <= thread_states[current_fetching_thread].fetch_regs_PC
-	  && thread_states[current_fetching_thread].fetch_regs_PC < (ld_text_base+ld_text_size)
-	  && !(thread_states[current_fetching_thread].fetch_regs_PC & (sizeof(md_inst_t)-1)))
+      if (window_thread_full(THREAD_ID(current_fetching_thread), TRUE))
 	{
-	  /* read instruction from memory */
-	  MD_FETCH_INST(inst, mem, thread_states[current_fetching_thread].fetch_regs_PC);
-
-	  /* address is within program text, read instruction from memory */
-	  lat = cache_il1_lat;
-	  if (cache_il1)
-	    {
-	      /* access the I-cache */
-	      lat =
-		cache_access(cache_il1, Read, IACOMPRESS(thread_states[current_fetching_thread].fetch_regs_PC),
-			     NULL, ISCOMPRESS(sizeof(md_inst_t)), sim_cycle,
-			     NULL, NULL);
-	      if (lat > cache_il1_lat)
-		last_inst_missed = TRUE;
-	    }
-
-	  if (itlb)
-	    {
-	      /* access the I-TLB, NOTE: this code will initiate
-		 speculative TLB misses */
-	      tlb_lat =
-		cache_access(itlb, Read, IACOMPRESS(thread_states[current_fetching_thread].fetch_regs_PC),
-			     NULL, ISCOMPRESS(sizeof(md_inst_t)), sim_cycle,
-			     NULL, NULL);
-	      if (tlb_lat > 1)
-		last_inst_tmissed = TRUE;
-
-	      /* I-cache/I-TLB accesses occur in parallel */
-	      lat = MAX(tlb_lat, lat);
-	    }
-
-	  /* I-cache/I-TLB miss? assumes I-cache hit >= I-TLB hit */
-	  if (lat != cache_il1_lat)
-	    {
-	      /* I-cache miss, block fetch until it is resolved */
-	      ruu_fetch_issue_delay += lat - 1;
-	      break;
-	    }
-	  /* else, I-cache/I-TLB hit */
-	}
-      else
-	{
-	  /* fetch PC is bogus, send a NOP down the pipeline */
-	  inst = MD_NOP_INST;
+	  /* thread holds its share of the window, move on to the next one
+	     without using up fetch bandwidth, unless all of them are full */
+	  window_fetch_gated++;
+	  fetches_left_for_thread = 0;
+	  if (++n_gated >= max_threads)
+	    break;
+	  continue;
 	}
+      fetches_left_for_thread--;
+      i++;
 
-      /* have a valid inst, here */
-
-      /* possibly use the BTB target */
-      if (pred)
-	{
-	  enum md_opcode op;
-
-	  /* pre-decode instruction, used for bpred stats recording */
-	  MD_SET_OPCODE(op, inst);
-
-	  /* get the next predicted fetch address; only use branch predictor
-	     result for branches (assumes pre-decode bits); NOTE: returned
-	     value may be 1 if bpred can only predict a direction */
-	  if (MD_OP_FLAGS(op) & F_CTRL)
-	    thread_states[current_fetching_thread].fetch_pred_PC =
-	      bpred_lookup(pred,
-			   /* branch address */thread_states[current_fetching_thread].fetch_regs_PC,
-			   /* target address *//* FIXME: not computed */0,
-			   /* opcode */op,
-			   /* call? */MD_IS_CALL(op),
-			   /* return? */MD_IS_RETURN(op),
-			   /* updt */&(fetch_data[fetch_tail].dir_update),
-			   /* RSB index */&stack_recover_idx);
-	  else
-	    thread_states[current_fetching_thread].fetch_pred_PC = 0;
-
-	  /* valid address returned from branch predictor? */
-	  if (!thread_states[current_fetching_thread].fetch_pred_PC)
-	    {
-	      /* no predicted taken target, attempt not taken target */
-	      thread_states[current_fetching_thread].fetch_pred_PC = thread_states[current_fetching_thread].fetch_regs_PC + sizeof(md_inst_t);
-	    }
-	  else
-	    {
-	      /* go with target, NOTE: discontinuous fetch, so terminate */
-	      branch_cnt++;
-	      if (branch_cnt >= fetch_speed)
-		done = TRUE;
-	    }
-	}
-      else
+      res = fetch_one_inst(THREAD_ID(current_fetching_thread));
+      if (res == fr_stalled)
+	break;
+      if (res == fr_taken)
 	{
-	  /* no predictor, just default to predict not taken, and
-	     continue fetching instructions linearly */
-	  thread_states[current_fetching_thread].fetch_pred_PC = thread_states[current_fetching_thread].fetch_regs_PC + sizeof(md_inst_t);
+	  /* discontinuous fetch, so terminate */
+	  branch_cnt++;
+	  if (branch_cnt >= fetch_speed)
+	    done = TRUE;
 	}
-
-      /* commit this instruction to the IFETCH -> DISPATCH queue */
-      fetch_data[fetch_tail].IR = inst;
-      fetch_data[fetch_tail].regs_PC = thread_states[current_fetching_thread].fetch_regs_PC;
-      fetch_data[fetch_tail].pred_PC = thread_states[current_fetching_thread].fetch_pred_PC;
-      fetch_data[fetch_tail].stack_recover_idx = stack_recover_idx;
-      fetch_data[fetch_tail].ptrace_seq = ptrace_seq++;
-      fetch_data[fetch_tail].squashed = FALSE;
-      fetch_data[fetch_tail].thread_id = current_fetching_thread;
-
-      /* for pipe trace */
-      ptrace_newinst(fetch_data[fetch_tail].ptrace_seq,
-		     inst, fetch_data[fetch_tail].regs_PC,
-		     0);
-      ptrace_newstage(fetch_data[fetch_tail].ptrace_seq,
-		      PST_IFETCH,
-		      ((last_inst_missed ? PEV_CACHEMISS : 0)
-		       | (last_inst_tmissed ? PEV_TLBMISS : 0)));
-      last_inst_missed = FALSE;
-      last_inst_tmissed = FALSE;
-
-      /* adjust instruction fetch queue */
-      fetch_tail = (fetch_tail + 1) & (ruu_ifq_size - 1);
-      fetch_num++;
     }
 }
 
@@ -4878,6 +7820,34 @@ simoo_mstate_obj(FILE *stream,			/* output stream */
 }
 
 
+/* heartbeat host time and instruction count, at the start of timing
+   simulation and at the last heartbeat */
+static double hb_start_time, hb_last_time;
+static counter_t hb_start_insn, hb_last_insn;
+
+/* print a progress heartbeat to stderr if HEARTBEAT_SECS have passed */
+static void
+sim_heartbeat(void)
+{
+  double now = host_nsecs(), kips, avg_kips;
+
+  if (now - hb_last_time < heartbeat_secs * 1e9)
+    return;
+
+  kips = (double)(sim_num_insn - hb_last_insn) / (now - hb_last_time) * 1e6;
+  avg_kips =
+    (double)(sim_num_insn - hb_start_insn) / (now - hb_start_time) * 1e6;
+  myfprintf(stderr, "sim: heartbeat: %n insts, %n cycles, %.1f KIPS "
+	    "(%.1f avg)", sim_num_insn, sim_cycle, kips, avg_kips);
+  if (max_insts && avg_kips > 0.0)
+    fprintf(stderr, ", ETA %s",
+	    elapsed_time((long)((max_insts - sim_num_insn) / avg_kips / 1e3)));
+  fprintf(stderr, "\n");
+
+  hb_last_time = now;
+  hb_last_insn = sim_num_insn;
+}
+
 /* start simulation, program loaded, processor precise state initialized */
 void
 sim_main(void)
@@ -4981,6 +7951,31 @@ sim_main(void)
 
   fprintf(stderr, "sim: ** starting performance simulation **\n");
 
+  /* start writing interval stats, all stats are registered by now */
+  if (interval_size)
+    {
+      if (interval_fname)
+	{
+	  interval_fd = fopen(interval_fname, interval_binary ? "wb" : "w");
+	  if (!interval_fd)
+	    fatal("cannot open interval stats file `%s'", interval_fname);
+	}
+      else
+	interval_fd = stderr;
+      stat_interval = stat_interval_new(sim_sdb, interval_fd, interval_binary);
+      interval_next =
+	((interval_by_cycles ? sim_cycle : sim_num_insn) / interval_size + 1)
+	* interval_size;
+    }
+
+  /* start the progress heartbeat */
+  hb_start_time = hb_last_time = host_nsecs();
+  hb_start_insn = hb_last_insn = sim_num_insn;
+
+  /* the functional core starts from the state timing simulation does */
+  if (lockstep_mode)
+    lockstep_init(&regs, mem);
+
   /* set up timing simulation entry state */
   thread_states[current_fetching_thread].fetch_regs_PC = regs.regs_PC - sizeof(md_inst_t);
   thread_states[current_fetching_thread].fetch_pred_PC = regs.regs_PC;
@@ -4998,6 +7993,15 @@ sim_main(void)
       if (((LSQ_head + LSQ_num) % LSQ_size) != LSQ_tail)
 	panic("LSQ_head/LSQ_tail wedged");
 
+      /* sample host time in this cycle? */
+      if (prof_interval && --prof_countdown == 0)
+	{
+	  prof_countdown = prof_interval;
+	  prof_sample = cache_prof_active = TRUE;
+	  prof_samples++;
+	  prof_cycle_t0 = host_nsecs();
+	}
+
       /* check if pipetracing is still active */
       ptrace_check_active(regs.regs_PC, sim_num_insn, sim_cycle);
 
@@ -5005,7 +8009,7 @@ sim_main(void)
       ptrace_newcycle(sim_cycle);
 
       /* commit entries from RUU/LSQ to architected register file */
-      ruu_commit();
+      PROF_STAGE(ps_commit, ruu_commit());
 
       /* service function unit release events */
       ruu_release_fu();
@@ -5014,37 +8018,41 @@ sim_main(void)
 
       /* service result completions, also readies dependent operations */
       /* ==> inserts operations into ready queue --> register deps resolved */
-      ruu_writeback();
+      PROF_STAGE(ps_writeback, ruu_writeback());
 
       if (!bugcompat_mode)
 	{
 	  /* try to locate memory operations that are ready to execute */
 	  /* ==> inserts operations into ready queue --> mem deps resolved */
-	  lsq_refresh();
+	  PROF_STAGE(ps_lsq_refresh, lsq_refresh());
 
 	  /* issue operations ready to execute from a previous cycle */
 	  /* <== drains ready queue <-- ready operations commence execution */
-	  ruu_issue();
+	  PROF_STAGE(ps_issue, ruu_issue());
 	}
 
+      /* run ahead of a window stalled on an L2 miss */
+      if (runahead)
+	runahead_cycle();
+
       /* decode and dispatch new operations */
       /* ==> insert ops w/ no deps or all regs ready --> reg deps resolved */
-      ruu_dispatch();
+      PROF_STAGE(ps_dispatch, ruu_dispatch());
 
       if (bugcompat_mode)
 	{
 	  /* try to locate memory operations that are ready to execute */
 	  /* ==> inserts operations into ready queue --> mem deps resolved */
-	  lsq_refresh();
+	  PROF_STAGE(ps_lsq_refresh, lsq_refresh());
 
 	  /* issue operations ready to execute from a previous cycle */
 	  /* <== drains ready queue <-- ready operations commence execution */
-	  ruu_issue();
+	  PROF_STAGE(ps_issue, ruu_issue());
 	}
 
       /* call instruction fetch unit if it is not blocked */
       if (!ruu_fetch_issue_delay)
-	ruu_fetch();
+	PROF_STAGE(ps_fetch, ruu_fetch());
       else
 	ruu_fetch_issue_delay--;
 
@@ -5056,11 +8064,181 @@ sim_main(void)
       LSQ_count += LSQ_num;
       LSQ_fcount += ((LSQ_num == LSQ_size) ? 1 : 0);
 
+      /* end of a sampled cycle */
+      if (prof_sample)
+	{
+	  prof_cycle_nsecs += host_nsecs() - prof_cycle_t0;
+	  prof_sample = cache_prof_active = FALSE;
+	}
+
       /* go to next cycle */
       sim_cycle++;
 
+      /* end of a stats interval? */
+      if (stat_interval
+	  && (interval_by_cycles ? sim_cycle : sim_num_insn) >= interval_next)
+	{
+	  stat_interval_row(stat_interval);
+	  interval_next =
+	    ((interval_by_cycles ? sim_cycle : sim_num_insn) / interval_size + 1)
+	    * interval_size;
+	}
+
+      /* progress heartbeat, host time is only read every 64k cycles */
+      if (heartbeat_secs && (sim_cycle & 0xffff) == 0)
+	sim_heartbeat();
+
       /* finish early? */
       if (max_insts && sim_num_insn >= max_insts)
 	return;
     }
 }
+
+#ifdef SIM_UBENCH
+/*
+ * micro-benchmark kernels, driven by sim-ubench; each one replays a
+ * recorded or synthetic stream through one of the internal structures above
+ */
+
+/* perform N 8-byte speculative memory accesses at the NUM addresses in ADDR,
+   writes where IS_WRITE is set, recovering every FLUSH accesses */
+void
+outorder_ubench_spec_mem(struct mem_t *mem,	/* memory space to access */
+			 md_addr_t *addr,	/* access addresses */
+			 byte_t *is_write,	/* access is a write? */
+			 int num,		/* number of addresses */
+			 counter_t n,		/* accesses to perform */
+			 int flush)		/* accesses between recoveries */
+{
+  counter_t i;
+  int j = 0, since_flush = 0;
+  qword_t val = 0;
+
+  for (i=0; i < n; i++)
+    {
+      spec_mem_access(mem, is_write[j] ? Write : Read, addr[j], &val,
+		      sizeof(qword_t));
+      if (++j == num)
+	j = 0;
+      if (++since_flush == flush)
+	{
+	  tracer_reset_spec();
+	  since_flush = 0;
+	}
+    }
+  tracer_reset_spec();
+}
+
+/* reservation stations for the queue kernels */
+static struct RUU_station *ubench_rs = NULL;
+
+/* set up WINDOW reservation stations and empty event and ready queues, with
+   enough RS links for every station to be queued in both */
+void
+outorder_ubench_queues_init(int window)	/* number of stations */
+{
+  int i;
+
+  if (ubench_rs)
+    free(ubench_rs);
+  ubench_rs = calloc(window, sizeof(struct RUU_station));
+  if (!ubench_rs)
+    fatal("out of virtual memory");
+  for (i=0; i < window; i++)
+    {
+      ubench_rs[i].op = MD_NOP_OP;
+      ubench_rs[i].tag = 1;
+      ubench_rs[i].seq = i;
+    }
+
+  rslink_init(2 * window);
+  eventq_init();
+  readyq_init();
+  sim_cycle = 0;
+}
+
+/* schedule N completion events for WINDOW stations, each station is
+   re-queued as it completes with the next of the NUM latencies in LAT */
+void
+outorder_ubench_eventq(int window,	/* number of stations */
+		       byte_t *lat,	/* execution latencies */
+		       int num,		/* number of latencies */
+		       counter_t n)	/* events to schedule */
+{
+  counter_t i = 0;
+  int j = 0;
+  struct RUU_station *rs;
+
+  for (; i < n && i < (counter_t)window; i++)
+    {
+      eventq_queue_event(&ubench_rs[i], sim_cycle + lat[j]);
+      if (++j == num)
+	j = 0;
+    }
+
+  while (event_queue)
+    {
+      sim_cycle++;
+      while ((rs = eventq_next_event()) != NULL)
+	{
+	  if (i < n)
+	    {
+	      eventq_queue_event(rs, sim_cycle + lat[j]);
+	      if (++j == num)
+		j = 0;
+	      i++;
+	    }
+	}
+    }
+}
+
+/* perform N ready queue insertions, keeping WINDOW stations queued and
+   issuing WIDTH from the head of the queue each cycle, stations are loads
+   or stores (which go to the head of the queue) when set in the NUM
+   entries of IS_MEM */
+void
+outorder_ubench_readyq(int window,	/* number of stations */
+		       int width,	/* issue width */
+		       byte_t *is_mem,	/* station holds a load or store? */
+		       int num,		/* number of entries in IS_MEM */
+		       counter_t n)	/* insertions to perform */
+{
+  counter_t i = 0;
+  int j = 0, k;
+  INST_SEQ_TYPE seq = 0;
+  struct RS_link *node;
+  struct RUU_station *rs;
+
+  for (; i < n && i < (counter_t)window; i++)
+    {
+      ubench_rs[i].seq = seq++;
+      ubench_rs[i].in_LSQ = is_mem[j];
+      ubench_rs[i].queued = FALSE;
+      readyq_enqueue(&ubench_rs[i]);
+      if (++j == num)
+	j = 0;
+    }
+
+  while (ready_queue)
+    {
+      for (k=0; k < width && ready_queue; k++)
+	{
+	  node = ready_queue;
+	  ready_queue = ready_queue->next;
+	  rs = RSLINK_RS(node);
+	  RSLINK_FREE(node);
+	  rs->queued = FALSE;
+
+	  if (i < n)
+	    {
+	      rs->seq = seq++;
+	      rs->in_LSQ = is_mem[j];
+	      readyq_enqueue(rs);
+	      if (++j == num)
+		j = 0;
+	      i++;
+	    }
+	}
+    }
+}
+#endif /* SIM_UBENCH */
@@ -0,0 +1,808 @@
+/* sim-ubench.c - micro-benchmark harness for the simulator kernels */
+
+/* SimpleScalar(TM) Tool Suite
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ * All Rights Reserved. 
+ * 
+ * THIS IS A LEGAL DOCUMENT, BY USING SIMPLESCALAR,
+ * YOU ARE AGREEING TO THESE TERMS AND CONDITIONS.
+ * 
+ * No portion of this work may be used by any commercial entity, or for any
+ * commercial purpose, without the prior, written permission of SimpleScalar,
+ * LLC (info@simplescalar.com). Nonprofit and noncommercial use is permitted
+ * as described below.
+ * 
+ * 1. SimpleScalar is provided AS IS, with no warranty of any kind, express
+ * or implied. The user of the program accepts full responsibility for the
+ * application of the program and the use of any results.
+ * 
+ * 2. Nonprofit and noncommercial use is encouraged. SimpleScalar may be
+ * downloaded, compiled, executed, copied, and modified solely for nonprofit,
+ * educational, noncommercial research, and noncommercial scholarship
+ * purposes provided that this notice in its entirety accompanies all copies.
+ * Copies of the modified software can be delivered to persons who use it
+ * solely for nonprofit, educational, noncommercial research, and
+ * noncommercial scholarship purposes provided that this notice in its
+ * entirety accompanies all copies.
+ * 
+ * 3. ALL COMMERCIAL USE, AND ALL USE BY FOR PROFIT ENTITIES, IS EXPRESSLY
+ * PROHIBITED WITHOUT A LICENSE FROM SIMPLESCALAR, LLC (info@simplescalar.com).
+ * 
+ * 4. No nonprofit user may place any restrictions on the use of this software,
+ * including as modified by the user, by any other authorized user.
+ * 
+ * 5. Noncommercial and nonprofit users may distribute copies of SimpleScalar
+ * in compiled or executable form as set forth in Section 2, provided that
+ * either: (A) it is accompanied by the corresponding machine-readable source
+ * code, or (B) it is accompanied by a written offer, with no time limit, to
+ * give anyone a machine-readable copy of the corresponding source code in
+ * return for reimbursement of the cost of distribution. This written offer
+ * must permit verbatim duplication by anyone, or (C) it is distributed by
+ * someone who received only the executable form, and is accompanied by a
+ * copy of the written offer of source code.
+ * 
+ * 6. SimpleScalar was developed by Todd M. Austin, Ph.D. The tool suite is
+ * currently maintained by SimpleScalar LLC (info@simplescalar.com). US Mail:
+ * 2395 Timbercrest Court, Ann Arbor, MI 48105.
+ * 
+ * Copyright (C) 1994-2003 by Todd M. Austin, Ph.D. and SimpleScalar, LLC.
+ */
+
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <setjmp.h>
+
+#include "host.h"
+#include "misc.h"
+#include "machine.h"
+#include "regs.h"
+#include "memory.h"
+#include "loader.h"
+#include "syscall.h"
+#include "dlite.h"
+#include "options.h"
+#include "stats.h"
+#include "cache.h"
+#include "bpred.h"
+#include "sim.h"
+
+/*
+ * This file implements a micro-benchmark harness for the simulator kernels:
+ * cache_access(), bpred_lookup() and bpred_update(), mem_translate() and
+ * MEM_READ_WORD(), and sim-outorder's spec_mem_access() and RUU event and
+ * ready queues, for which sim-ubench links a copy of sim-outorder built with
+ * SIM_UBENCH.  Each kernel is driven by a synthetic stream, and by a stream
+ * recorded by executing the program functionally, and the host time per
+ * operation and the heap allocations made are reported for every kernel
+ * configuration and stream.
+ */
+
+/* sim-outorder kernels, see the end of sim-outorder.c */
+void outorder_ubench_spec_mem(struct mem_t *mem, md_addr_t *addr,
+			      byte_t *is_write, int num, counter_t n,
+			      int flush);
+void outorder_ubench_queues_init(int window);
+void outorder_ubench_eventq(int window, byte_t *lat, int num, counter_t n);
+void outorder_ubench_readyq(int window, int width, byte_t *is_mem, int num,
+			    counter_t n);
+
+/* simulated registers */
+static struct regs_t regs;
+
+/* simulated memory */
+static struct mem_t *mem = NULL;
+
+/* most configurations of each kernel */
+#define UB_MAX_CONFIGS		8
+
+/* instructions recorded from the program */
+static int record_insts;
+
+/* operations per kernel run */
+static int num_ops;
+
+/* kernels to run */
+static int kernel_nelt = 1;
+static char *kernel_opts[UB_MAX_CONFIGS] = { "all" };
+
+/* cache configurations, <name>:<nsets>:<bsize>:<assoc>:<repl> */
+static int cache_nelt = 3;
+static char *cache_opts[UB_MAX_CONFIGS] =
+  { "dl1:128:32:4:l", "dl1:1024:32:1:l", "ul2:1024:64:4:l" };
+
+/* branch predictor types, with sim-bpred's default sizes */
+static int bpred_nelt = 3;
+static char *bpred_opts[UB_MAX_CONFIGS] = { "bimod", "2lev", "comb" };
+
+/* RUU sizes for the queue kernels */
+static int window_nelt = 3;
+static int window_opts[UB_MAX_CONFIGS] = { 16, 64, 256 };
+
+/* speculative memory accesses between recoveries */
+static int spec_flush;
+
+/* benchmark kernels */
+enum ubench_kernel_t {
+  uk_cache, uk_bpred, uk_mem, uk_spec_mem, uk_eventq, uk_readyq, uk_NUM
+};
+static char *ubench_kernel_name[uk_NUM] = {
+  "cache", "bpred", "mem", "spec_mem", "eventq", "readyq"
+};
+static int run_kernel[uk_NUM];
+
+/* a control instruction */
+struct ubench_br {
+  md_addr_t pc;			/* branch address */
+  md_addr_t target;		/* taken target */
+  md_addr_t npc;		/* resolved next PC */
+  enum md_opcode op;		/* opcode */
+};
+
+/* an operation stream, replayed cyclically by the kernels */
+struct ubench_stream {
+  char *name;			/* stream name */
+  int num_refs;			/* data references */
+  md_addr_t *ref_addr;		/* reference addresses, 8-byte aligned */
+  byte_t *ref_write;		/* reference is a store? */
+  int num_brs;			/* control instructions */
+  struct ubench_br *brs;
+  int num_insts;		/* instructions */
+  byte_t *inst_lat;		/* execution latency of each instruction */
+  byte_t *inst_mem;		/* instruction is a load or store? */
+};
+static struct ubench_stream synthetic, recorded;
+
+/* heap allocations made while a kernel runs, counted when the simulator is
+   linked with the allocator wrapped (see the Makefile) */
+static counter_t ub_allocs = 0;
+static counter_t ub_alloc_bytes = 0;
+
+#ifdef UBENCH_WRAP_MALLOC
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *
+__wrap_malloc(size_t size)
+{
+  ub_allocs++;
+  ub_alloc_bytes += size;
+  return __real_malloc(size);
+}
+
+void *
+__wrap_calloc(size_t nmemb, size_t size)
+{
+  ub_allocs++;
+  ub_alloc_bytes += nmemb * size;
+  return __real_calloc(nmemb, size);
+}
+
+void *
+__wrap_realloc(void *ptr, size_t size)
+{
+  ub_allocs++;
+  ub_alloc_bytes += size;
+  return __real_realloc(ptr, size);
+}
+#endif /* UBENCH_WRAP_MALLOC */
+
+
+/* register simulator-specific options */
+void
+sim_reg_options(struct opt_odb_t *odb)
+{
+  opt_reg_header(odb, 
+"sim-ubench: This program implements a micro-benchmark harness for the\n"
+"simulator kernels: cache accesses, branch predictor lookups and updates,\n"
+"memory translation and reads, and sim-outorder's speculative memory\n"
+"accesses and RUU event and ready queues.  Each kernel is driven by a\n"
+"synthetic stream and by a stream recorded from the program, and host ns\n"
+"per operation and heap allocations are reported.\n"
+		 );
+
+  opt_reg_int(odb, "-ubench:record",
+	      "instructions of the program to record for the recorded stream",
+	      &record_insts, /* default */1000000,
+	      /* print */TRUE, /* format */NULL);
+  opt_reg_int(odb, "-ubench:ops", "operations per kernel run",
+	      &num_ops, /* default */1000000,
+	      /* print */TRUE, /* format */NULL);
+  opt_reg_string_list(odb, "-ubench:kernels",
+		      "kernels to run "
+		      "{all|cache|bpred|mem|spec_mem|eventq|readyq}",
+		      kernel_opts, UB_MAX_CONFIGS, &kernel_nelt,
+		      /* default */kernel_opts,
+		      /* print */TRUE, /* format */NULL, /* !accrue */FALSE);
+  opt_reg_string_list(odb, "-ubench:cache",
+		      "cache configs <name>:<nsets>:<bsize>:<assoc>:<repl>",
+		      cache_opts, UB_MAX_CONFIGS, &cache_nelt,
+		      /* default */cache_opts,
+		      /* print */TRUE, /* format */NULL, /* !accrue */FALSE);
+  opt_reg_string_list(odb, "-ubench:bpred",
+		      "branch predictor types {nottaken|taken|bimod|2lev|comb}",
+		      bpred_opts, UB_MAX_CONFIGS, &bpred_nelt,
+		      /* default */bpred_opts,
+		      /* print */TRUE, /* format */NULL, /* !accrue */FALSE);
+  opt_reg_int_list(odb, "-ubench:window",
+		   "RUU sizes for the event and ready queue kernels",
+		   window_opts, UB_MAX_CONFIGS, &window_nelt,
+		   /* default */window_opts,
+		   /* print */TRUE, /* format */NULL, /* !accrue */FALSE);
+  opt_reg_int(odb, "-ubench:spec_flush",
+	      "speculative memory accesses between recoveries",
+	      &spec_flush, /* default */64,
+	      /* print */TRUE, /* format */NULL);
+}
+
+/* check simulator-specific option values */
+void
+sim_check_options(struct opt_odb_t *odb, int argc, char **argv)
+{
+  int i, k;
+
+  if (record_insts < 1)
+    fatal("bad number of instructions to record: %d", record_insts);
+  if (num_ops < 1)
+    fatal("bad number of operations per run: %d", num_ops);
+  if (spec_flush < 1)
+    fatal("bad speculative memory flush interval: %d", spec_flush);
+  for (i=0; i<window_nelt; i++)
+    if (window_opts[i] < 4)
+      fatal("RUU size for the queue kernels must be at least 4");
+
+  for (i=0; i<kernel_nelt; i++)
+    {
+      if (!mystricmp(kernel_opts[i], "all"))
+	{
+	  for (k=0; k<uk_NUM; k++)
+	    run_kernel[k] = TRUE;
+	  continue;
+	}
+      for (k=0; k<uk_NUM; k++)
+	if (!mystricmp(kernel_opts[i], ubench_kernel_name[k]))
+	  break;
+      if (k == uk_NUM)
+	fatal("unknown kernel `%s'", kernel_opts[i]);
+      run_kernel[k] = TRUE;
+    }
+}
+
+/* register simulator-specific statistics */
+void
+sim_reg_stats(struct stat_sdb_t *sdb)
+{
+  stat_reg_counter(sdb, "sim_num_insn",
+		   "total number of instructions recorded",
+		   &sim_num_insn, sim_num_insn, NULL);
+  stat_reg_int(sdb, "sim_elapsed_time",
+	       "total simulation time in seconds",
+	       &sim_elapsed_time, 0, NULL);
+}
+
+/* initialize the simulator */
+void
+sim_init(void)
+{
+  /* allocate and initialize register file */
+  regs_init(&regs);
+
+  /* allocate and initialize memory space */
+  mem = mem_create("mem");
+  mem_init(mem);
+}
+
+/* load program into simulated state */
+void
+sim_load_prog(char *fname,		/* program to load */
+	      int argc, char **argv,	/* program arguments */
+	      char **envp)		/* program environment */
+{
+  /* load program text and data, set up environment, memory, and regs */
+  ld_load_prog(fname, argc, argv, envp, &regs, mem, TRUE);
+
+  /* initialize the DLite debugger */
+  dlite_init(md_reg_obj, dlite_mem_obj, dlite_mstate_obj);
+}
+
+/* print simulator-specific configuration information */
+void
+sim_aux_config(FILE *stream)		/* output stream */
+{
+  /* nothing currently */
+}
+
+/* dump simulator-specific auxiliary simulator statistics */
+void
+sim_aux_stats(FILE *stream)		/* output stream */
+{
+  /* nada */
+}
+
+/* un-initialize simulator-specific state */
+void
+sim_uninit(void)
+{
+  /* nada */
+}
+
+
+/*
+ * operation streams
+ */
+
+/* allocate storage for N operations of every kind in stream S */
+static void
+stream_alloc(struct ubench_stream *s, char *name, int n)
+{
+  s->name = name;
+  s->num_refs = s->num_brs = s->num_insts = 0;
+  s->ref_addr = (md_addr_t *)calloc(n, sizeof(md_addr_t));
+  s->ref_write = (byte_t *)calloc(n, sizeof(byte_t));
+  s->brs = (struct ubench_br *)calloc(n, sizeof(struct ubench_br));
+  s->inst_lat = (byte_t *)calloc(n, sizeof(byte_t));
+  s->inst_mem = (byte_t *)calloc(n, sizeof(byte_t));
+  if (!s->ref_addr || !s->ref_write || !s->brs || !s->inst_lat
+      || !s->inst_mem)
+    fatal("out of virtual memory");
+}
+
+/* execution latency of an instruction, for the queue kernels */
+#define INST_LAT(FLAGS)							\
+  (((FLAGS) & F_MEM) ? 3 : ((FLAGS) & F_LONGLAT) ? 8 : 1)
+
+/* build the synthetic stream: references half sequential through 64k and
+   half random over 4M of the data segment, a quarter of them stores; 256
+   conditional branches of random bias; and an instruction mix of 30%
+   memory, 5% long latency operations */
+static void
+synthetic_stream(int n)
+{
+  md_addr_t base = ld_data_base, seq = 0;
+  int i, bias[256];
+
+  stream_alloc(&synthetic, "synthetic", n);
+
+  for (i=0; i<256; i++)
+    bias[i] = myrand() & 0xff;
+
+  for (i=0; i<n; i++)
+    {
+      if (i & 1)
+	synthetic.ref_addr[i] = base + ((myrand() << 3) & ((4 << 20) - 1));
+      else
+	{
+	  synthetic.ref_addr[i] = base + seq;
+	  seq = (seq + 8) & ((64 << 10) - 1);
+	}
+      synthetic.ref_write[i] = (myrand() & 3) == 0;
+
+      synthetic.brs[i].pc = ld_text_base + (i & 0xff) * 64;
+      synthetic.brs[i].target = synthetic.brs[i].pc - 256;
+      synthetic.brs[i].npc = (myrand() & 0xff) < bias[i & 0xff]
+	? synthetic.brs[i].target
+	: synthetic.brs[i].pc + sizeof(md_inst_t);
+      synthetic.brs[i].op = BNE;
+
+      synthetic.inst_mem[i] = (myrand() % 100) < 30;
+      synthetic.inst_lat[i] = synthetic.inst_mem[i]
+	? INST_LAT(F_MEM)
+	: (myrand() % 100) < 7 ? INST_LAT(F_LONGLAT) : INST_LAT(0);
+    }
+  synthetic.num_refs = synthetic.num_brs = synthetic.num_insts = n;
+}
+
+
+/*
+ * configure the execution engine
+ */
+
+/*
+ * precise architected register accessors
+ */
+
+/* next program counter */
+#define SET_NPC(EXPR)		(regs.regs_NPC = (EXPR))
+
+/* target program counter */
+#undef  SET_TPC
+#define SET_TPC(EXPR)		(target_PC = (EXPR))
+
+/* current program counter */
+#define CPC			(regs.regs_PC)
+
+/* general purpose registers */
+#define GPR(N)			(regs.regs_R[N])
+#define SET_GPR(N,EXPR)		(regs.regs_R[N] = (EXPR))
+
+#if defined(TARGET_PISA)
+
+/* floating point registers, L->word, F->single-prec, D->double-prec */
+#define FPR_L(N)		(regs.regs_F.l[(N)])
+#define SET_FPR_L(N,EXPR)	(regs.regs_F.l[(N)] = (EXPR))
+#define FPR_F(N)		(regs.regs_F.f[(N)])
+#define SET_FPR_F(N,EXPR)	(regs.regs_F.f[(N)] = (EXPR))
+#define FPR_D(N)		(regs.regs_F.d[(N) >> 1])
+#define SET_FPR_D(N,EXPR)	(regs.regs_F.d[(N) >> 1] = (EXPR))
+
+/* miscellaneous register accessors */
+#define SET_HI(EXPR)		(regs.regs_C.hi = (EXPR))
+#define HI			(regs.regs_C.hi)
+#define SET_LO(EXPR)		(regs.regs_C.lo = (EXPR))
+#define LO			(regs.regs_C.lo)
+#define FCC			(regs.regs_C.fcc)
+#define SET_FCC(EXPR)		(regs.regs_C.fcc = (EXPR))
+
+#elif defined(TARGET_ALPHA)
+
+/* floating point registers, L->word, F->single-prec, D->double-prec */
+#define FPR_Q(N)		(regs.regs_F.q[N])
+#define SET_FPR_Q(N,EXPR)	(regs.regs_F.q[N] = (EXPR))
+#define FPR(N)			(regs.regs_F.d[(N)])
+#define SET_FPR(N,EXPR)		(regs.regs_F.d[(N)] = (EXPR))
+
+/* miscellaneous register accessors */
+#define FPCR			(regs.regs_C.fpcr)
+#define SET_FPCR(EXPR)		(regs.regs_C.fpcr = (EXPR))
+#define UNIQ			(regs.regs_C.uniq)
+#define SET_UNIQ(EXPR)		(regs.regs_C.uniq = (EXPR))
+
+#else
+#error No ISA target defined...
+#endif
+
+/* precise architected memory state accessor macros */
+#define READ_BYTE(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_BYTE(mem, addr))
+#define READ_HALF(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_HALF(mem, addr))
+#define READ_WORD(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_WORD(mem, addr))
+#ifdef HOST_HAS_QWORD
+#define READ_QWORD(SRC, FAULT)						\
+  ((FAULT) = md_fault_none, addr = (SRC), MEM_READ_QWORD(mem, addr))
+#endif /* HOST_HAS_QWORD */
+
+#define WRITE_BYTE(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_BYTE(mem, addr, (SRC)))
+#define WRITE_HALF(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_HALF(mem, addr, (SRC)))
+#define WRITE_WORD(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_WORD(mem, addr, (SRC)))
+#ifdef HOST_HAS_QWORD
+#define WRITE_QWORD(SRC, DST, FAULT)					\
+  ((FAULT) = md_fault_none, addr = (DST), MEM_WRITE_QWORD(mem, addr, (SRC)))
+#endif /* HOST_HAS_QWORD */
+
+/* system call handler macro */
+#define SYSCALL(INST)	sys_syscall(&regs, mem_access, mem, INST, TRUE)
+
+/* record the first N instructions of the program into the recorded stream,
+   recording stops early if the program exits */
+static void
+record_stream(int n)
+{
+  md_inst_t inst;
+  register md_addr_t addr, target_PC = 0;
+  enum md_opcode op;
+  enum md_fault_type fault;
+  jmp_buf exit_buf;
+
+  stream_alloc(&recorded, "recorded", n);
+
+  /* catch the program exiting before N instructions are recorded */
+  memcpy(exit_buf, sim_exit_buf, sizeof(jmp_buf));
+  if (setjmp(sim_exit_buf) != 0)
+    {
+      memcpy(sim_exit_buf, exit_buf, sizeof(jmp_buf));
+      return;
+    }
+
+  /* set up initial default next PC */
+  regs.regs_NPC = regs.regs_PC + sizeof(md_inst_t);
+
+  while (recorded.num_insts < n)
+    {
+      /* maintain $r0 semantics */
+      regs.regs_R[MD_REG_ZERO] = 0;
+#ifdef TARGET_ALPHA
+      regs.regs_F.d[MD_REG_ZERO] = 0.0;
+#endif /* TARGET_ALPHA */
+
+      /* get the next instruction to execute */
+      MD_FETCH_INST(inst, mem, regs.regs_PC);
+
+      /* keep an instruction count */
+      sim_num_insn++;
+
+      /* set default reference address */
+      addr = 0;
+
+      /* set default fault - none */
+      fault = md_fault_none;
+
+      /* decode the instruction */
+      MD_SET_OPCODE(op, inst);
+
+      /* execute the instruction */
+      switch (op)
+	{
+#define DEFINST(OP,MSK,NAME,OPFORM,RES,FLAGS,O1,O2,I1,I2,I3)		\
+	case OP:							\
+          SYMCAT(OP,_IMPL);						\
+          break;
+#define DEFLINK(OP,MSK,NAME,MASK,SHIFT)					\
+        case OP:							\
+          panic("attempted to execute a linking opcode");
+#define CONNECT(OP)
+#define DECLARE_FAULT(FAULT)						\
+	  { fault = (FAULT); break; }
+#include "machine.def"
+	default:
+	  panic("attempted to execute a bogus opcode");
+      }
+
+      if (fault != md_fault_none)
+	fatal("fault (%d) detected @ 0x%08p", fault, regs.regs_PC);
+
+      recorded.inst_mem[recorded.num_insts] = !!(MD_OP_FLAGS(op) & F_MEM);
+      recorded.inst_lat[recorded.num_insts] = INST_LAT(MD_OP_FLAGS(op));
+      recorded.num_insts++;
+
+      if (MD_OP_FLAGS(op) & F_MEM)
+	{
+	  recorded.ref_addr[recorded.num_refs] = addr & ~(md_addr_t)7;
+	  recorded.ref_write[recorded.num_refs] =
+	    !!(MD_OP_FLAGS(op) & F_STORE);
+	  recorded.num_refs++;
+	}
+
+      if (MD_OP_FLAGS(op) & F_CTRL)
+	{
+	  recorded.brs[recorded.num_brs].pc = regs.regs_PC;
+	  recorded.brs[recorded.num_brs].target = target_PC;
+	  recorded.brs[recorded.num_brs].npc = regs.regs_NPC;
+	  recorded.brs[recorded.num_brs].op = op;
+	  recorded.num_brs++;
+	}
+
+      /* go to the next instruction */
+      regs.regs_PC = regs.regs_NPC;
+      regs.regs_NPC += sizeof(md_inst_t);
+    }
+
+  memcpy(sim_exit_buf, exit_buf, sizeof(jmp_buf));
+}
+
+
+/*
+ * kernels
+ */
+
+/* fixed memory latency behind the benchmarked caches */
+static unsigned int			/* latency of block access */
+ubench_mem_access_fn(enum mem_cmd cmd,	/* access cmd, Read or Write */
+		     md_addr_t baddr,	/* block address to access */
+		     int bsize,		/* size of block to access */
+		     struct cache_blk_t *blk, /* ptr to block in upper level */
+		     tick_t now)	/* time of access */
+{
+  return 18;
+}
+
+/* host time and allocations at the start of the current run */
+static double run_start;
+static counter_t run_allocs, run_alloc_bytes;
+
+/* start timing a kernel run */
+static void
+run_begin(void)
+{
+  run_allocs = ub_allocs;
+  run_alloc_bytes = ub_alloc_bytes;
+  run_start = host_nsecs();
+}
+
+/* finish timing a kernel run of N operations and report it */
+static void
+run_end(enum ubench_kernel_t kernel,	/* kernel run */
+	char *config,			/* kernel configuration */
+	struct ubench_stream *s,	/* stream driving the kernel */
+	counter_t n)			/* operations performed */
+{
+  double nsecs = host_nsecs() - run_start;
+
+  fprintf(stderr, "ubench: %-9s %-20s %-10s %10.0f %9.2f %8.0f %10.0f\n",
+	  ubench_kernel_name[kernel], config, s->name, (double)n,
+	  n ? nsecs / (double)n : 0.0, (double)(ub_allocs - run_allocs),
+	  (double)(ub_alloc_bytes - run_alloc_bytes));
+}
+
+/* cache_access() over the stream's data references */
+static void
+kernel_cache(char *config, struct ubench_stream *s)
+{
+  char name[128], c;
+  int nsets, bsize, assoc, i = 0;
+  counter_t n;
+  struct cache_t *cp;
+
+  if (sscanf(config, "%[^:]:%d:%d:%d:%c",
+	     name, &nsets, &bsize, &assoc, &c) != 5)
+    fatal("bad cache parms: <name>:<nsets>:<bsize>:<assoc>:<repl>");
+  cp = cache_create(name, nsets, bsize, /* balloc */FALSE,
+		    /* usize */0, assoc, cache_char2policy(c),
+		    ubench_mem_access_fn, /* hit lat */1);
+
+  run_begin();
+  for (n=0; n < (counter_t)num_ops; n++)
+    {
+      cache_access(cp, s->ref_write[i] ? Write : Read, s->ref_addr[i],
+		   NULL, 8, /* now */n, NULL, NULL);
+      if (++i == s->num_refs)
+	i = 0;
+    }
+  run_end(uk_cache, config, s, n);
+}
+
+/* bpred_lookup() and bpred_update() over the stream's branches, as
+   sim-bpred does */
+static void
+kernel_bpred(char *config, struct ubench_stream *s)
+{
+  struct bpred_t *pred;
+  struct bpred_update_t update_rec;
+  struct ubench_br *br;
+  md_addr_t pred_PC;
+  int stack_idx, i = 0;
+  counter_t n;
+
+  if (!mystricmp(config, "nottaken"))
+    pred = bpred_create(BPredNotTaken, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  else if (!mystricmp(config, "taken"))
+    pred = bpred_create(BPredTaken, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  else if (!mystricmp(config, "bimod"))
+    pred = bpred_create(BPred2bit, /* bimod table size */2048,
+			0, 0, 0, 0, 0, /* btb sets */512, /* btb assoc */4,
+			/* ret-addr stack size */8);
+  else if (!mystricmp(config, "2lev"))
+    pred = bpred_create(BPred2Level, 0, /* l1 size */1, /* l2 size */1024,
+			/* meta table size */0, /* history reg size */8,
+			/* history xor address */0,
+			/* btb sets */512, /* btb assoc */4,
+			/* ret-addr stack size */8);
+  else if (!mystricmp(config, "comb"))
+    pred = bpred_create(BPredComb, /* bimod table size */2048,
+			/* l1 size */1, /* l2 size */1024,
+			/* meta table size */1024, /* history reg size */8,
+			/* history xor address */0,
+			/* btb sets */512, /* btb assoc */4,
+			/* ret-addr stack size */8);
+  else
+    fatal("cannot parse predictor type `%s'", config);
+
+  run_begin();
+  for (n=0; n < (counter_t)num_ops; n++)
+    {
+      br = &s->brs[i];
+      pred_PC = bpred_lookup(pred, br->pc, br->target, br->op,
+			     MD_IS_CALL(br->op), MD_IS_RETURN(br->op),
+			     &update_rec, &stack_idx);
+      if (!pred_PC)
+	pred_PC = br->pc + sizeof(md_inst_t);
+      bpred_update(pred, br->pc, br->npc,
+		   /* taken? */br->npc != br->pc + sizeof(md_inst_t),
+		   /* pred taken? */pred_PC != br->pc + sizeof(md_inst_t),
+		   /* correct pred? */pred_PC == br->npc,
+		   br->op, &update_rec);
+      if (++i == s->num_brs)
+	i = 0;
+    }
+  run_end(uk_bpred, config, s, n);
+}
+
+/* mem_translate() and MEM_READ_WORD() over the stream's data references,
+   both paths through the page table are timed */
+static void
+kernel_mem(struct ubench_stream *s)
+{
+  word_t sum = 0;
+  int i = 0;
+  counter_t n;
+
+  run_begin();
+  for (n=0; n < (counter_t)num_ops; n++)
+    {
+      sum += (word_t)(long)mem_translate(mem, s->ref_addr[i]);
+      if (++i == s->num_refs)
+	i = 0;
+    }
+  run_end(uk_mem, "mem_translate", s, n);
+
+  run_begin();
+  for (n=0; n < (counter_t)num_ops; n++)
+    {
+      sum += MEM_READ_WORD(mem, s->ref_addr[i]);
+      if (++i == s->num_refs)
+	i = 0;
+    }
+  run_end(uk_mem, "MEM_READ_WORD", s, n);
+
+  /* keep the reads live */
+  if (sum == 1)
+    fprintf(stderr, " ");
+}
+
+/* run the selected kernels over stream S */
+static void
+ubench_stream(struct ubench_stream *s)
+{
+  char config[64];
+  int i;
+
+  if (!s->num_insts || !s->num_refs || !s->num_brs)
+    {
+      fprintf(stderr, "ubench: %s stream is empty, skipped\n", s->name);
+      return;
+    }
+
+  if (run_kernel[uk_cache])
+    for (i=0; i<cache_nelt; i++)
+      kernel_cache(cache_opts[i], s);
+
+  if (run_kernel[uk_bpred])
+    for (i=0; i<bpred_nelt; i++)
+      kernel_bpred(bpred_opts[i], s);
+
+  if (run_kernel[uk_mem])
+    kernel_mem(s);
+
+  if (run_kernel[uk_spec_mem])
+    {
+      sprintf(config, "flush:%d", spec_flush);
+      run_begin();
+      outorder_ubench_spec_mem(mem, s->ref_addr, s->ref_write, s->num_refs,
+			       num_ops, spec_flush);
+      run_end(uk_spec_mem, config, s, num_ops);
+    }
+
+  for (i=0; i<window_nelt; i++)
+    {
+      sprintf(config, "ruu:%d", window_opts[i]);
+      if (run_kernel[uk_eventq])
+	{
+	  outorder_ubench_queues_init(window_opts[i]);
+	  run_begin();
+	  outorder_ubench_eventq(window_opts[i], s->inst_lat, s->num_insts,
+				 num_ops);
+	  run_end(uk_eventq, config, s, num_ops);
+	}
+      if (run_kernel[uk_readyq])
+	{
+	  outorder_ubench_queues_init(window_opts[i]);
+	  run_begin();
+	  outorder_ubench_readyq(window_opts[i], /* issue width */4,
+				 s->inst_mem, s->num_insts, num_ops);
+	  run_end(uk_readyq, config, s, num_ops);
+	}
+    }
+}
+
+/* start simulation, program loaded, processor precise state initialized */
+void
+sim_main(void)
+{
+  fprintf(stderr, "sim: ** recording %d insts **\n", record_insts);
+  record_stream(record_insts);
+  synthetic_stream(record_insts);
+
+  fprintf(stderr,
+	  "ubench: %-9s %-20s %-10s %10s %9s %8s %10s\n",
+	  "kernel", "config", "stream", "ops", "ns/op", "allocs", "bytes");
+  ubench_stream(&synthetic);
+  ubench_stream(&recorded);
+}
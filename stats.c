@@ -1011,6 +1011,247 @@ stat_print_stats(struct stat_sdb_t *sdb,/* stat database */
     stat_print_stat(sdb, stat, fd);
 }
 
+/* format the value of scalar stat STAT into BUF, returns FALSE if it has no
+   value, i.e., it is a formula that cannot be evaluated or not finite */
+static int
+scalar_value(struct stat_sdb_t *sdb,	/* stat database */
+	     struct stat_stat_t *stat,	/* stat variable */
+	     char *buf)			/* value buffer */
+{
+  double d;
+
+  switch (stat->sc)
+    {
+    case sc_int:
+      sprintf(buf, "%d", *stat->variant.for_int.var);
+      return TRUE;
+    case sc_uint:
+      sprintf(buf, "%u", *stat->variant.for_uint.var);
+      return TRUE;
+#ifdef HOST_HAS_QWORD
+    case sc_qword:
+      mysprintf(buf, "%lu", *stat->variant.for_qword.var);
+      return TRUE;
+    case sc_sqword:
+      mysprintf(buf, "%ld", *stat->variant.for_sqword.var);
+      return TRUE;
+#endif /* HOST_HAS_QWORD */
+    case sc_float:
+      d = (double)*stat->variant.for_float.var;
+      break;
+    case sc_double:
+      d = *stat->variant.for_double.var;
+      break;
+    case sc_formula:
+      {
+	/* instantiate a new evaluator to avoid recursion problems */
+	struct eval_state_t *es = eval_new(stat_eval_ident, sdb);
+	struct eval_value_t val;
+	char *endp;
+	int err;
+
+	val = eval_expr(es, stat->variant.for_formula.formula, &endp);
+	err = (eval_error != ERR_NOERR || *endp != '\0');
+	eval_delete(es);
+	if (err)
+	  return FALSE;
+	d = eval_as_double(val);
+      }
+      break;
+    default:
+      panic("bogus stat class");
+    }
+
+  /* NaN and infinities have no JSON representation */
+  if (d != d || d - d != 0.0)
+    return FALSE;
+  sprintf(buf, "%.12g", d);
+  return TRUE;
+}
+
+/* distribution summary values, as printed by print_dist() and print_sdist() */
+struct dist_summary_t {
+  unsigned int count;		/* number of buckets */
+  double total;			/* sum of the bucket counts */
+  double average;		/* average bucket count */
+  double std_dev;		/* standard deviation of the bucket counts */
+  struct bucket_t **barr;	/* sparse buckets, sorted by index */
+};
+
+/* summarize distribution STAT, the sparse bucket array must be freed */
+static void
+dist_summary(struct stat_stat_t *stat,	/* stat variable */
+	     struct dist_summary_t *ds)	/* summary */
+{
+  struct bucket_t *bucket;
+  double bsqsum = 0.0, bvar;
+  unsigned int i, n;
+
+  ds->count = 0;
+  ds->total = 0.0;
+  ds->barr = NULL;
+  if (stat->sc == sc_dist)
+    {
+      for (i=0; i<stat->variant.for_dist.arr_sz; i++)
+	{
+	  ds->count++;
+	  ds->total += stat->variant.for_dist.arr[i];
+	  bsqsum += ((double)stat->variant.for_dist.arr[i] *
+		     (double)stat->variant.for_dist.arr[i]);
+	}
+    }
+  else
+    {
+      for (i=0; i<HTAB_SZ; i++)
+	for (bucket = stat->variant.for_sdist.sarr[i];
+	     bucket != NULL;
+	     bucket = bucket->next)
+	  {
+	    ds->count++;
+	    ds->total += bucket->count;
+	    bsqsum += ((double)bucket->count * (double)bucket->count);
+	  }
+
+      /* collect and sort the buckets */
+      ds->barr = (struct bucket_t **)
+	calloc(MAX(ds->count, 1), sizeof(struct bucket_t *));
+      if (!ds->barr)
+	fatal("out of virtual memory");
+      for (n=0, i=0; i<HTAB_SZ; i++)
+	for (bucket = stat->variant.for_sdist.sarr[i];
+	     bucket != NULL;
+	     bucket = bucket->next)
+	  ds->barr[n++] = bucket;
+      qsort(ds->barr, ds->count, sizeof(struct bucket_t *),
+	    (void *)compare_fn);
+    }
+
+  ds->average = ds->total / MAX((double)ds->count, 1.0);
+  bvar = (bsqsum - ((double)ds->count * ds->average * ds->average)) /
+    (double)((ds->count > 1) ? (ds->count - 1) : 1);
+  ds->std_dev = sqrt(MAX(bvar, 0.0));
+}
+
+/* print all stat variables in stat database SDB as a JSON object, one
+   member per stat; scalar stats are numbers (null if a formula cannot be
+   evaluated), distributions are objects holding their summary values and
+   `index' and `counts' arrays */
+void
+stat_print_stats_json(struct stat_sdb_t *sdb,/* stat database */
+		      FILE *fd)		/* output stream */
+{
+  struct stat_stat_t *stat;
+  struct dist_summary_t ds;
+  char buf[128];
+  unsigned int i;
+
+  fprintf(fd, "{");
+  for (stat=sdb ? sdb->stats : NULL; stat != NULL; stat=stat->next)
+    {
+      fprintf(fd, "\n  ");
+      json_print_string(fd, stat->name);
+      fprintf(fd, ": ");
+      switch (stat->sc)
+	{
+	case sc_dist:
+	  dist_summary(stat, &ds);
+	  fprintf(fd, "{\"array_size\": %u, \"bucket_size\": %u, ",
+		  stat->variant.for_dist.arr_sz,
+		  stat->variant.for_dist.bucket_sz);
+	  fprintf(fd, "\"count\": %u, \"total\": %.0f, \"average\": %.12g, "
+		  "\"std_dev\": %.12g, \"overflows\": %u,\n    \"index\": [",
+		  ds.count, ds.total, ds.average, ds.std_dev,
+		  stat->variant.for_dist.overflows);
+	  for (i=0; i<ds.count; i++)
+	    {
+	      if (i != 0)
+		fprintf(fd, ", ");
+	      if (stat->variant.for_dist.imap)
+		json_print_string(fd, stat->variant.for_dist.imap[i]);
+	      else
+		fprintf(fd, "%u", i * stat->variant.for_dist.bucket_sz);
+	    }
+	  fprintf(fd, "],\n    \"counts\": [");
+	  for (i=0; i<ds.count; i++)
+	    fprintf(fd, i != 0 ? ", %u" : "%u", stat->variant.for_dist.arr[i]);
+	  fprintf(fd, "]}");
+	  break;
+	case sc_sdist:
+	  dist_summary(stat, &ds);
+	  fprintf(fd, "{\"count\": %u, \"total\": %.0f, \"average\": %.12g, "
+		  "\"std_dev\": %.12g,\n    \"index\": [",
+		  ds.count, ds.total, ds.average, ds.std_dev);
+	  for (i=0; i<ds.count; i++)
+	    myfprintf(fd, i != 0 ? ", \"0x%p\"" : "\"0x%p\"",
+		      ds.barr[i]->index);
+	  fprintf(fd, "],\n    \"counts\": [");
+	  for (i=0; i<ds.count; i++)
+	    fprintf(fd, i != 0 ? ", %u" : "%u", ds.barr[i]->count);
+	  fprintf(fd, "]}");
+	  free(ds.barr);
+	  break;
+	default:
+	  fprintf(fd, "%s", scalar_value(sdb, stat, buf) ? buf : "null");
+	}
+      if (stat->next)
+	fprintf(fd, ",");
+    }
+  fprintf(fd, "\n}");
+}
+
+/* print all stat variables in stat database SDB as CSV rows of the form
+   `stat,<name>,<index>,<value>', the index is empty for scalar stats and
+   distribution summary values (`<name>.total' etc.), and is the bucket index
+   for distribution counts */
+void
+stat_print_stats_csv(struct stat_sdb_t *sdb,/* stat database */
+		     FILE *fd)		/* output stream */
+{
+  struct stat_stat_t *stat;
+  struct dist_summary_t ds;
+  char buf[128];
+  unsigned int i;
+
+  for (stat=sdb ? sdb->stats : NULL; stat != NULL; stat=stat->next)
+    {
+      switch (stat->sc)
+	{
+	case sc_dist:
+	case sc_sdist:
+	  dist_summary(stat, &ds);
+	  fprintf(fd, "stat,%s.count,,%u\n", stat->name, ds.count);
+	  fprintf(fd, "stat,%s.total,,%.0f\n", stat->name, ds.total);
+	  fprintf(fd, "stat,%s.average,,%.12g\n", stat->name, ds.average);
+	  fprintf(fd, "stat,%s.std_dev,,%.12g\n", stat->name, ds.std_dev);
+	  if (stat->sc == sc_dist)
+	    {
+	      fprintf(fd, "stat,%s.overflows,,%u\n",
+		      stat->name, stat->variant.for_dist.overflows);
+	      for (i=0; i<ds.count; i++)
+		{
+		  fprintf(fd, "stat,%s,", stat->name);
+		  if (stat->variant.for_dist.imap)
+		    csv_print_string(fd, stat->variant.for_dist.imap[i]);
+		  else
+		    fprintf(fd, "%u", i * stat->variant.for_dist.bucket_sz);
+		  fprintf(fd, ",%u\n", stat->variant.for_dist.arr[i]);
+		}
+	    }
+	  else
+	    {
+	      for (i=0; i<ds.count; i++)
+		myfprintf(fd, "stat,%s,0x%p,%u\n",
+			  stat->name, ds.barr[i]->index, ds.barr[i]->count);
+	      free(ds.barr);
+	    }
+	  break;
+	default:
+	  fprintf(fd, "stat,%s,,%s\n",
+		  stat->name, scalar_value(sdb, stat, buf) ? buf : "");
+	}
+    }
+}
+
 /* find a stat variable, returns NULL if it is not found */
 struct stat_stat_t *
 stat_find_stat(struct stat_sdb_t *sdb,	/* stat database */
@@ -1026,6 +1267,264 @@ stat_find_stat(struct stat_sdb_t *sdb,	/* stat database */
   return stat;
 }
 
+
+/* interval stats column, one per scalar stat */
+struct stat_column_t {
+  struct stat_stat_t *stat;	/* stat variable */
+  double last;			/* counter value at the end of the last row */
+  double value;			/* value over the current interval */
+  int valid;			/* VALUE could be computed? */
+  int row;			/* row VALUE was computed for (formulas) */
+};
+
+/* interval stats writer */
+struct stat_interval_t {
+  FILE *fd;			/* output stream */
+  int binary;			/* binary columnar output? */
+  int num;			/* number of columns */
+  struct stat_column_t *cols;	/* columns, in stat database order */
+  int *htab, hsize;		/* column name hash, column index + 1 */
+  int row;			/* current row number */
+  double *buf;			/* binary row buffer */
+};
+
+/* hash a stat name */
+static unsigned int
+name_hash(char *name)
+{
+  unsigned int h = 0;
+
+  while (*name)
+    h = (h << 5) + h + (unsigned char)*name++;
+  return h;
+}
+
+/* find the column of stat NAME, NULL if it is not a scalar stat */
+static struct stat_column_t *
+interval_find(struct stat_interval_t *si, char *name)
+{
+  unsigned int i = name_hash(name) & (si->hsize - 1);
+
+  for (; si->htab[i]; i = (i + 1) & (si->hsize - 1))
+    if (!strcmp(si->cols[si->htab[i]-1].stat->name, name))
+      return &si->cols[si->htab[i]-1];
+  return NULL;
+}
+
+/* current value of counter STAT */
+static double
+counter_value(struct stat_stat_t *stat)
+{
+  switch (stat->sc)
+    {
+    case sc_int:
+      return (double)*stat->variant.for_int.var;
+    case sc_uint:
+      return (double)*stat->variant.for_uint.var;
+#ifdef HOST_HAS_QWORD
+    case sc_qword:
+#ifdef _MSC_VER /* FIXME: MSC does not implement qword_t to dbl conversion */
+      return (double)(sqword_t)*stat->variant.for_qword.var;
+#else /* !_MSC_VER */
+      return (double)*stat->variant.for_qword.var;
+#endif /* _MSC_VER */
+    case sc_sqword:
+      return (double)*stat->variant.for_sqword.var;
+#endif /* HOST_HAS_QWORD */
+    case sc_float:
+      return (double)*stat->variant.for_float.var;
+    case sc_double:
+      return *stat->variant.for_double.var;
+    default:
+      panic("bogus stat class");
+    }
+}
+
+static void interval_eval_formula(struct stat_interval_t *si,
+				  struct stat_column_t *col);
+
+/* evaluate a stat as an expression over the current interval */
+static struct eval_value_t
+interval_eval_ident(struct eval_state_t *es)/* an expression evaluator */
+{
+  struct stat_interval_t *si = es->user_ptr;
+  struct stat_column_t *col;
+  static struct eval_value_t err_value = { et_int, { 0 } };
+  struct eval_value_t val;
+
+  col = interval_find(si, es->tok_buf);
+  if (!col)
+    {
+      /* not a scalar stat */
+      eval_error = ERR_UNDEFVAR;
+      return err_value;
+    }
+
+  if (col->stat->sc == sc_formula && col->row != si->row)
+    interval_eval_formula(si, col);
+  if (!col->valid)
+    {
+      /* pass on the error of a formula term */
+      eval_error = ERR_UNDEFVAR;
+      return err_value;
+    }
+
+  val.type = et_double;
+  val.value.as_double = col->value;
+  return val;
+}
+
+/* evaluate formula column COL over the current interval */
+static void
+interval_eval_formula(struct stat_interval_t *si, struct stat_column_t *col)
+{
+  /* instantiate a new evaluator to avoid recursion problems */
+  struct eval_state_t *es = eval_new(interval_eval_ident, si);
+  struct eval_value_t val;
+  char *endp;
+
+  /* mark the column first, a formula referencing itself is an error */
+  col->row = si->row;
+  col->valid = FALSE;
+
+  val = eval_expr(es, col->stat->variant.for_formula.formula, &endp);
+  if (eval_error == ERR_NOERR && *endp == '\0')
+    {
+      col->value = eval_as_double(val);
+      col->valid = TRUE;
+    }
+  eval_delete(es);
+}
+
+/* start writing interval stats for all the scalar stats registered in SDB,
+   the interval values are written to FD, in the binary format if BINARY */
+struct stat_interval_t *
+stat_interval_new(struct stat_sdb_t *sdb,/* stats database */
+		  FILE *fd,		/* output stream */
+		  int binary)		/* binary columnar output? */
+{
+  struct stat_interval_t *si;
+  struct stat_stat_t *stat;
+  int i;
+
+  si = (struct stat_interval_t *)calloc(1, sizeof(struct stat_interval_t));
+  if (!si)
+    fatal("out of virtual memory");
+  si->fd = fd;
+  si->binary = binary;
+
+  /* one column per scalar stat, distributions are left out */
+  for (stat = sdb->stats; stat != NULL; stat = stat->next)
+    if (stat->sc != sc_dist && stat->sc != sc_sdist)
+      si->num++;
+  si->cols = (struct stat_column_t *)
+    calloc(MAX(si->num, 1), sizeof(struct stat_column_t));
+  for (si->hsize = 64; si->hsize < 2 * si->num; si->hsize *= 2)
+    ;
+  si->htab = (int *)calloc(si->hsize, sizeof(int));
+  si->buf = (double *)calloc(si->num + 1, sizeof(double));
+  if (!si->cols || !si->htab || !si->buf)
+    fatal("out of virtual memory");
+
+  for (i = 0, stat = sdb->stats; stat != NULL; stat = stat->next)
+    {
+      unsigned int h;
+
+      if (stat->sc == sc_dist || stat->sc == sc_sdist)
+	continue;
+      si->cols[i].stat = stat;
+      if (stat->sc != sc_formula)
+	si->cols[i].last = counter_value(stat);
+      for (h = name_hash(stat->name) & (si->hsize - 1);
+	   si->htab[h];
+	   h = (h + 1) & (si->hsize - 1))
+	;
+      si->htab[h] = ++i;
+    }
+
+  /* header */
+  if (binary)
+    {
+      word_t hdr[2];
+
+      fwrite(STAT_IV_MAGIC, 1, 4, fd);
+      fputc(STAT_IV_VERSION, fd);
+      hdr[0] = STAT_IV_BYTE_ORDER;
+      hdr[1] = si->num;
+      fwrite(hdr, sizeof(word_t), 2, fd);
+      for (i = 0; i < si->num; i++)
+	fwrite(si->cols[i].stat->name, 1, strlen(si->cols[i].stat->name) + 1,
+	       fd);
+    }
+  else
+    {
+      fprintf(fd, "interval");
+      for (i = 0; i < si->num; i++)
+	fprintf(fd, ",%s", si->cols[i].stat->name);
+      fprintf(fd, "\n");
+    }
+
+  return si;
+}
+
+/* write the row for the interval ending now */
+void
+stat_interval_row(struct stat_interval_t *si)/* interval stats writer */
+{
+  struct stat_column_t *col;
+  int i;
+
+  si->row++;
+
+  /* counters first, formulas are evaluated over their changes */
+  for (i = 0, col = si->cols; i < si->num; i++, col++)
+    if (col->stat->sc != sc_formula)
+      {
+	double now = counter_value(col->stat);
+
+	col->value = now - col->last;
+	col->last = now;
+	col->valid = TRUE;
+	col->row = si->row;
+      }
+  for (i = 0, col = si->cols; i < si->num; i++, col++)
+    if (col->row != si->row)
+      interval_eval_formula(si, col);
+
+  if (si->binary)
+    {
+      word_t row = si->row;
+
+      fwrite(&row, sizeof(word_t), 1, si->fd);
+      for (i = 0, col = si->cols; i < si->num; i++, col++)
+	si->buf[i] = col->valid ? col->value : (0.0 / 0.0);
+      fwrite(si->buf, sizeof(double), si->num, si->fd);
+    }
+  else
+    {
+      fprintf(si->fd, "%d", si->row);
+      for (i = 0, col = si->cols; i < si->num; i++, col++)
+	{
+	  if (col->valid)
+	    fprintf(si->fd, ",%.12g", col->value);
+	  else
+	    fputc(',', si->fd);
+	}
+      fputc('\n', si->fd);
+    }
+}
+
+/* stop writing interval stats, FD is flushed but not closed */
+void
+stat_interval_delete(struct stat_interval_t *si)/* interval stats writer */
+{
+  fflush(si->fd);
+  free(si->cols);
+  free(si->htab);
+  free(si->buf);
+  free(si);
+}
+
 #ifdef TESTIT
 
 void
@@ -324,9 +324,54 @@ stat_print_stats(struct stat_sdb_t *sdb,/* stat database */
 		 FILE *fd);		/* output stream */
 
 
+/* print all stat variables in stat database SDB as a JSON object, one
+   member per stat; scalar stats are numbers (null if a formula cannot be
+   evaluated), distributions are objects holding their summary values and
+   `index' and `counts' arrays */
+void
+stat_print_stats_json(struct stat_sdb_t *sdb,/* stat database */
+		      FILE *fd);	/* output stream */
+
+/* print all stat variables in stat database SDB as CSV rows of the form
+   `stat,<name>,<index>,<value>', the index is empty for scalar stats and
+   distribution summary values (`<name>.total' etc.), and is the bucket index
+   for distribution counts */
+void
+stat_print_stats_csv(struct stat_sdb_t *sdb,/* stat database */
+		     FILE *fd);		/* output stream */
+
 /* find a stat variable, returns NULL if it is not found */
 struct stat_stat_t *
 stat_find_stat(struct stat_sdb_t *sdb,	/* stat database */
 	       char *stat_name);	/* stat name */
+
+/* interval statistics, every scalar stat (counter or formula) in a stats
+   database written as one row of per-interval values, counters as their
+   change over the interval and formulas evaluated over those changes; the
+   output is CSV text, or binary columnar: STAT_IV_MAGIC, a version byte, a
+   STAT_IV_BYTE_ORDER word, the column count word and the NUL-terminated
+   column names, then for each row the interval number word and one double
+   per column (NaN where a formula cannot be evaluated) */
+#define STAT_IV_MAGIC		"SSIV"
+#define STAT_IV_VERSION		1
+#define STAT_IV_BYTE_ORDER	0x01020304
+
+/* interval stats writer, opaque */
+struct stat_interval_t;
+
+/* start writing interval stats for all the scalar stats registered in SDB,
+   the interval values are written to FD, in the binary format if BINARY */
+struct stat_interval_t *
+stat_interval_new(struct stat_sdb_t *sdb,/* stats database */
+		  FILE *fd,		/* output stream */
+		  int binary);		/* binary columnar output? */
+
+/* write the row for the interval ending now */
+void
+stat_interval_row(struct stat_interval_t *si);/* interval stats writer */
+
+/* stop writing interval stats, FD is flushed but not closed */
+void
+stat_interval_delete(struct stat_interval_t *si);/* interval stats writer */
 	       
 #endif /* STAT_H */
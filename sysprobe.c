@@ -154,8 +154,9 @@ main(int argc, char **argv)
       fprintf(stdout, "-lbfd -liberty ");
 #endif /* BFD_LOADER */
 
-#ifdef linux
-      /* nada... */
+#if defined(linux) || defined(__FreeBSD__) || defined(__APPLE__)
+      /* POSIX threads, for the binary pipetrace writer */
+      fprintf(stdout, "-lpthread ");
 #elif defined(__USLC__) || (defined(__svr4__) && defined(__i386__) && defined(__unix__))
       fprintf(stdout, "-L/usr/ucblib -lucb ");
 #else
@@ -201,6 +202,10 @@ main(int argc, char **argv)
 	fprintf(stdout, "-D_ALL_SOURCE ");
 #endif /* _AIX */
 
+#if defined(linux) || defined(__FreeBSD__) || defined(__APPLE__)
+	fprintf(stdout, "-DHOST_HAS_PTHREADS ");
+#endif /* POSIX threads */
+
 #if (defined(hpux) || defined(__hpux)) && !defined(__GNUC__)
 	fprintf(stdout, "-D_INCLUDE_HPUX_SOURCE -D_INCLUDE_XOPEN_SOURCE -D_INCLUDE_AES_SOURCE ");
 #endif /* hpux */